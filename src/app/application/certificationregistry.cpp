@@ -0,0 +1,206 @@
+#include "certificationregistry.h"
+
+namespace {
+    int base62Digit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'Z') return c - 'A' + 36;
+        return -1;
+    }
+
+    const char kBase62Digits[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const size_t kCodeLength = 5;
+}
+
+CertificationRegistry::CertificationRegistry(int expiryMs, int tickMs)
+    : tick(tickMs > 0 ? tickMs : 1), origin(chrono::steady_clock::now()) {
+    if (expiryMs <= 0) {
+        expiryTicks = 0;
+        return;
+    }
+    // 만료까지의 tick 수만큼 칸이 있으면 휠을 한 바퀴 돌기 전에 모든 코드가 만료된다
+    expiryTicks = (uint32_t)((expiryMs + tick.count() - 1) / tick.count());
+    wheel.resize(expiryTicks + 1);
+}
+
+bool CertificationRegistry::add(const string &certCode, int itemSlot, int count) {
+    return add(certCode, itemSlot, count, chrono::steady_clock::now());
+}
+
+bool CertificationRegistry::add(const string &certCode, int itemSlot, int count, chrono::steady_clock::time_point now) {
+    return insert(certCode, itemSlot, count, tickOf(now) + expiryTicks);
+}
+
+bool CertificationRegistry::restore(const string &certCode, int itemSlot, int count, int64_t remainingMs) {
+    // 이미 처리한 tick에 넣으면 휠을 한 바퀴 돌 때까지 만료되지 않으므로 최소 1 tick 뒤로 잡는다
+    uint64_t remainingTicks = remainingMs > 0 ? (uint64_t)((remainingMs + tick.count() - 1) / tick.count()) : 1;
+    return insert(certCode, itemSlot, count, tickOf(chrono::steady_clock::now()) + remainingTicks);
+}
+
+bool CertificationRegistry::insert(const string &certCode, int itemSlot, int count, uint64_t expiryTick) {
+    Entry entry{expiryTick, count, (int16_t)itemSlot};
+    WheelKey key{0, string()};
+
+    lock_guard<mutex> lock(registryMutex);
+    if (pack(certCode, key.packed)) {
+        if (!packedCodes.emplace(key.packed, entry).second) {
+            return false;
+        }
+    } else {
+        if (!textCodes.emplace(certCode, entry).second) {
+            return false;
+        }
+        key.text = certCode;
+    }
+    if (expiryTicks > 0) {
+        wheel[expiryTick % wheel.size()].push_back(move(key));
+    }
+    return true;
+}
+
+bool CertificationRegistry::redeem(const string &certCode) {
+    lock_guard<mutex> lock(registryMutex);
+    Entry *entry;
+    uint32_t packed;
+    bool isPacked;
+    if (!find(certCode, entry, packed, isPacked)) {
+        return false;
+    }
+    erase(certCode, packed, isPacked);
+    return true;
+}
+
+bool CertificationRegistry::cancel(const string &certCode, Reservation &reservation) {
+    lock_guard<mutex> lock(registryMutex);
+    Entry *entry;
+    uint32_t packed;
+    bool isPacked;
+    if (!find(certCode, entry, packed, isPacked)) {
+        return false;
+    }
+    reservation = Reservation{entry->itemSlot, entry->count, certCode};
+    erase(certCode, packed, isPacked);
+    return true;
+}
+
+bool CertificationRegistry::contains(const string &certCode) const {
+    lock_guard<mutex> lock(registryMutex);
+    uint32_t packed;
+    if (pack(certCode, packed)) {
+        return packedCodes.count(packed) > 0;
+    }
+    return textCodes.count(certCode) > 0;
+}
+
+vector<CertificationRegistry::Reservation> CertificationRegistry::collectExpired() {
+    return collectExpired(chrono::steady_clock::now());
+}
+
+vector<CertificationRegistry::Reservation> CertificationRegistry::collectExpired(chrono::steady_clock::time_point now) {
+    vector<Reservation> expired;
+    if (expiryTicks == 0) {
+        return expired;
+    }
+
+    uint64_t currentTick = tickOf(now);
+    lock_guard<mutex> lock(registryMutex);
+    // 오래 호출되지 않았더라도 휠 한 바퀴만 보면 된다
+    if (currentTick > processedTick + wheel.size()) {
+        processedTick = currentTick - wheel.size();
+    }
+    for (; processedTick < currentTick; ++processedTick) {
+        uint64_t expiringTick = processedTick + 1;
+        vector<WheelKey> &bucket = wheel[expiringTick % wheel.size()];
+        size_t kept = 0;
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            WheelKey &key = bucket[i];
+            bool isPacked = key.text.empty();
+            Entry *entry = nullptr;
+            if (isPacked) {
+                auto it = packedCodes.find(key.packed);
+                entry = it != packedCodes.end() ? &it->second : nullptr;
+            } else {
+                auto it = textCodes.find(key.text);
+                entry = it != textCodes.end() ? &it->second : nullptr;
+            }
+            // 이미 수령한 코드의 키는 버리고, 한 바퀴 뒤에 만료될 코드의 키는 남긴다
+            if (!entry || entry->expiryTick % wheel.size() != expiringTick % wheel.size()) {
+                continue;
+            }
+            if (entry->expiryTick > expiringTick) {
+                if (kept != i) {
+                    bucket[kept] = move(key);
+                }
+                ++kept;
+                continue;
+            }
+            expired.push_back(Reservation{entry->itemSlot, entry->count, isPacked ? unpack(key.packed) : key.text});
+            if (isPacked) {
+                packedCodes.erase(key.packed);
+            } else {
+                textCodes.erase(key.text);
+            }
+        }
+        // 칸의 용량은 다음 바퀴에 다시 쓴다
+        bucket.resize(kept);
+    }
+    return expired;
+}
+
+size_t CertificationRegistry::size() const {
+    lock_guard<mutex> lock(registryMutex);
+    return packedCodes.size() + textCodes.size();
+}
+
+bool CertificationRegistry::pack(string_view certCode, uint32_t &packed) {
+    if (certCode.size() != kCodeLength) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (char c : certCode) {
+        int digit = base62Digit(c);
+        if (digit < 0) {
+            return false;
+        }
+        value = value * 62 + digit;
+    }
+    packed = value;
+    return true;
+}
+
+string CertificationRegistry::unpack(uint32_t packed) {
+    string code(kCodeLength, '0');
+    for (size_t i = kCodeLength; i-- > 0;) {
+        code[i] = kBase62Digits[packed % 62];
+        packed /= 62;
+    }
+    return code;
+}
+
+uint64_t CertificationRegistry::tickOf(chrono::steady_clock::time_point now) const {
+    if (now <= origin) {
+        return 0;
+    }
+    return (uint64_t)(chrono::duration_cast<chrono::milliseconds>(now - origin) / tick);
+}
+
+bool CertificationRegistry::find(const string &certCode, Entry *&entry, uint32_t &packed, bool &isPacked) {
+    isPacked = pack(certCode, packed);
+    if (isPacked) {
+        auto it = packedCodes.find(packed);
+        entry = it != packedCodes.end() ? &it->second : nullptr;
+    } else {
+        auto it = textCodes.find(certCode);
+        entry = it != textCodes.end() ? &it->second : nullptr;
+    }
+    return entry != nullptr;
+}
+
+void CertificationRegistry::erase(const string &certCode, uint32_t packed, bool isPacked) {
+    // 휠 칸의 키는 만료 처리 때 함께 정리된다
+    if (isPacked) {
+        packedCodes.erase(packed);
+    } else {
+        textCodes.erase(certCode);
+    }
+}
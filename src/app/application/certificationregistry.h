@@ -0,0 +1,109 @@
+#ifndef CERTIFICATIONREGISTRY_H
+#define CERTIFICATIONREGISTRY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+// 아직 수령하지 않은 선결제 인증코드와 그 코드가 잡아 둔 재고
+// 영문자와 숫자 5자리 코드는 62진수로 32비트 정수 하나에 담아 저장하고,
+// 그 밖의 형식은 문자열 그대로 따로 저장한다.
+// 만료는 tick 단위 타이머 휠로 처리하여 같은 tick에 만료되는 코드를 한 번에 꺼낸다.
+// 수령하거나 만료된 코드는 바로 지우고 그 노드와 휠 칸의 용량은 다시 쓰므로,
+// 메모리는 동시에 남아 있던 코드 수의 최댓값에 비례한다.
+class CertificationRegistry {
+public:
+    // 만료된 코드가 잡아 두었던 재고
+    struct Reservation {
+        int itemSlot;
+        int count;
+        string certCode;
+    };
+
+    // expiryMs가 0 이하이면 만료하지 않는다
+    CertificationRegistry(int expiryMs, int tickMs);
+
+    // 코드 등록. 같은 코드가 이미 남아 있으면 false
+    bool add(const string &certCode, int itemSlot, int count);
+    bool add(const string &certCode, int itemSlot, int count, chrono::steady_clock::time_point now);
+
+    // 복구한 코드를 남은 유효 기간(ms)과 함께 다시 등록한다 (0 이하이면 다음 만료 처리 때 만료)
+    bool restore(const string &certCode, int itemSlot, int count, int64_t remainingMs);
+
+    // 남아 있는 코드마다 visit(코드, 칸 번호, 수량, 남은 유효 기간 ms)를 호출한다
+    // (만료하지 않는 등록부이면 남은 기간은 -1)
+    template <typename Visit>
+    void forEach(Visit &&visit) const {
+        uint64_t currentTick = tickOf(chrono::steady_clock::now());
+        lock_guard<mutex> lock(registryMutex);
+        auto remaining = [&](const Entry &entry) -> int64_t {
+            if (expiryTicks == 0) {
+                return -1;
+            }
+            return entry.expiryTick > currentTick ? (int64_t)(entry.expiryTick - currentTick) * tick.count() : 0;
+        };
+        for (const auto &[packed, entry] : packedCodes) {
+            visit(unpack(packed), (int)entry.itemSlot, (int)entry.count, remaining(entry));
+        }
+        for (const auto &[code, entry] : textCodes) {
+            visit(code, (int)entry.itemSlot, (int)entry.count, remaining(entry));
+        }
+    }
+
+    // 코드 사용. 남아 있던 코드면 지우고 true
+    bool redeem(const string &certCode);
+
+    // 등록을 취소하고 잡아 두었던 재고를 돌려준다 (없으면 false)
+    bool cancel(const string &certCode, Reservation &reservation);
+
+    bool contains(const string &certCode) const;
+
+    // now까지 만료된 코드를 지우고 잡아 두었던 재고 목록을 반환
+    vector<Reservation> collectExpired();
+    vector<Reservation> collectExpired(chrono::steady_clock::time_point now);
+
+    size_t size() const;
+
+    // 5자리 62진수 코드 <-> 32비트 정수 (형식이 맞지 않으면 false)
+    static bool pack(string_view certCode, uint32_t &packed);
+    static string unpack(uint32_t packed);
+
+private:
+    struct Entry {
+        uint64_t expiryTick;
+        int32_t count;
+        int16_t itemSlot;
+    };
+    // 휠 칸에는 어느 저장소의 코드인지와 키를 기록한다
+    struct WheelKey {
+        uint32_t packed;
+        string text; // 62진수로 담을 수 없는 코드일 때만 사용
+    };
+
+    chrono::milliseconds tick;
+    uint64_t expiryTicks;
+    chrono::steady_clock::time_point origin;
+    uint64_t processedTick = 0;
+
+    mutable mutex registryMutex;
+    // 코드 노드를 지운 뒤 다시 쓰도록 모아 두어, 남은 코드 수가 비슷하게 유지되면 할당이 없다
+    // (registryMutex 안에서만 쓰므로 동기화하지 않는 풀을 쓴다)
+    pmr::unsynchronized_pool_resource nodePool;
+    pmr::unordered_map<uint32_t, Entry> packedCodes{&nodePool};
+    unordered_map<string, Entry> textCodes;
+    vector<vector<WheelKey>> wheel;
+
+    uint64_t tickOf(chrono::steady_clock::time_point now) const;
+    bool insert(const string &certCode, int itemSlot, int count, uint64_t expiryTick);
+    bool find(const string &certCode, Entry *&entry, uint32_t &packed, bool &isPacked);
+    void erase(const string &certCode, uint32_t packed, bool isPacked);
+};
+
+#endif // CERTIFICATIONREGISTRY_H
@@ -1,42 +1,360 @@
 ﻿#include "dvm.h"
+#include "saleidgenerator.h"
+#include "salesanalytics.h"
 #include <climits>
+#include <vector>
+#include <chrono>
+#include <poll.h>
+#include <random>
+#include <algorithm>
+#include <set>
+#include <cerrno>
+#include <sys/stat.h>
 
 DVM::DVM(int id, Location loc, map<Item, int> stockList, list<Item> itemList, list<Sale> saleList, list<OtherDVM> otherDvMs)
-    : dvmId(id), location(loc), stocks(stockList), items(itemList), sales(saleList), dvms(otherDvMs) { }
+    : dvmId(id), location(loc), stocks(stockList), items(itemList),
+      certCodes(Config::get().certCodeExpiryMs, Config::get().certExpiryTickMs), dvms(otherDvMs),
+      stockCache(Config::get().peerStockCacheTtlMs), fleet(id) {
+    // 이 DVM에서 만드는 판매 ID에 DVM ID를 넣는다
+    SaleIdGenerator::setNodeId(id);
+    for (const auto& [item, count] : stockList) {
+        fleet.setLocalStock(item.getItemCode(), count);
+    }
+
+    // 스냅샷이 있으면 그 상태에서, 없으면 생성자로 받은 상태에서 로그의 나머지를 다시 적용한다
+    uint64_t walOffset = 0;
+    if (!loadSnapshot(walOffset)) {
+        for (const auto& sale : saleList) {
+            sales.append(sale);
+        }
+    }
+    if (!Config::get().walPath.empty()) {
+        uint64_t walEnd = replayLog(walOffset);
+        wal = make_unique<WriteAheadLog>(Config::get().walPath, Config::get().walSync);
+        if (!wal->open(walEnd)) {
+            throw runtime_error("Failed to open write-ahead log: " + Config::get().walPath);
+        }
+    }
+    stocks.forEach([this](const Item& item, int) {
+        publishStockChange(item.getItemCode(), stocks.find(item.getItemCode()));
+    });
+}
 
 // Private methods
 void DVM::decreaseStock(const string& itemCode, int count) {
-    auto it = stocks.find(Item(itemCode, "", 0));
-    if (it == stocks.end() || it->second < count) {
+    int slot = stocks.find(itemCode);
+    if (slot < 0 || !stocks.tryTake(slot, count)) {
         throw runtime_error("Insufficient stock");
     }
-    stocks[it->first] -= count;
+    publishStockChange(itemCode, slot);
+}
+
+void DVM::publishStockChange(const string& itemCode, int slot) {
+    stocks.publish(slot, [&](int before, int after) {
+        notifyStockChange(itemCode, before, after);
+    });
+}
+
+void DVM::notifyStockChange(const string& itemCode, int before, int after) {
+    // 아이템마다의 알림 잠금 안이므로 모든 아이템이 함께 쓰는 잠금은 잡지 않는다.
+    // 가십할 자기 재고는 가십할 때 재고 표에서 다시 만들고, 구독자가 없는 아이템은 잠금 없이 지나간다
+    fleet.markLocalChanged();
+    vector<SubscriptionRegistry::Notification> notifications = subscriptions.collectChanges(itemCode, before, after);
+    if (notifications.empty()) {
+        return;
+    }
+
+    lock_guard<mutex> lock(notifierMutex);
+    if (!notifier) {
+        notifier = make_unique<WorkerPool>(1, Config::get().workerQueueCapacity);
+    }
+    for (const auto& notification : notifications) {
+        OtherDVM* subscriber = findDvmById(notification.subscriberId);
+        if (!subscriber) {
+            continue;
+        }
+        // 알림은 최선을 다해 보낸다. 놓친 알림은 구독자의 캐시가 만료되면 조회로 보완된다.
+        notifier->trySubmit([peer = *subscriber, notification, senderId = dvmId]() mutable {
+            peer.notifyStockChanged(notification.itemCode, notification.itemNum, notification.threshold, senderId);
+        });
+    }
+}
+
+uint64_t DVM::appendLog(const WalRecord& record) {
+    return wal ? wal->append(record) : 0;
+}
+
+void DVM::commitLog(uint64_t lsn) {
+    if (!wal || lsn == 0) {
+        return;
+    }
+    // 메모리의 상태는 이미 바뀌었으므로 기록에 실패해도 판매는 계속한다
+    if (!wal->commit(lsn)) {
+        cerr << "Failed to write log record to " << Config::get().walPath << endl;
+    }
+}
+
+bool DVM::loadSnapshot(uint64_t& walOffset) {
+    const string& path = Config::get().snapshotPath;
+    MappedSnapshot snapshot;
+    if (path.empty() || !snapshot.open(path)) {
+        return false;
+    }
+    const SnapshotFormat::Header& header = snapshot.header();
+
+    for (uint32_t i = 0; i < header.stockCount; ++i) {
+        const auto& entry = snapshot.stocks()[i];
+        int slot = stocks.find(SnapshotFormat::getText(entry.code));
+        if (slot >= 0) {
+            stocks.add(slot, entry.count - stocks.load(slot));
+        }
+    }
+
+    int64_t now = SaleIdGenerator::nowMs();
+    // 판매 ID -> 수령을 기다리는 인증코드 (판매 기록을 다시 색인할 때 쓴다)
+    unordered_map<uint64_t, string> pendingCodes;
+    for (uint32_t i = 0; i < header.certCount; ++i) {
+        const auto& entry = snapshot.certs()[i];
+        int slot = stocks.find(SnapshotFormat::getText(entry.itemCode));
+        int64_t remainingMs = entry.expiresAtMs != 0 ? entry.expiresAtMs - now : Config::get().certCodeExpiryMs;
+        string code = SnapshotFormat::getText(entry.code);
+        certCodes.restore(code, slot, entry.count, remainingMs);
+        if (entry.saleId != 0) {
+            pendingCodes.emplace(entry.saleId, move(code));
+        }
+    }
+
+    vector<Item> snapshotItems;
+    snapshotItems.reserve(header.itemCount);
+    for (uint32_t i = 0; i < header.itemCount; ++i) {
+        const auto& entry = snapshot.items()[i];
+        snapshotItems.emplace_back(SnapshotFormat::getText(entry.code), SnapshotFormat::getText(entry.name), entry.price);
+    }
+    for (uint64_t i = 0; i < header.saleCount; ++i) {
+        const auto& entry = snapshot.sales()[i];
+        if (entry.itemIndex < snapshotItems.size()) {
+            auto pending = pendingCodes.find(entry.saleId);
+            sales.restore(entry.saleId, entry.createdAtMs, snapshotItems[entry.itemIndex], entry.count, entry.amount,
+                          entry.flags, entry.sourceDvm, pending != pendingCodes.end() ? pending->second : string());
+        }
+    }
+
+    walOffset = header.walOffset;
+    return true;
 }
 
-Item DVM::findItem(const string& itemCode) const {
-    auto it = stocks.find(Item(itemCode, "", 0));
-    if (it == stocks.end()) {
+uint64_t DVM::replayLog(uint64_t walOffset) {
+    return WriteAheadLog::readAll(Config::get().walPath, [this](const WalRecord& record) {
+        applyLogRecord(record);
+    }, walOffset);
+}
+
+void DVM::applyLogRecord(const WalRecord& record) {
+    string certCode(record.certCode);
+    int slot = stocks.find(record.itemCode);
+    switch (record.type) {
+    case WalRecordType::Order:
+    case WalRecordType::PrepaidSaved:
+        if (slot < 0) {
+            return;
+        }
+        stocks.add(slot, -record.count);
+        sales.restore(record.saleId, record.createdAtMs, *stocks.item(slot), record.count, record.amount,
+                      record.type == WalRecordType::PrepaidSaved ? SalesLedger::FlagPrepaid : 0, record.sourceDvm,
+                      certCode);
+        if (record.type == WalRecordType::PrepaidSaved) {
+            int64_t remainingMs = record.createdAtMs + Config::get().certCodeExpiryMs - SaleIdGenerator::nowMs();
+            certCodes.restore(certCode, slot, record.count, remainingMs);
+        }
+        break;
+    case WalRecordType::PrepaidRedeemed:
+        certCodes.redeem(certCode);
+        sales.receivePrepaidItem(certCode);
+        break;
+    case WalRecordType::Restock:
+        if (slot >= 0) {
+            stocks.add(slot, record.count);
+        }
+        break;
+    case WalRecordType::CertExpired: {
+        CertificationRegistry::Reservation reservation;
+        if (certCodes.cancel(certCode, reservation) && stocks.item(reservation.itemSlot)) {
+            stocks.add(reservation.itemSlot, reservation.count);
+        }
+        sales.expirePrepaidItem(certCode);
+        break;
+    }
+    case WalRecordType::Segment:
+        // 파일의 시작 위치를 적은 기록으로, readAll이 건너뛴다
+        break;
+    }
+}
+
+bool DVM::writeSnapshot() {
+    const string& path = Config::get().snapshotPath;
+    if (path.empty()) {
+        return false;
+    }
+    lock_guard<mutex> writer(snapshotMutex);
+    SnapshotData data;
+    vector<size_t> saleLimits;
+    int64_t now = SaleIdGenerator::nowMs();
+    {
+        // 진행 중인 변경이 없는 시점을 잡는다. 판매 기록은 추가만 되므로 여기서는 기록 수만 센다
+        unique_lock<shared_mutex> state(stateMutex);
+        data.walOffset = wal ? wal->getAppendedBytes() : 0;
+        stocks.forEach([&data](const Item& item, int count) {
+            SnapshotFormat::StockEntry entry{};
+            SnapshotFormat::setText(entry.code, item.getItemCode());
+            entry.count = count;
+            data.stocks.push_back(entry);
+        });
+        unordered_map<string, uint64_t> pendingSales;
+        sales.forEachPending([&pendingSales](const string& code, uint64_t saleId) {
+            pendingSales.emplace(code, saleId);
+        });
+        certCodes.forEach([&](const string& code, int slot, int count, int64_t remainingMs) {
+            const Item* item = stocks.item(slot);
+            SnapshotFormat::CertEntry entry{};
+            SnapshotFormat::setText(entry.code, code);
+            SnapshotFormat::setText(entry.itemCode, item ? item->getItemCode() : string());
+            entry.count = count;
+            entry.expiresAtMs = remainingMs < 0 ? 0 : now + remainingMs;
+            auto pending = pendingSales.find(code);
+            entry.saleId = pending != pendingSales.end() ? pending->second : 0;
+            data.certs.push_back(entry);
+        });
+        saleLimits = sales.shardSizes();
+    }
+
+    // 잠금을 놓은 뒤 판매 기록과 파일 쓰기를 처리하므로 판매는 기다리지 않는다
+    map<string, uint32_t> itemIndexes;
+    sales.forEach([&](const SalesLedger::Record& record) {
+        auto [found, inserted] = itemIndexes.emplace(record.item->getItemCode(), (uint32_t)data.items.size());
+        if (inserted) {
+            SnapshotFormat::ItemEntry item{};
+            SnapshotFormat::setText(item.code, record.item->getItemCode());
+            SnapshotFormat::setText(item.name, record.item->getName());
+            item.price = record.item->getPrice();
+            data.items.push_back(item);
+        }
+        SnapshotFormat::SaleEntry entry{};
+        entry.saleId = record.saleId;
+        entry.createdAtMs = record.createdAtMs;
+        entry.count = record.count;
+        entry.amount = record.totalAmount;
+        entry.itemIndex = found->second;
+        entry.flags = record.flags;
+        entry.sourceDvm = (uint16_t)record.sourceDvm;
+        data.sales.push_back(entry);
+    }, saleLimits);
+    data.createdAtMs = now;
+    if (!MappedSnapshot::write(path, data)) {
+        return false;
+    }
+    // 스냅샷이 디스크에 남았으므로 그 앞의 로그는 복구에 필요 없다
+    if (wal) {
+        wal->discardBefore(data.walOffset);
+    }
+    return true;
+}
+
+int DVM::exportSalesHistory(const string& directory) {
+    lock_guard<mutex> exporter(historyMutex);
+    // 판매 기록은 추가만 되므로 조각별 기록 수까지가 일관된 시점이다
+    vector<size_t> saleLimits = sales.shardSizes();
+    // 새 판매가 있는 날과, 내보낸 뒤 수령/만료 표시가 바뀐 날을 다시 쓴다
+    set<int64_t> days;
+    {
+        lock_guard<mutex> lock(settledDaysMutex);
+        days.swap(settledDays);
+    }
+    set<int64_t> settled = days;
+    sales.forEach([&days](const SalesLedger::Record& record) {
+        days.insert(SalesSegment::dayStart(record.createdAtMs));
+    }, saleLimits, exportedSaleLimits);
+    if (days.empty()) {
+        return 0;
+    }
+
+    // 다시 쓸 날의 판매를 모두 모은다 (수령 표시는 모으는 시점의 값이 남는다)
+    map<int64_t, SalesSegmentData> segments;
+    map<int64_t, map<string, uint16_t>> itemIndexes;
+    sales.forEach([&](const SalesLedger::Record& record) {
+        int64_t day = SalesSegment::dayStart(record.createdAtMs);
+        if (days.count(day) == 0) {
+            return;
+        }
+        SalesSegmentData& segment = segments[day];
+        auto [found, inserted] =
+            itemIndexes[day].emplace(record.item->getItemCode(), (uint16_t)segment.items.size());
+        if (inserted) {
+            SnapshotFormat::ItemEntry item{};
+            SnapshotFormat::setText(item.code, record.item->getItemCode());
+            SnapshotFormat::setText(item.name, record.item->getName());
+            item.price = record.item->getPrice();
+            segment.items.push_back(item);
+        }
+        segment.saleIds.push_back(record.saleId);
+        segment.timestamps.push_back(record.createdAtMs);
+        segment.itemIndexes.push_back(found->second);
+        segment.counts.push_back(record.count);
+        segment.amounts.push_back(record.totalAmount);
+        segment.flags.push_back(record.flags);
+        segment.sourceDvms.push_back((uint16_t)record.sourceDvm);
+    }, saleLimits);
+
+    bool ok = mkdir(directory.c_str(), 0755) == 0 || errno == EEXIST;
+    for (auto& [day, segment] : segments) {
+        if (!ok) {
+            break;
+        }
+        segment.dayStartMs = day;
+        segment.sortByTime();
+        ok = SalesSegment::write(directory + "/" + SalesSegment::fileName(day), segment);
+    }
+    if (!ok) {
+        // 다음 내보내기에서 다시 쓰도록 가져온 날을 되돌린다
+        lock_guard<mutex> lock(settledDaysMutex);
+        settledDays.insert(settled.begin(), settled.end());
+        return -1;
+    }
+    exportedSaleLimits = saleLimits;
+    return (int)segments.size();
+}
+
+void DVM::markSettledDay(int64_t createdAtMs) {
+    lock_guard<mutex> lock(settledDaysMutex);
+    settledDays.insert(SalesSegment::dayStart(createdAtMs));
+}
+
+SalesStats DVM::querySales(const SalesQuery& query) const {
+    return SalesAnalytics::query(sales, query, Config::get().statsThreads);
+}
+
+const Item& DVM::findItem(const string& itemCode) const {
+    const Item* item = stocks.item(stocks.find(itemCode));
+    if (!item) {
         throw runtime_error("Item not found");
     }
-    return it->first;
+    return *item;
 }
 
 string DVM::queryItems() {
     ostringstream oss;
     for (const auto& [code, name] : ItemDictionary::get()) {
-        Item item(code, name, 0);
-        auto it = stocks.find(item);
-        if (it != stocks.end()) {
-            oss << it->first.printItem() << "\n";
+        const Item* stocked = stocks.item(stocks.find(code));
+        if (stocked) {
+            oss << stocked->printItem() << "\n";
         } else {
-            oss << item.printItem() << "\n";
+            oss << Item(code, name, 0).printItem() << "\n";
         }
     }
     return oss.str();
 }
 
 string DVM::buildThisResponse(const string& itemCode, int count) {
-    Item item = findItem(itemCode);
+    const Item& item = findItem(itemCode);
     int totalPrice = item.calculatePrice(count);
     ostringstream oss;
     oss << "flag:this;"
@@ -62,32 +380,124 @@ string DVM::buildOtherResponse(const string& itemCode, int count, OtherDVM* near
     return oss.str();
 }
 
+// 캐시나 가십 재고 표로 답할 수 있는 DVM은 먼저 판단하고, 나머지 DVM에만 재고 조회를 동시에 보내
+// 하나의 마감 시간 안에서 응답을 모은다.
+// 전체 소요 시간은 가장 느린 피어가 아니라 마감 시간으로 제한된다.
 OtherDVM* DVM::findNearestDvmWithStock(const string& itemCode, int count) {
+    struct PendingQuery {
+        OtherDVM* dvm;
+        int distance;
+        int order;
+        OtherDVM::StockQuery query;
+    };
+
     OtherDVM* nearestDvm = nullptr;
-    int shortestDistance = INT_MAX;
+    pair<int, int> best{INT_MAX, INT_MAX}; // (거리, 목록 순서) - 거리가 같으면 목록의 앞쪽 DVM 우선
 
+    vector<PendingQuery> pending;
+    pending.reserve(dvms.size());
+    int order = 0;
     for (auto& dvm : dvms) {
-        CheckStockRequest request{.item_code = itemCode, .item_num = count};
-        CheckStockResponse response = dvm.findAvailableStocks(request, dvmId);
-        
-        if (response.item_num <= 0) {
+        PendingQuery entry{&dvm, location.calculateDistance(dvm.getLocation()), order++, {}};
+        PeerStockCache::Lookup cached = stockCache.lookup(dvm.getDvmId(), itemCode, count);
+        if (cached == PeerStockCache::Lookup::Miss) {
+            cached = fleet.lookup(dvm.getDvmId(), itemCode, count, Config::get().gossipMaxAgeMs);
+        }
+        if (cached == PeerStockCache::Lookup::Available) {
+            if (make_pair(entry.distance, entry.order) < best) {
+                best = make_pair(entry.distance, entry.order);
+                nearestDvm = &dvm;
+            }
+        } else if (cached == PeerStockCache::Lookup::Miss) {
+            pending.push_back(move(entry));
+        }
+    }
+
+    // 캐시에서 찾은 후보보다 가까운 DVM에만 묻는다
+    CheckStockRequest request{.item_code = itemCode, .item_num = count};
+    size_t started = 0;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        PendingQuery& entry = pending[i];
+        if (make_pair(entry.distance, entry.order) < best &&
+            entry.dvm->beginStockQuery(request, dvmId, entry.query)) {
+            if (started != i) {
+                pending[started] = move(entry);
+            }
+            ++started;
+        }
+    }
+    pending.resize(started);
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(Config::get().peerQueryDeadlineMs);
+    vector<pollfd> fds;
+
+    while (!pending.empty()) {
+        // 아직 응답하지 않은 DVM이 모두 현재 후보보다 멀다면 더 기다릴 필요가 없다
+        bool closerPending = false;
+        for (const auto& entry : pending) {
+            if (make_pair(entry.distance, entry.order) < best) {
+                closerPending = true;
+                break;
+            }
+        }
+        if (!closerPending) {
+            break;
+        }
+
+        auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            break;
+        }
+
+        fds.clear();
+        for (const auto& entry : pending) {
+            fds.push_back({entry.query.sock, entry.dvm->stockQueryEvents(entry.query), 0});
+        }
+        int ready = poll(fds.data(), fds.size(), (int)remaining);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
             continue;
         }
-        
-        int distance = location.calculateDistance(dvm.getLocation());
-        if (distance < shortestDistance) {
-            shortestDistance = distance;
-            nearestDvm = &dvm;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            PendingQuery& entry = pending[i];
+            OtherDVM::QueryProgress progress = OtherDVM::QueryProgress::Pending;
+            if (fds[i].revents != 0) {
+                CheckStockResponse response;
+                progress = entry.dvm->advanceStockQuery(entry.query, fds[i].revents, response);
+                if (progress == OtherDVM::QueryProgress::Done) {
+                    stockCache.record(entry.dvm->getDvmId(), itemCode, count, response.item_num > 0);
+                }
+                if (progress == OtherDVM::QueryProgress::Done && response.item_num > 0 &&
+                    make_pair(entry.distance, entry.order) < best) {
+                    best = make_pair(entry.distance, entry.order);
+                    nearestDvm = entry.dvm;
+                }
+            }
+            if (progress == OtherDVM::QueryProgress::Pending) {
+                if (kept != i) {
+                    pending[kept] = move(entry);
+                }
+                ++kept;
+            }
         }
+        pending.resize(kept);
     }
-    
+
+    // 마감 시간까지 응답하지 않은 조회는 취소하여 늦은 응답이 다음 요청과 섞이지 않게 한다
+    for (auto& entry : pending) {
+        entry.dvm->cancelStockQuery(entry.query);
+    }
+
     return nearestDvm;
 }
 
 string DVM::queryStocks(string itemCode, int count) {
-    auto it = stocks.find(Item(itemCode, "", 0));
+    int slot = stocks.find(itemCode);
     
-    if (it != stocks.end() && it->second >= count) {
+    if (slot >= 0 && stocks.load(slot) >= count) {
         return buildThisResponse(itemCode, count);
     }
     
@@ -95,12 +505,33 @@ string DVM::queryStocks(string itemCode, int count) {
     return buildOtherResponse(itemCode, count, nearestDvm);
 }
 
-void DVM::requestOrder(SaleRequest request) {
-    Item item = findItem(request.itemCode);
-    request.item = item;
-    decreaseStock(request.itemCode, request.itemNum);
-    Sale sale = Sale::createStandaloneSale(request);
-    sales.push_back(sale);
+LocalStockEvaluation DVM::evaluateLocalStock(const string& itemCode, int count) const {
+    int slot = stocks.find(itemCode);
+    int onHand = slot >= 0 ? stocks.load(slot) : 0;
+    return LocalStockEvaluation{itemCode, count, onHand, slot >= 0 && onHand >= count};
+}
+
+vector<CheckStockRequest> DVM::checkLocalStocks(const vector<CheckStockRequest>& requests) const {
+    vector<CheckStockRequest> result;
+    result.reserve(requests.size());
+    for (const auto& request : requests) {
+        bool sufficient = evaluateLocalStock(request.item_code, request.item_num).sufficient;
+        result.push_back(CheckStockRequest{request.item_code, sufficient ? request.item_num : 0});
+    }
+    return result;
+}
+
+void DVM::requestOrder(const SaleRequest& request) {
+    const Item& item = findItem(request.itemCode);
+    uint64_t lsn;
+    {
+        shared_lock<shared_mutex> state(stateMutex);
+        decreaseStock(request.itemCode, request.itemNum);
+        SalesLedger::Record sale = sales.record(item, request.itemNum, 0, dvmId);
+        lsn = appendLog(WalRecord::order(sale.saleId, sale.createdAtMs, request.itemCode, sale.count,
+                                         sale.totalAmount, dvmId));
+    }
+    commitLog(lsn);
 }
 
 OtherDVM* DVM::findDvmById(int targetDvmId) {
@@ -118,47 +549,238 @@ pair<Location, string> DVM::requestOrder(int targetDvmId, SaleRequest request) {
         throw DVMNotFoundException(targetDvmId);
     }
     
-    auto [sale, certcode] = Sale::createSaleForDvm(request, targetDvmId);
-    askPrepaymentRequest askRequest{
-        .item_code = request.itemCode,
-        .item_num = request.itemNum,
-        .cert_code = certcode
-    };
-    askPrepaymentResponse response = targetDvm->askForPrepayment(askRequest, dvmId);
-    if (!response.availability) {
-        throw runtime_error("Prepayment not available");
+    // 상대 DVM에 같은 코드가 남아 있어 거절되면 새 코드로 다시 요청한다
+    for (int attempt = 0; attempt < kCertCodeAttempts; ++attempt) {
+        auto [sale, certcode] = Sale::createSaleForDvm(request, targetDvmId);
+        askPrepaymentRequest askRequest{
+            .item_code = request.itemCode,
+            .item_num = request.itemNum,
+            .cert_code = certcode
+        };
+        askPrepaymentResponse response = targetDvm->askForPrepayment(askRequest, dvmId);
+        // 상대 DVM의 재고가 바뀌었으므로 캐시된 조회 결과를 버린다
+        stockCache.invalidate(targetDvmId, request.itemCode);
+        if (response.availability) {
+            return make_pair(targetDvm->getLocation(), certcode);
+        }
+        if (!response.duplicate_code) {
+            break;
+        }
     }
-    return make_pair(targetDvm->getLocation(), certcode);
+    throw runtime_error("Prepayment not available");
 }
 
-void DVM::saveSaleFromOther(string itemCode, int itemNum, string certCode) {
-    Item item = findItem(itemCode);
-    decreaseStock(itemCode, itemNum);
-    SaleRequest request{
-        .itemCode = itemCode,
-        .itemNum = itemNum,
-        .item = item
-    };
-    
-    Sale sale = Sale::createSaleUsingCertCode(request, certCode);
-    sales.push_back(sale);
+void DVM::saveSaleFromOther(const string& itemCode, int itemNum, const string& certCode, int sourceDvmId) {
+    const Item& item = findItem(itemCode);
+    uint64_t lsn;
+    {
+        shared_lock<shared_mutex> state(stateMutex);
+        // 코드를 먼저 등록하여 같은 코드로 재고가 두 번 빠지지 않게 한다
+        if (!certCodes.add(certCode, stocks.find(itemCode), itemNum)) {
+            throw DuplicateCertCodeException(certCode);
+        }
+        try {
+            decreaseStock(itemCode, itemNum);
+        } catch (const runtime_error&) {
+            CertificationRegistry::Reservation reservation;
+            certCodes.cancel(certCode, reservation);
+            throw;
+        }
+        // 잡아 둔 재고는 certCodes에서, 수령과 만료 여부는 판매 기록에서 관리한다
+        SalesLedger::Record sale = sales.recordPrepaid(item, itemNum, certCode, sourceDvmId);
+        lsn = appendLog(WalRecord::prepaidSaved(sale.saleId, sale.createdAtMs, itemCode, sale.count,
+                                                sale.totalAmount, certCode, sourceDvmId));
+    }
+    commitLog(lsn);
+}
+
+void DVM::restock(const string& itemCode, int count) {
+    if (count <= 0) {
+        return;
+    }
+    int slot = stocks.find(itemCode);
+    if (slot < 0) {
+        throw runtime_error("Item not found");
+    }
+    uint64_t lsn;
+    {
+        shared_lock<shared_mutex> state(stateMutex);
+        stocks.add(slot, count);
+        publishStockChange(itemCode, slot);
+        lsn = appendLog(WalRecord::restock(itemCode, count));
+    }
+    commitLog(lsn);
+}
+
+vector<CheckStockRequest> DVM::acceptSubscription(int subscriberId, const vector<CheckStockRequest>& thresholds, int leaseMs) {
+    vector<CheckStockRequest> current;
+    if (!findDvmById(subscriberId)) {
+        return current;
+    }
+    current.reserve(thresholds.size());
+    for (const auto& request : thresholds) {
+        subscriptions.subscribe(subscriberId, request.item_code, request.item_num, leaseMs);
+        int slot = stocks.find(request.item_code);
+        current.push_back(CheckStockRequest{request.item_code, slot >= 0 ? stocks.load(slot) : 0});
+    }
+    return current;
 }
 
-bool DVM::processPrepaidItem(string certCode) {
-    for (auto& sale : sales) {
-        if (sale.receivePrepaidItem(certCode)) {
-            return true;
+int DVM::subscribeToPeers() {
+    int threshold = Config::get().peerSubscriptionThreshold;
+    int leaseMs = Config::get().peerSubscriptionLeaseMs;
+    if (leaseMs <= 0) {
+        return 0;
+    }
+
+    vector<CheckStockRequest> thresholds;
+    thresholds.reserve(ItemDictionary::get().size());
+    for (const auto& [code, name] : ItemDictionary::get()) {
+        thresholds.push_back(CheckStockRequest{code, threshold});
+    }
+
+    int accepted = 0;
+    for (auto& dvm : dvms) {
+        vector<CheckStockRequest> current = dvm.subscribeStocks(thresholds, leaseMs, dvmId);
+        if (current.empty()) {
+            continue;
+        }
+        ++accepted;
+        for (const auto& stock : current) {
+            stockCache.recordBand(dvm.getDvmId(), stock.item_code, stock.item_num, threshold, leaseMs);
+        }
+    }
+    return accepted;
+}
+
+void DVM::applyStockChange(int peerId, const string& itemCode, int itemNum, int threshold) {
+    stockCache.recordBand(peerId, itemCode, itemNum, threshold, Config::get().peerSubscriptionLeaseMs);
+}
+
+int DVM::gossipRound() {
+    int fanout = Config::get().gossipFanout;
+    if (fanout <= 0 || dvms.empty()) {
+        return 0;
+    }
+
+    // 목록에서 무작위로 fanout대를 고른다
+    static thread_local mt19937 random(random_device{}());
+    vector<OtherDVM*> targets;
+    targets.reserve(dvms.size());
+    for (auto& dvm : dvms) {
+        targets.push_back(&dvm);
+    }
+    shuffle(targets.begin(), targets.end(), random);
+    if (targets.size() > (size_t)fanout) {
+        targets.resize(fanout);
+    }
+
+    refreshFleetEntry();
+    int answered = 0;
+    for (OtherDVM* target : targets) {
+        vector<InventoryEntry> newer;
+        if (target->exchangeGossip(fleet.digest(), fleet.localEntry(), dvmId, newer)) {
+            fleet.merge(newer);
+            ++answered;
         }
     }
-    return false;
+    return answered;
+}
+
+vector<InventoryEntry> DVM::acceptGossip(int senderId, const map<int, uint64_t>& digest, const vector<InventoryEntry>& entries) {
+    fleet.merge(entries);
+    refreshFleetEntry();
+    return fleet.newerThan(digest, senderId, Config::get().gossipMaxEntries);
+}
+
+void DVM::refreshFleetEntry() {
+    fleet.refreshLocal([this](map<string, int>& current) {
+        stocks.forEach([&current](const Item& item, int count) {
+            current[item.getItemCode()] = count;
+        });
+    });
+}
+
+int DVM::expireCertCodes() {
+    vector<CertificationRegistry::Reservation> expired;
+    uint64_t lsn = 0;
+    {
+        shared_lock<shared_mutex> state(stateMutex);
+        expired = certCodes.collectExpired();
+        for (const auto& reservation : expired) {
+            const Item* item = stocks.item(reservation.itemSlot);
+            if (!item) {
+                continue;
+            }
+            // 목록에 잡아 둔 판매는 목록에서 수령한 코드만 판매 기록으로 수령되므로 (receiveUnreservedPrepaidItem),
+            // 목록에서 꺼낸 코드의 판매 기록은 아직 수령 전이거나 없다. 어느 쪽이든 재고를 돌린다
+            int64_t createdAtMs;
+            if (sales.expirePrepaidItem(reservation.certCode, &createdAtMs)) {
+                markSettledDay(createdAtMs);
+            }
+            stocks.add(reservation.itemSlot, reservation.count);
+            publishStockChange(item->getItemCode(), reservation.itemSlot);
+            lsn = appendLog(WalRecord::certExpired(reservation.certCode));
+        }
+    }
+    commitLog(lsn);
+    return (int)expired.size();
+}
+
+bool DVM::processPrepaidItem(const string& certCode) {
+    expireCertCodes();
+    uint64_t lsn;
+    {
+        shared_lock<shared_mutex> state(stateMutex);
+        // 인증코드 목록에 있는 코드는 목록이 수령과 만료 중 하나만 정하고, 판매 기록에는 결과만 표시한다.
+        // 목록에 등록된 적이 없는 (생성자로 받은 판매 기록의) 선결제만 판매 기록으로 수령한다.
+        // 만료가 목록에서 꺼낸 코드를 판매 기록으로 수령하면 재고가 돌아간 아이템을 한 번 더 내주게 된다.
+        bool redeemed = certCodes.redeem(certCode);
+        int64_t createdAtMs;
+        bool received = redeemed ? sales.receivePrepaidItem(certCode, &createdAtMs)
+                                 : sales.receiveUnreservedPrepaidItem(certCode, &createdAtMs);
+        if (!received && !redeemed) {
+            return false;
+        }
+        if (received) {
+            markSettledDay(createdAtMs);
+        }
+        lsn = appendLog(WalRecord::prepaidRedeemed(certCode));
+    }
+    commitLog(lsn);
+    return true;
 }
 
 Location DVM::getLocation() const{
     return location;
 }
-const map<Item, int>& DVM::getStocks() const{
-    return stocks;
+map<Item, int> DVM::getStocks() const{
+    map<Item, int> snapshot;
+    stocks.forEach([&snapshot](const Item& item, int count) {
+        snapshot.emplace(item, count);
+    });
+    return snapshot;
 }
 const int DVM::getDvmId() const{
     return dvmId;
 }
+
+size_t DVM::getSaleCount() const {
+    return sales.size();
+}
+
+PeerStockCache& DVM::getStockCache() {
+    return stockCache;
+}
+
+SubscriptionRegistry& DVM::getSubscriptions() {
+    return subscriptions;
+}
+
+CertificationRegistry& DVM::getCertCodes() {
+    return certCodes;
+}
+
+FleetInventory& DVM::getFleetInventory() {
+    return fleet;
+}
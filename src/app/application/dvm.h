@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 #include <iostream>
 #include <sstream>
 #include "sale.h"
@@ -12,25 +13,87 @@
 #include "sale.h"
 #include "../dto.h"
 #include "../exception/dvmexception.h"
+#include "../storage/writeaheadlog.h"
+#include "../storage/snapshot.h"
+#include "../storage/salessegment.h"
 #include "otherdvm.h"
+#include "peerstockcache.h"
+#include "subscriptionregistry.h"
+#include "fleetinventory.h"
+#include "stocktable.h"
+#include "salesledger.h"
+#include "certificationregistry.h"
+#include "../network/workerpool.h"
+#include <memory>
+#include <shared_mutex>
+#include <mutex>
+#include <set>
 
 using namespace std; // std namespace 사용 선언
 
 class DVM {
 private:
+    // 인증코드 중복으로 거절된 선결제 요청을 새 코드로 다시 보내는 최대 횟수
+    static constexpr int kCertCodeAttempts = 3;
+
     int dvmId;
     Location location;
-    map<Item, int> stocks;
+    // 아이템 구성은 생성 후 바뀌지 않고 수량만 아이템 코드로 찾아 잠금 없이 바꾼다
+    StockTable stocks;
     list<Item> items;
-    list<Sale> sales;
+    SalesLedger sales;
+    // 재고와 판매 변경을 디스크에 남기는 로그 (Config::walPath가 비어 있으면 없음)
+    unique_ptr<WriteAheadLog> wal;
+    // 재고, 인증코드, 판매를 바꾸고 로그에 붙이는 작업은 공유 잠금으로, 스냅샷 시점을 잡을 때는
+    // 배타 잠금으로 잡아 스냅샷과 로그 위치가 같은 시점을 가리키게 한다
+    shared_mutex stateMutex;
+    mutex snapshotMutex;
+    // 판매 이력 내보내기를 한 번에 하나만 하고, 지난번에 내보낸 조각별 기록 수를 기억한다
+    mutex historyMutex;
+    vector<size_t> exportedSaleLimits;
+    // 내보낸 뒤 선결제가 수령되거나 만료되어 다시 써야 하는 날 (판매가 기다리지 않도록 따로 잠근다)
+    mutex settledDaysMutex;
+    set<int64_t> settledDays;
+    // 다른 DVM에서 선결제되어 수령을 기다리는 인증코드와 잡아 둔 재고
+    CertificationRegistry certCodes;
     list<OtherDVM> dvms;
+    // 다른 DVM의 재고 조회 결과 캐시
+    PeerStockCache stockCache;
+    // 이 DVM의 재고 변화를 구독한 다른 DVM
+    SubscriptionRegistry subscriptions;
+    // 가십으로 모은 전체 DVM 재고 표
+    FleetInventory fleet;
+    // 구독자에게 보낼 알림을 판매 흐름과 분리하여 보내는 스레드 (첫 구독 때 생성)
+    // 소멸 시 남은 알림을 먼저 보내도록 마지막 멤버로 둔다
+    mutex notifierMutex;
+    unique_ptr<WorkerPool> notifier;
 
     // 아이템 코드로 재고에서 아이템을 찾는 메서드
-    Item findItem(const string& itemCode) const;
+    // 재고 표에 있는 아이템을 복사하지 않고 가리킨다 (없으면 runtime_error)
+    const Item& findItem(const string& itemCode) const;
     
     // 재고를 감소시키는 메서드
     void decreaseStock(const string& itemCode, int count);
     
+    // 재고 수량이 바뀐 뒤 가십용 재고 표를 갱신하고 구간이 바뀐 구독자에게 비동기로 알린다
+    void publishStockChange(const string& itemCode, int slot);
+    void notifyStockChange(const string& itemCode, int before, int after);
+
+    // 로그가 켜져 있으면 기록을 붙이고 번호를 반환 (stateMutex의 공유 잠금 안에서 호출)
+    uint64_t appendLog(const WalRecord& record);
+    // 붙인 기록이 디스크에 기록될 때까지 기다린다 (잠금 밖에서 호출하여 group commit을 나눠 쓴다)
+    void commitLog(uint64_t lsn);
+
+    // 스냅샷을 읽어 상태를 되살린다. 읽었으면 스냅샷 이후 로그를 읽을 위치를 채우고 true
+    bool loadSnapshot(uint64_t& walOffset);
+    // 로그의 walOffset 이후 기록을 상태에 다시 적용하고, 온전한 기록이 끝나는 위치를 반환한다
+    uint64_t replayLog(uint64_t walOffset);
+    void applyLogRecord(const WalRecord& record);
+    // createdAtMs에 만든 판매의 선결제가 수령되거나 만료되었음을 다음 이력 내보내기에 알린다
+    void markSettledDay(int64_t createdAtMs);
+    // 마지막 가십 뒤 재고가 바뀌었으면 가십할 자기 항목을 재고 표에서 다시 만든다
+    void refreshFleetEntry();
+    
     // 응답 메시지 생성 헬퍼 메서드들
     string buildThisResponse(const string& itemCode, int count);
     string buildOtherResponse(const string& itemCode, int count, OtherDVM* nearestDvm);
@@ -48,23 +111,74 @@ public:
     
     // 특정 아이템의 재고를 조회
     string queryStocks(string itemCode, int count);
+
+    // 이 DVM의 재고만으로 count개를 줄 수 있는지 확인 (네트워크를 쓰지 않는다)
+    // 다른 DVM의 요청에 답할 때는 queryStocks 대신 이것을 써서 조회가 다시 퍼지지 않게 한다.
+    LocalStockEvaluation evaluateLocalStock(const string& itemCode, int count) const;
+
+    // 여러 아이템의 재고를 이 DVM의 재고만으로 한 번에 확인
+    // 요청 수량을 모두 줄 수 있으면 요청 수량, 아니면 0 (다른 DVM에는 묻지 않는다)
+    vector<CheckStockRequest> checkLocalStocks(const vector<CheckStockRequest>& requests) const;
     
     // 주문 요청
-    void requestOrder(SaleRequest request);
+    // 판매 기록 묶음이 찬 경우를 빼면 힙 할당 없이 처리한다
+    void requestOrder(const SaleRequest& request);
     
     // 특정 자판기에 주문 요청
     pair<Location, string> requestOrder(int targetDvmId, SaleRequest request);
     
     // 다른 자판기로부터의 판매 정보 저장
-    void saveSaleFromOther(string itemCode, int itemNum, string certCode);
+    // sourceDvmId는 선결제를 받은 DVM으로, 판매 기록의 출처로 남는다
+    void saveSaleFromOther(const string& itemCode, int itemNum, const string& certCode, int sourceDvmId = 0);
+    
+    // 재고 보충 (구독자에게 변화를 알린다)
+    void restock(const string& itemCode, int count);
+
+    // 다른 DVM의 구독 요청 수락. thresholds의 item_num은 아이템별 threshold
+    // 알려진 DVM이 아니면 빈 목록, 수락하면 아이템별 현재 재고 수량을 돌려준다.
+    vector<CheckStockRequest> acceptSubscription(int subscriberId, const vector<CheckStockRequest>& thresholds, int leaseMs);
+
+    // 모든 다른 DVM에 모든 아이템의 재고 변화를 구독하고 받은 재고 구간을 캐시에 기록한다.
+    // threshold와 구독 기간은 Config를 따르며, 구독을 수락한 DVM 수를 반환한다.
+    int subscribeToPeers();
+
+    // 구독한 DVM이 보낸 재고 변화 알림 반영
+    void applyStockChange(int peerId, const string& itemCode, int itemNum, int threshold);
+
+    // 무작위로 고른 다른 DVM 몇 대(Config::gossipFanout)와 재고 표를 교환한다.
+    // 응답한 DVM 수를 반환한다.
+    int gossipRound();
+
+    // 다른 DVM이 보낸 가십 반영. 보낸 DVM이 모르는 더 새로운 항목을 돌려준다.
+    vector<InventoryEntry> acceptGossip(int senderId, const map<int, uint64_t>& digest, const vector<InventoryEntry>& entries);
+    
+    // 유효 기간이 지난 인증코드를 지우고 잡아 두었던 재고를 되돌린다. 되돌린 코드 수를 반환
+    int expireCertCodes();
     
     // 선결제된 아이템 처리
-    bool processPrepaidItem(string certCode);
+    bool processPrepaidItem(const string& certCode);
+
+    // 재고, 남은 인증코드, 판매 기록을 Config::snapshotPath에 쓴다. 판매 중에도 호출할 수 있다
+    bool writeSnapshot();
+
+    // 판매 기록을 directory에 하루 단위 열 형식 파일(SalesSegment)로 내보낸다. 판매 중에도 호출할 수 있다
+    // 지난번 이후 새 판매가 생긴 날의 파일만 다시 쓴다. 내보낸 파일 수를 반환하고, 쓰기에 실패하면 -1
+    int exportSalesHistory(const string& directory);
+
+    // 판매 기록의 통계 (아이템별 매출, 시간별 수량, 선결제 비율, 결제받은 DVM별 선결제 수령 수)
+    // 판매 장부의 조각을 Config::statsThreads개까지의 스레드로 나누어 계산한다
+    SalesStats querySales(const SalesQuery& query) const;
 
     // getter 추가
     Location getLocation() const;
-    const map<Item, int>& getStocks() const;
+    // 현재 재고의 복사본
+    map<Item, int> getStocks() const;
     const int getDvmId() const;
+    size_t getSaleCount() const;
+    PeerStockCache& getStockCache();
+    SubscriptionRegistry& getSubscriptions();
+    CertificationRegistry& getCertCodes();
+    FleetInventory& getFleetInventory();
 };
 
 #endif // DVM_H
\ No newline at end of file
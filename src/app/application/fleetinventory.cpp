@@ -0,0 +1,121 @@
+#include "fleetinventory.h"
+#include <algorithm>
+
+FleetInventory::FleetInventory(int selfId) : selfId(selfId) {
+    entries[selfId].receivedAt = chrono::steady_clock::now();
+}
+
+void FleetInventory::setLocalStock(const string &itemCode, int count) {
+    lock_guard<mutex> lock(inventoryMutex);
+    map<string, int> stocks = entries[selfId].stocks;
+    stocks[itemCode] = count;
+    replaceLocal(move(stocks));
+}
+
+void FleetInventory::replaceLocal(map<string, int> stocks) {
+    // 재시작한 DVM의 version이 이전보다 작아지지 않도록 시각(ms)을 하한으로 쓴다
+    uint64_t nowMs = chrono::duration_cast<chrono::milliseconds>(
+                         chrono::system_clock::now().time_since_epoch()).count();
+    Entry &self = entries[selfId];
+    self.stocks = move(stocks);
+    self.version = max(self.version + 1, nowMs);
+    self.receivedAt = chrono::steady_clock::now();
+}
+
+InventoryEntry FleetInventory::localEntry() const {
+    lock_guard<mutex> lock(inventoryMutex);
+    return toInventoryEntry(selfId, entries.at(selfId));
+}
+
+map<int, uint64_t> FleetInventory::digest() const {
+    map<int, uint64_t> result;
+    lock_guard<mutex> lock(inventoryMutex);
+    for (const auto &[dvmId, entry] : entries) {
+        result[dvmId] = entry.version;
+    }
+    return result;
+}
+
+size_t FleetInventory::merge(const vector<InventoryEntry> &received) {
+    auto now = chrono::steady_clock::now();
+    size_t updated = 0;
+    lock_guard<mutex> lock(inventoryMutex);
+    for (const auto &item : received) {
+        // 자기 재고는 자신이 가장 잘 안다
+        if (item.dvm_id == selfId) {
+            continue;
+        }
+        Entry &entry = entries[item.dvm_id];
+        if (item.version <= entry.version) {
+            continue;
+        }
+        entry.version = item.version;
+        entry.stocks.clear();
+        for (const auto &stock : item.stocks) {
+            entry.stocks[stock.item_code] = stock.item_num;
+        }
+        entry.receivedAt = now;
+        ++updated;
+    }
+    return updated;
+}
+
+vector<InventoryEntry> FleetInventory::newerThan(const map<int, uint64_t> &peerDigest, int requesterId, size_t maxEntries) const {
+    vector<InventoryEntry> result;
+    lock_guard<mutex> lock(inventoryMutex);
+    // 자기 항목을 먼저 담아 개수 제한에 밀리지 않게 한다
+    auto self = entries.find(selfId);
+    auto known = peerDigest.find(selfId);
+    if (self != entries.end() && self->second.version > 0 && maxEntries > 0 &&
+        (known == peerDigest.end() || known->second < self->second.version)) {
+        result.push_back(toInventoryEntry(selfId, self->second));
+    }
+    // 자주 바뀌는 항목이 매번 개수 제한을 채워 나머지가 영영 전달되지 않는 일이 없도록,
+    // 상대가 가장 오래 전 version을 알고 있는 (또는 모르는) 항목부터 보낸다
+    vector<pair<uint64_t, map<int, Entry>::const_iterator>> stale;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->first == selfId || it->first == requesterId || it->second.version == 0) {
+            continue;
+        }
+        known = peerDigest.find(it->first);
+        uint64_t knownVersion = known == peerDigest.end() ? 0 : known->second;
+        if (knownVersion < it->second.version) {
+            stale.emplace_back(knownVersion, it);
+        }
+    }
+    size_t count = min(stale.size(), maxEntries - min(maxEntries, result.size()));
+    partial_sort(stale.begin(), stale.begin() + count, stale.end(), [](const auto &a, const auto &b) {
+        return a.first != b.first ? a.first < b.first : a.second->first < b.second->first;
+    });
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(toInventoryEntry(stale[i].second->first, stale[i].second->second));
+    }
+    return result;
+}
+
+PeerStockCache::Lookup FleetInventory::lookup(int dvmId, const string &itemCode, int count, int maxAgeMs) const {
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(inventoryMutex);
+    auto it = entries.find(dvmId);
+    if (dvmId == selfId || it == entries.end() || it->second.version == 0 ||
+        now - it->second.receivedAt > chrono::milliseconds(maxAgeMs)) {
+        return PeerStockCache::Lookup::Miss;
+    }
+    auto stock = it->second.stocks.find(itemCode);
+    int available = stock == it->second.stocks.end() ? 0 : stock->second;
+    return available >= count ? PeerStockCache::Lookup::Available : PeerStockCache::Lookup::Unavailable;
+}
+
+size_t FleetInventory::size() const {
+    lock_guard<mutex> lock(inventoryMutex);
+    return entries.size();
+}
+
+InventoryEntry FleetInventory::toInventoryEntry(int dvmId, const Entry &entry) {
+    InventoryEntry result{dvmId, entry.version, {}};
+    result.stocks.reserve(entry.stocks.size());
+    for (const auto &[itemCode, count] : entry.stocks) {
+        result.stocks.push_back(CheckStockRequest{itemCode, count});
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+#ifndef FLEETINVENTORY_H
+#define FLEETINVENTORY_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "../dto.h"
+#include "peerstockcache.h"
+
+using namespace std;
+
+// 가십으로 모은 DVM 전체의 재고 표 (근사값)
+// 각 DVM은 자기 재고가 바뀐 뒤 처음 가십할 때 version을 올리고, 가십 상대와 digest(DVM별 version)를
+// 교환하여 더 새로운 항목만 받아 합친다. 피어 수가 늘어도 한 DVM이 주기마다 주고받는
+// 메시지 수는 일정하고, 재고 조회는 네트워크 없이 이 표에서 답할 수 있다.
+// 판매 경로에서는 markLocalChanged로 원자적 변경 횟수만 올리고, 자기 항목은 가십할 때
+// refreshLocal로 재고 표에서 다시 만든다 (판매가 이 표의 잠금을 기다리지 않는다).
+class FleetInventory {
+public:
+    explicit FleetInventory(int selfId);
+
+    // 이 DVM의 재고 변경 (version 증가)
+    void setLocalStock(const string &itemCode, int count);
+
+    // 이 DVM의 재고가 바뀌었음을 잠금 없이 기록한다
+    void markLocalChanged() {
+        localChanges.fetch_add(1, memory_order_release);
+    }
+
+    // 마지막으로 반영한 뒤 바뀐 것이 있으면 collect(map<string, int>&)로 현재 재고를 모아
+    // 자기 항목을 바꾸고 version을 올린다
+    template <typename Collect>
+    void refreshLocal(Collect &&collect) {
+        // 변경 횟수를 먼저 읽고 재고를 모으므로 모은 재고는 읽은 횟수까지의 변경을 모두 포함한다
+        uint64_t changes = localChanges.load(memory_order_acquire);
+        {
+            lock_guard<mutex> lock(inventoryMutex);
+            if (changes == appliedLocalChanges) {
+                return;
+            }
+        }
+        map<string, int> stocks;
+        collect(stocks);
+        lock_guard<mutex> lock(inventoryMutex);
+        if (changes <= appliedLocalChanges) {
+            return;
+        }
+        appliedLocalChanges = changes;
+        replaceLocal(move(stocks));
+    }
+    InventoryEntry localEntry() const;
+
+    // 알고 있는 DVM별 version (자기 자신 포함)
+    map<int, uint64_t> digest() const;
+
+    // 받은 항목 중 알고 있는 것보다 새로운 항목만 반영하고 반영한 수를 반환
+    size_t merge(const vector<InventoryEntry> &entries);
+
+    // digest를 보낸 상대가 모르는 더 새로운 항목 (requesterId 자신의 항목은 제외, 최대 maxEntries개)
+    // 개수 제한을 넘으면 상대가 알고 있는 version이 오래된 항목부터 담는다
+    vector<InventoryEntry> newerThan(const map<int, uint64_t> &peerDigest, int requesterId, size_t maxEntries) const;
+
+    // 다른 DVM이 count개를 줄 수 있는지 조회. maxAgeMs 안에 받은 정보가 없으면 Miss
+    PeerStockCache::Lookup lookup(int dvmId, const string &itemCode, int count, int maxAgeMs) const;
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        uint64_t version = 0;
+        map<string, int> stocks;
+        chrono::steady_clock::time_point receivedAt;
+    };
+
+    int selfId;
+    mutable mutex inventoryMutex;
+    map<int, Entry> entries;
+    atomic<uint64_t> localChanges{0};
+    uint64_t appliedLocalChanges = 0;
+
+    // 자기 항목의 재고를 바꾸고 version을 올린다 (inventoryMutex를 잡고 부른다)
+    void replaceLocal(map<string, int> stocks);
+
+    static InventoryEntry toInventoryEntry(int dvmId, const Entry &entry);
+};
+
+#endif // FLEETINVENTORY_H
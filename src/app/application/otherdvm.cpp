@@ -1,69 +1,189 @@
 #include <fstream>
 #include "otherdvm.h"
 
-OtherDVM::OtherDVM(int id, const Location &loc, const char* targetIp, const int port)
-    : dvmId(id), location(loc), targetIp(targetIp), port(port) {}
-
-bool OtherDVM::establishConnection(int &sock) const {
-    sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        cerr << "Socket creation failed\n";
-        return false;
+namespace {
+    // 상대가 연결을 닫았거나, 이미 닫은 연결에 요청이 도착해 RST로 거절했다
+    bool closedByPeer(int bytesRead) {
+        return bytesRead == 0 || (bytesRead < 0 && errno == ECONNRESET);
     }
+}
 
-    struct sockaddr_in serverAddr;
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_port = htons(port);
-    inet_pton(AF_INET, targetIp, &serverAddr.sin_addr);
+OtherDVM::OtherDVM(int id, const Location &loc, const char* targetIp, const int port)
+    : dvmId(id), location(loc), targetIp(targetIp), port(port),
+      connectionPool(make_shared<PeerConnectionPool>(targetIp, port,
+                                                     Config::get().peerPoolMaxIdle,
+                                                     Config::get().peerPoolMaxIdleMs)),
+      codec(Config::get().peerBinaryCodec ? Frame::Binary : Frame::Text),
+      framed(Config::get().peerFraming || Config::get().peerBinaryCodec) {}
 
-    struct timeval timeout;
-    timeout.tv_sec = 3;
-    timeout.tv_usec = 0;
-    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+bool OtherDVM::exchange(const string &request, uint8_t requestCodec, string &response, uint8_t &responseCodec,
+                        string_view endField, bool retry) {
+    string wire = framed ? Frame::encode(request, requestCodec) : request;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool reused = false;
+        int sock = connectionPool->acquire(reused);
+        if (sock < 0) {
+            return false;
+        }
 
+        size_t sent = 0;
+        bool closedBeforeReply = false;
+        if (sendAll(sock, wire, &sent) &&
+            receiveResponse(sock, response, responseCodec, endField, &closedBeforeReply)) {
+            connectionPool->release(sock);
+            return true;
+        }
 
-    if (connect(sock, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0) {
-        cerr << "Connection failed\n";
-        close(sock);
-        return false;
+        connectionPool->discard(sock);
+        // 새로 맺은 연결에서도 실패했거나, 상대에게 요청이 닿았을 수 있으면 재시도하지 않는다
+        // (응답이 늦거나 중간에 끊긴 요청을 다시 보내면 상대가 두 번 처리할 수 있다)
+        bool stale = sent == 0 || (closedBeforeReply && sent == wire.size());
+        if (!reused || !stale || (sent > 0 && !retry)) {
+            return false;
+        }
     }
-
-    return true;
+    return false;
 }
 
-//재고 확인 요청
-CheckStockResponse OtherDVM::findAvailableStocks(const CheckStockRequest &request, int senderDvmId)
-{
-    static ofstream logFile("client_log.txt", ios::app);
-    if (!logFile) {
-        cerr << "⚠️ client_log.txt 열기 실패\n";
+bool OtherDVM::receiveResponse(int sock, string &response, uint8_t &responseCodec, string_view endField,
+                               bool *closedBeforeReply) {
+    char buffer[4096];
+    responseCodec = Frame::Text;
+    if (!framed) {
+        response.clear();
+        do {
+            // 끝 필드 없이 연결이 닫히거나 너무 길어지면 잘린 응답이다
+            int bytesRead = recv(sock, buffer, sizeof(buffer), 0);
+            if (closedBeforeReply && response.empty() && closedByPeer(bytesRead)) {
+                *closedBeforeReply = true;
+            }
+            if (bytesRead <= 0 || response.size() + bytesRead > (size_t)Config::get().maxFrameBytes) {
+                return false;
+            }
+            response.append(buffer, bytesRead);
+        } while (!endField.empty() &&
+                 (response.size() < endField.size() ||
+                  response.compare(response.size() - endField.size(), endField.size(), endField) != 0));
+        return true;
     }
 
-    int sock;
-    if (!establishConnection(sock)) {
-        return {};
+    FrameDecoder decoder(Config::get().maxFrameBytes);
+    bool receivedAny = false;
+    while (true) {
+        FrameDecoder::Result result = decoder.next(response, responseCodec);
+        if (result == FrameDecoder::Result::Ready) {
+            return true;
+        }
+        if (result == FrameDecoder::Result::Error) {
+            return false;
+        }
+        int bytesRead = recv(sock, buffer, sizeof(buffer), 0);
+        if (closedBeforeReply && !receivedAny && closedByPeer(bytesRead)) {
+            *closedBeforeReply = true;
+        }
+        if (bytesRead <= 0) {
+            return false;
+        }
+        receivedAny = true;
+        decoder.feed(buffer, bytesRead);
     }
+}
 
-    struct timeval timeout;
-    timeout.tv_sec = 3;
-    timeout.tv_usec = 0;
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+uint8_t OtherDVM::buildStockRequest(const CheckStockRequest &request, int senderDvmId, string &payload, uint32_t reqId) const
+{
+    BinaryMessage binary;
+    binary.type = BinaryMessage::Type::ReqStock;
+    binary.srcId = senderDvmId;
+    binary.reqId = reqId;
+    binary.itemNum = request.item_num;
+    if (codec == Frame::Binary && BinaryCodec::encodeItemCode(request.item_code, binary.itemCode)) {
+        encodeBinary(binary, payload);
+        return Frame::Binary;
+    }
 
+    // 바이너리로 표현할 수 없는 아이템 코드는 텍스트로 보낸다
     SocketMessage msg;
     msg.msg_type = "req_stock";
     msg.src_id = "T" + to_string(senderDvmId);
     msg.dst_id = "0";
+    if (reqId != 0) {
+        msg.req_id = to_string(reqId);
+    }
     msg.msg_content["item_code"] = request.item_code;
     msg.msg_content["item_num"] = to_string(request.item_num);
+    payload = msg.serialize();
+    return Frame::Text;
+}
+
+void OtherDVM::encodeBinary(const BinaryMessage &msg, string &payload) const
+{
+    uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+    size_t size = BinaryCodec::encode(msg, buffer, sizeof(buffer));
+    payload.assign((const char *)buffer, size);
+}
+
+CheckStockResponse OtherDVM::decodeStockResponse(const string &payload, uint8_t responseCodec) const
+{
+    if (responseCodec != Frame::Binary) {
+        return parseStockResponse(payload);
+    }
+
+    BinaryMessage msg;
+    if (!BinaryCodec::decode((const uint8_t *)payload.data(), payload.size(), msg) ||
+        msg.type != BinaryMessage::Type::RespStock) {
+        return {};
+    }
+    char itemCode[2];
+    BinaryCodec::formatItemCode(msg.itemCode, itemCode);
+    return CheckStockResponse{
+        .dst_id = msg.dstId,
+        .item_code = string(itemCode, 2),
+        .item_num = msg.itemNum,
+        .coor_x = msg.coorX,
+        .coor_y = msg.coorY};
+}
+
+CheckStockResponse OtherDVM::parseStockResponse(const string &raw) const
+{
+    static ofstream logFile("client_log.txt", ios::app);
+    logFile << "[CLIENT] Raw response: " << raw << std::endl;
+
+    CheckStockResponse response{};
+    MessageParser parser(raw);
+    string_view key, value;
+    while (parser.next(key, value)) {
+        if (key == "item_code") {
+            response.item_code = value;
+        } else if (key == "item_num") {
+            response.item_num = MessageParser::toIntOr(value, 0);
+        } else if (key == "coor_x") {
+            response.coor_x = MessageParser::toIntOr(value, 0);
+        } else if (key == "coor_y") {
+            response.coor_y = MessageParser::toIntOr(value, 0);
+        } else if (key == "dst_id" && value.size() > 1) {
+            response.dst_id = MessageParser::toIntOr(value.substr(1), 0);
+        }
+    }
 
-    string requestStr = msg.serialize();
-    send(sock, requestStr.c_str(), requestStr.size(), 0);
+    logFile << "[CLIENT] Parsed item_code: " << response.item_code << std::endl;
+    logFile << "[CLIENT] Parsed item_num: " << response.item_num << std::endl;
+    logFile.flush();
+    return response;
+}
 
-    char buffer[4096] = {0};
-    int bytesRead = recv(sock, buffer, sizeof(buffer), 0);
-    close(sock);
+//재고 확인 요청
+CheckStockResponse OtherDVM::findAvailableStocks(const CheckStockRequest &request, int senderDvmId)
+{
+    static ofstream logFile("client_log.txt", ios::app);
+    if (!logFile) {
+        cerr << "⚠️ client_log.txt 열기 실패\n";
+    }
 
-    if (bytesRead <= 0)
+    string payload;
+    uint8_t requestCodec = buildStockRequest(request, senderDvmId, payload);
+    string buffer;
+    uint8_t responseCodec = Frame::Text;
+    if (!exchange(payload, requestCodec, buffer, responseCodec))
     {
         static int warnCount = 0;
         if (warnCount++ < 3) {
@@ -73,69 +193,413 @@ CheckStockResponse OtherDVM::findAvailableStocks(const CheckStockRequest &reques
         return {};
     }
 
-    logFile << "[CLIENT] Raw response: " << buffer << std::endl;
+    return decodeStockResponse(buffer, responseCodec);
+}
+
+vector<CheckStockResponse> OtherDVM::findAvailableStocksPipelined(const vector<CheckStockRequest> &requests, int senderDvmId)
+{
+    vector<CheckStockResponse> responses(requests.size(), CheckStockResponse{});
+    if (!framed || requests.size() <= 1) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            responses[i] = findAvailableStocks(requests[i], senderDvmId);
+        }
+        return responses;
+    }
+
+    // req_id는 요청 순서 + 1 (연결을 독점하는 동안만 유효하면 된다)
+    string wire;
+    string payload;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        uint8_t requestCodec = buildStockRequest(requests[i], senderDvmId, payload, (uint32_t)(i + 1));
+        Frame::append(wire, payload, requestCodec);
+    }
 
-    SocketMessage resp = SocketMessage::deserialize(buffer);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool reused = false;
+        int sock = connectionPool->acquire(reused);
+        if (sock < 0) {
+            return responses;
+        }
+
+        vector<bool> answered(requests.size(), false);
+        size_t received = 0;
+        bool failed = !sendAll(sock, wire);
+        FrameDecoder decoder(Config::get().maxFrameBytes);
+        char buffer[4096];
+        while (!failed && received < requests.size()) {
+            int bytesRead = recv(sock, buffer, sizeof(buffer), 0);
+            if (bytesRead <= 0) {
+                failed = true;
+                break;
+            }
+            decoder.feed(buffer, bytesRead);
 
-    logFile << "[CLIENT] Parsed item_code: " << resp.msg_content["item_code"] << std::endl;
-    logFile << "[CLIENT] Parsed item_num: " << resp.msg_content["item_num"] << std::endl;
+            uint8_t responseCodec = Frame::Text;
+            FrameDecoder::Result result;
+            while ((result = decoder.next(payload, responseCodec)) == FrameDecoder::Result::Ready) {
+                uint32_t id = responseRequestId(payload, responseCodec);
+                // 짝을 찾을 수 없는 응답(예: server_busy)이 오면 남은 요청은 포기한다
+                if (id == 0 || id > requests.size() || answered[id - 1]) {
+                    failed = true;
+                    break;
+                }
+                responses[id - 1] = decodeStockResponse(payload, responseCodec);
+                answered[id - 1] = true;
+                received++;
+            }
+            if (result == FrameDecoder::Result::Error) {
+                failed = true;
+            }
+        }
 
-    int item_num = 0;
-    int coor_x = 0;
-    int coor_y = 0;
-    try {
-        item_num = stoi(resp.msg_content["item_num"]);
-        coor_x = stoi(resp.msg_content["coor_x"]);
-        coor_y = stoi(resp.msg_content["coor_y"]);
-    } catch (const std::exception& e) {
-        logFile << "[CLIENT] stoi failed: " << e.what() << std::endl;
+        if (!failed) {
+            connectionPool->release(sock);
+            return responses;
+        }
+        connectionPool->discard(sock);
+        // 응답을 일부라도 받았다면 요청이 처리되었으므로 다시 보내지 않는다
+        if (!reused || received > 0) {
+            return responses;
+        }
     }
-    logFile.flush();
+    return responses;
+}
 
-    return CheckStockResponse{
-        .dst_id = stoi(resp.dst_id.substr(1)),
-        .item_code = resp.msg_content["item_code"],
-        .item_num = item_num,
-        .coor_x = coor_x,
-        .coor_y = coor_y};
+CheckStockBatchResponse OtherDVM::findAvailableStocksBatch(const vector<CheckStockRequest> &requests, int senderDvmId)
+{
+    CheckStockBatchResponse result{};
+    if (requests.empty()) {
+        return result;
+    }
+
+    string payload;
+    uint8_t requestCodec = Frame::Text;
+    BinaryMessage binary;
+    binary.type = BinaryMessage::Type::ReqStockBatch;
+    binary.srcId = senderDvmId;
+    bool binaryEncodable = codec == Frame::Binary;
+    for (size_t i = 0; binaryEncodable && i < requests.size(); ++i) {
+        uint8_t itemCode;
+        binaryEncodable = BinaryCodec::encodeItemCode(requests[i].item_code, itemCode) &&
+                          binary.addBatchItem(itemCode, requests[i].item_num);
+    }
+    if (binaryEncodable) {
+        encodeBinary(binary, payload);
+        requestCodec = Frame::Binary;
+    } else {
+        SocketMessage msg;
+        msg.msg_type = "req_stock_batch";
+        msg.src_id = "T" + to_string(senderDvmId);
+        msg.dst_id = "T" + to_string(dvmId);
+        msg.msg_content["items"] = StockBatchField::format(requests);
+        payload = msg.serialize();
+    }
+
+    string buffer;
+    uint8_t responseCodec = Frame::Text;
+    if (!exchange(payload, requestCodec, buffer, responseCodec)) {
+        return result;
+    }
+
+    if (responseCodec == Frame::Binary) {
+        BinaryMessage resp;
+        if (!BinaryCodec::decode((const uint8_t *)buffer.data(), buffer.size(), resp) ||
+            resp.type != BinaryMessage::Type::RespStockBatch) {
+            return result;
+        }
+        result.dst_id = resp.dstId;
+        result.coor_x = resp.coorX;
+        result.coor_y = resp.coorY;
+        for (uint8_t i = 0; i < resp.batchCount; ++i) {
+            char itemCode[2];
+            BinaryCodec::formatItemCode(resp.batch[i].itemCode, itemCode);
+            result.items.push_back(CheckStockRequest{string(itemCode, 2), resp.batch[i].itemNum});
+        }
+        return result;
+    }
+
+    MessageParser parser(buffer);
+    string_view key, value;
+    while (parser.next(key, value)) {
+        if (key == "items") {
+            result.items = StockBatchField::parse(value);
+        } else if (key == "coor_x") {
+            result.coor_x = MessageParser::toIntOr(value, 0);
+        } else if (key == "coor_y") {
+            result.coor_y = MessageParser::toIntOr(value, 0);
+        } else if (key == "dst_id" && value.size() > 1) {
+            result.dst_id = MessageParser::toIntOr(value.substr(1), 0);
+        }
+    }
+    return result;
 }
 
-//선결제 요청
-askPrepaymentResponse OtherDVM::askForPrepayment(const askPrepaymentRequest &request, int senderDvmId)
+uint32_t OtherDVM::responseRequestId(const string &payload, uint8_t responseCodec)
 {
-    static ofstream logFile("client_log.txt", ios::app);
+    if (responseCodec == Frame::Binary) {
+        BinaryMessage msg;
+        if (!BinaryCodec::decode((const uint8_t *)payload.data(), payload.size(), msg)) {
+            return 0;
+        }
+        return msg.reqId;
+    }
+    int id = MessageParser::toIntOr(MessageParser::find(payload, "req_id"), 0);
+    return id > 0 ? (uint32_t)id : 0;
+}
+
+bool OtherDVM::sendAll(int sock, const string &data, size_t *sentBytes)
+{
+    size_t sent = 0;
+    bool ok = true;
+    while (sent < data.size()) {
+        ssize_t result = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (result <= 0) {
+            if (result < 0 && errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        sent += result;
+    }
+    if (sentBytes) {
+        *sentBytes = sent;
+    }
+    return ok;
+}
+
+bool OtherDVM::beginStockQuery(const CheckStockRequest &request, int senderDvmId, StockQuery &query)
+{
+    query = StockQuery{};
+    uint8_t requestCodec = buildStockRequest(request, senderDvmId, query.request);
+    if (framed) {
+        query.request = Frame::encode(query.request, requestCodec);
+    }
+
+    // 유휴 연결이 있으면 바로 전송 단계로, 없으면 non-blocking 연결부터 시작
+    int sock = connectionPool->acquireIdle();
+    if (sock >= 0) {
+        PeerConnectionPool::setNonBlocking(sock, true);
+        query.sock = sock;
+        query.reused = true;
+        return true;
+    }
+    return reconnectStockQuery(query);
+}
+
+bool OtherDVM::reconnectStockQuery(StockQuery &query)
+{
+    bool inProgress = false;
+    query.sock = connectionPool->connectAsync(inProgress);
+    query.reused = false;
+    query.connecting = inProgress;
+    query.sentBytes = 0;
+    query.decoder = FrameDecoder(Config::get().maxFrameBytes);
+    return query.sock >= 0;
+}
+
+short OtherDVM::stockQueryEvents(const StockQuery &query) const
+{
+    if (query.connecting || query.sentBytes < query.request.size()) {
+        return POLLOUT;
+    }
+    return POLLIN;
+}
+
+OtherDVM::QueryProgress OtherDVM::advanceStockQuery(StockQuery &query, short revents, CheckStockResponse &response)
+{
+    bool failed = false;
+
+    if (query.connecting) {
+        if (!PeerConnectionPool::finishConnect(query.sock)) {
+            failed = true;
+        } else {
+            query.connecting = false;
+        }
+    }
+
+    while (!failed && query.sentBytes < query.request.size()) {
+        ssize_t sent = send(query.sock, query.request.data() + query.sentBytes,
+                            query.request.size() - query.sentBytes, MSG_NOSIGNAL);
+        if (sent > 0) {
+            query.sentBytes += sent;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return QueryProgress::Pending;
+        } else if (!(sent < 0 && errno == EINTR)) {
+            failed = true;
+        }
+    }
+
+    if (!failed && (revents & (POLLIN | POLLHUP | POLLERR))) {
+        char buffer[4096];
+        string payload;
+        uint8_t responseCodec = Frame::Text;
+        bool complete = false;
+        while (!failed && !complete) {
+            ssize_t bytesRead = recv(query.sock, buffer, sizeof(buffer), 0);
+            if (bytesRead > 0) {
+                if (!framed) {
+                    payload.assign(buffer, bytesRead);
+                    complete = true;
+                    break;
+                }
+                query.decoder.feed(buffer, bytesRead);
+                FrameDecoder::Result result = query.decoder.next(payload, responseCodec);
+                complete = result == FrameDecoder::Result::Ready;
+                failed = result == FrameDecoder::Result::Error;
+            } else if (bytesRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                failed = true;
+            } else if (errno != EINTR) {
+                break; // 프레임의 나머지는 다음 poll에서 읽는다
+            }
+        }
+        if (complete) {
+            PeerConnectionPool::setNonBlocking(query.sock, false);
+            connectionPool->release(query.sock);
+            query.sock = -1;
+            response = decodeStockResponse(payload, responseCodec);
+            return QueryProgress::Done;
+        }
+    }
+
+    if (!failed) {
+        return QueryProgress::Pending;
+    }
+
+    connectionPool->discard(query.sock);
+    query.sock = -1;
+    // 재사용한 연결이 피어에 의해 닫혀 있었던 경우 새 연결로 한 번 더 시도
+    if (query.reused && reconnectStockQuery(query)) {
+        return QueryProgress::Pending;
+    }
+    return QueryProgress::Failed;
+}
+
+void OtherDVM::cancelStockQuery(StockQuery &query)
+{
+    // 응답이 나중에 도착할 수 있으므로 재사용하지 않고 닫는다
+    if (query.sock >= 0) {
+        connectionPool->discard(query.sock);
+        query.sock = -1;
+    }
+}
+
+vector<CheckStockRequest> OtherDVM::subscribeStocks(const vector<CheckStockRequest> &thresholds, int leaseMs, int senderDvmId)
+{
+    SocketMessage msg;
+    msg.msg_type = "req_subscribe";
+    msg.src_id = "T" + to_string(senderDvmId);
+    msg.dst_id = "T" + to_string(dvmId);
+    msg.msg_content["items"] = StockBatchField::format(thresholds);
+    msg.msg_content["lease_ms"] = to_string(leaseMs);
 
-    int sock;
-    if (!establishConnection(sock)) {
+    string buffer;
+    uint8_t responseCodec = Frame::Text;
+    if (thresholds.empty() || !exchange(msg.serialize(), Frame::Text, buffer, responseCodec) ||
+        MessageParser::find(buffer, "msg_type") != "resp_subscribe") {
         return {};
     }
+    return StockBatchField::parse(MessageParser::find(buffer, "items"));
+}
 
+bool OtherDVM::notifyStockChanged(const string &itemCode, int itemNum, int threshold, int senderDvmId)
+{
     SocketMessage msg;
-    msg.msg_type = "req_prepay";
+    msg.msg_type = "stock_changed";
     msg.src_id = "T" + to_string(senderDvmId);
-    msg.dst_id = dvmId;
-    msg.msg_content["item_code"] = request.item_code;
-    msg.msg_content["item_num"] = to_string(request.item_num);
-    msg.msg_content["cert_code"] = request.cert_code;
+    msg.dst_id = "T" + to_string(dvmId);
+    msg.msg_content["item_code"] = itemCode;
+    msg.msg_content["item_num"] = to_string(itemNum);
+    msg.msg_content["threshold"] = to_string(threshold);
+
+    string buffer;
+    uint8_t responseCodec = Frame::Text;
+    return exchange(msg.serialize(), Frame::Text, buffer, responseCodec) &&
+           MessageParser::find(buffer, "msg_type") == "resp_stock_changed";
+}
+
+bool OtherDVM::exchangeGossip(const map<int, uint64_t> &digest, const InventoryEntry &own, int senderDvmId,
+                              vector<InventoryEntry> &newer)
+{
+    SocketMessage msg;
+    msg.msg_type = "req_gossip";
+    msg.src_id = "T" + to_string(senderDvmId);
+    msg.dst_id = "T" + to_string(dvmId);
+    msg.msg_content["digest"] = GossipField::formatDigest(digest);
+    msg.msg_content["entries"] = GossipField::formatEntries({own});
 
-    string requestStr = msg.serialize();
-    send(sock, requestStr.c_str(), requestStr.size(), 0);
+    string buffer;
+    uint8_t responseCodec = Frame::Text;
+    if (!exchange(msg.serialize(), Frame::Text, buffer, responseCodec, SocketMessage::kEndField) ||
+        MessageParser::find(buffer, "msg_type") != "resp_gossip") {
+        return false;
+    }
+    newer = GossipField::parseEntries(MessageParser::find(buffer, "entries"));
+    return true;
+}
 
-    char buffer[4096] = {0};
-    int bytesRead = recv(sock, buffer, sizeof(buffer), 0);
-    close(sock);
+//선결제 요청
+askPrepaymentResponse OtherDVM::askForPrepayment(const askPrepaymentRequest &request, int senderDvmId)
+{
+    static ofstream logFile("client_log.txt", ios::app);
 
-    if (bytesRead <= 0)
+    string payload;
+    uint8_t requestCodec = Frame::Text;
+    BinaryMessage binary;
+    binary.type = BinaryMessage::Type::ReqPrepay;
+    binary.srcId = senderDvmId;
+    binary.dstId = dvmId;
+    binary.itemNum = request.item_num;
+    if (codec == Frame::Binary && BinaryCodec::encodeItemCode(request.item_code, binary.itemCode) &&
+        binary.setCertCode(request.cert_code)) {
+        encodeBinary(binary, payload);
+        requestCodec = Frame::Binary;
+    } else {
+        SocketMessage msg;
+        msg.msg_type = "req_prepay";
+        msg.src_id = "T" + to_string(senderDvmId);
+        msg.dst_id = "T" + to_string(dvmId);
+        msg.msg_content["item_code"] = request.item_code;
+        msg.msg_content["item_num"] = to_string(request.item_num);
+        msg.msg_content["cert_code"] = request.cert_code;
+        payload = msg.serialize();
+    }
+
+    string buffer;
+    uint8_t responseCodec = Frame::Text;
+    // 선결제는 상대의 재고를 잡으므로, 요청이 닿았을 수 있으면 다시 보내지 않는다
+    if (!exchange(payload, requestCodec, buffer, responseCodec, {}, false))
     {
         logFile << "Failed to receive response\n";
         return {};
     }
 
-    SocketMessage resp = SocketMessage::deserialize(buffer);
-    return askPrepaymentResponse{
-        .item_code = resp.msg_content["item_code"],
-        .item_num = stoi(resp.msg_content["item_num"]),
-        .availability = (resp.msg_content["availability"] == "T")};
+    if (responseCodec == Frame::Binary) {
+        BinaryMessage resp;
+        if (!BinaryCodec::decode((const uint8_t *)buffer.data(), buffer.size(), resp) ||
+            resp.type != BinaryMessage::Type::RespPrepay) {
+            return {};
+        }
+        return askPrepaymentResponse{
+            .item_code = request.item_code,
+            .item_num = resp.itemNum,
+            .availability = resp.availability,
+            .duplicate_code = resp.reason == BinaryMessage::ReasonDuplicateCode};
+    }
+
+    askPrepaymentResponse response{};
+    MessageParser parser(buffer);
+    string_view key, value;
+    while (parser.next(key, value)) {
+        if (key == "item_code") {
+            response.item_code = value;
+        } else if (key == "item_num") {
+            response.item_num = MessageParser::toIntOr(value, 0);
+        } else if (key == "availability") {
+            response.availability = value == "T";
+        } else if (key == "reason") {
+            response.duplicate_code = value == "duplicate_code";
+        }
+    }
+    return response;
 }
 
 const Location &OtherDVM::getLocation() const
@@ -146,4 +610,44 @@ const Location &OtherDVM::getLocation() const
 int OtherDVM::getDvmId() const
 {
     return dvmId;
-}
\ No newline at end of file
+}
+
+size_t OtherDVM::getIdleConnectionCount() const
+{
+    return connectionPool->getIdleCount();
+}
+
+bool OtherDVM::requestStats(const SalesQuery &query, int senderDvmId, SalesStats &stats)
+{
+    SocketMessage msg;
+    msg.msg_type = "req_stats";
+    msg.src_id = "T" + to_string(senderDvmId);
+    msg.dst_id = "T" + to_string(dvmId);
+    if (query.from_ms != INT64_MIN)
+        msg.msg_content["from_ms"] = to_string(query.from_ms);
+    if (query.to_ms != INT64_MAX)
+        msg.msg_content["to_ms"] = to_string(query.to_ms);
+    if (!query.item_code.empty())
+        msg.msg_content["item_code"] = query.item_code;
+    if (query.source_dvm >= 0)
+        msg.msg_content["source"] = "T" + to_string(query.source_dvm);
+
+    string buffer;
+    uint8_t responseCodec = Frame::Text;
+    if (!exchange(msg.serialize(), Frame::Text, buffer, responseCodec, SocketMessage::kEndField) ||
+        MessageParser::find(buffer, "msg_type") != "resp_stats") {
+        return false;
+    }
+    stats = SalesStats{};
+    // 합계 필드가 하나라도 없거나 숫자가 아니면 응답 전체를 믿지 않는다
+    if (!MessageParser::toInt(MessageParser::find(buffer, "sales"), stats.sales) ||
+        !MessageParser::toInt(MessageParser::find(buffer, "units"), stats.units) ||
+        !MessageParser::toInt(MessageParser::find(buffer, "revenue"), stats.revenue) ||
+        !MessageParser::toInt(MessageParser::find(buffer, "prepaid"), stats.prepaid)) {
+        return false;
+    }
+    stats.items = StatsField::parseItems(MessageParser::find(buffer, "items"));
+    stats.units_by_hour = StatsField::parseHours(MessageParser::find(buffer, "hours"));
+    stats.sources = StatsField::parseSources(MessageParser::find(buffer, "sources"));
+    return true;
+}
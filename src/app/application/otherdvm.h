@@ -4,14 +4,21 @@
 #include <string>
 #include "../domain/location.h"
 #include "../dto.h"
+#include "../network/peerconnectionpool.h"
+#include "../network/frame.h"
+#include "../network/binarycodec.h"
 
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <poll.h>
+#include <cerrno>
 #include <sstream>
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
+#include <vector>
 
 using namespace std;
 
@@ -21,15 +28,89 @@ private:
     int dvmId;
     Location location;
     // 추가
-    const char* targetIp;
+    string targetIp;
     int port;
-    bool establishConnection(int &sock) const;
+    // 복사된 OtherDVM끼리 같은 연결 풀을 공유한다
+    shared_ptr<PeerConnectionPool> connectionPool;
+    // 생성 시점의 Config에 따라 프레임 프로토콜 사용 여부를 고정한다
+    // (풀의 연결은 처음 사용한 모드로만 통신해야 한다)
+    // 바이너리 codec을 쓰면 항상 프레임으로 보낸다
+    uint8_t codec;
+    bool framed;
+    // 풀의 연결로 요청을 보내고 응답을 받는다. 재사용한 연결이 끊겨 있으면 새 연결로 한 번 재시도한다.
+    // 요청을 한 바이트도 보내지 못했을 때만 항상 재시도하고, 보낸 뒤 응답 없이 닫힌 경우는
+    // 상대가 요청을 처리했을 수도 있으므로 retry가 true일 때만 다시 보낸다 (같은 요청을 두 번 처리해도 되는 경우).
+    // endField가 있으면 프레임 없이 받을 때 응답이 그 필드로 끝날 때까지 이어서 읽는다.
+    bool exchange(const string &request, uint8_t requestCodec, string &response, uint8_t &responseCodec,
+                  string_view endField = {}, bool retry = true);
+    // 요청 payload를 만들고 사용한 codec을 반환한다 (바이너리로 표현할 수 없으면 텍스트)
+    // reqId가 0이 아니면 요청에 req_id를 붙인다
+    uint8_t buildStockRequest(const CheckStockRequest &request, int senderDvmId, string &payload, uint32_t reqId = 0) const;
+    void encodeBinary(const BinaryMessage &msg, string &payload) const;
+    CheckStockResponse parseStockResponse(const string &raw) const;
+    CheckStockResponse decodeStockResponse(const string &payload, uint8_t responseCodec) const;
 public:
     OtherDVM(int id, const Location &loc, const char* targetIp, const int port);
     CheckStockResponse findAvailableStocks(const CheckStockRequest &request,int senderDvmId);
     askPrepaymentResponse askForPrepayment(const askPrepaymentRequest &request, int senderDvmId);
+
+    // 하나의 연결로 여러 재고 조회를 연달아 보내고 req_id로 응답을 짝지어 요청 순서대로 돌려준다.
+    // 서버는 응답 순서를 바꿀 수 있다. 프레임 모드가 아니면 한 건씩 조회한다.
+    // 응답을 받지 못한 항목은 빈 응답(item_num 0)이다.
+    vector<CheckStockResponse> findAvailableStocksPipelined(const vector<CheckStockRequest> &requests, int senderDvmId);
+
+    // 여러 아이템의 재고를 한 번의 요청(req_stock_batch)으로 조회한다.
+    // 응답의 items는 요청 순서와 같고, 통신에 실패하면 비어 있다.
+    CheckStockBatchResponse findAvailableStocksBatch(const vector<CheckStockRequest> &requests, int senderDvmId);
+
+    // 이 DVM에 재고 변화 알림을 구독한다 (req_subscribe). thresholds의 item_num은 아이템별 threshold
+    // 응답으로 구독 시점의 재고 수량을 돌려주고, 통신에 실패하거나 거절되면 비어 있다.
+    vector<CheckStockRequest> subscribeStocks(const vector<CheckStockRequest> &thresholds, int leaseMs, int senderDvmId);
+
+    // 구독한 DVM에 재고 구간이 바뀌었음을 알린다 (stock_changed)
+    bool notifyStockChanged(const string &itemCode, int itemNum, int threshold, int senderDvmId);
+
+    // 가십 한 번 (req_gossip): 알고 있는 version 목록과 자신의 재고를 보내고
+    // 상대가 가진 더 새로운 재고 항목을 받는다. 통신에 실패하면 false
+    bool exchangeGossip(const map<int, uint64_t> &digest, const InventoryEntry &own, int senderDvmId,
+                        vector<InventoryEntry> &newer);
+
+    // 이 DVM의 판매 통계를 받는다 (req_stats). 통신에 실패하거나 응답이 잘리거나 해석할 수 없으면 false
+    bool requestStats(const SalesQuery &query, int senderDvmId, SalesStats &stats);
+
+    // 여러 피어에 동시에 재고를 조회하기 위한 non-blocking API
+    // beginStockQuery로 조회를 시작하고, poll 결과가 나올 때마다 advanceStockQuery로 진행한다.
+    // 마감 시간까지 끝나지 않은 조회는 cancelStockQuery로 연결을 닫아 늦은 응답을 버린다.
+    struct StockQuery {
+        int sock = -1;
+        bool reused = false;
+        bool connecting = false;
+        string request;
+        size_t sentBytes = 0;
+        FrameDecoder decoder;
+    };
+    enum class QueryProgress { Pending, Done, Failed };
+
+    bool beginStockQuery(const CheckStockRequest &request, int senderDvmId, StockQuery &query);
+    short stockQueryEvents(const StockQuery &query) const;
+    QueryProgress advanceStockQuery(StockQuery &query, short revents, CheckStockResponse &response);
+    void cancelStockQuery(StockQuery &query);
+
     const Location &getLocation() const;
     int getDvmId() const;
+    size_t getIdleConnectionCount() const;
+
+private:
+    bool reconnectStockQuery(StockQuery &query);
+    // 응답 하나를 끝까지 읽는다. 프레임 모드에서는 프레임이 완성될 때까지,
+    // 프레임이 없으면 endField가 비어 있을 때는 한 번, 있을 때는 응답이 endField로 끝날 때까지 읽는다.
+    // 응답을 한 바이트도 받기 전에 연결이 닫혔으면 closedBeforeReply를 true로 채운다
+    bool receiveResponse(int sock, string &response, uint8_t &responseCodec, string_view endField = {},
+                         bool *closedBeforeReply = nullptr);
+    // 응답 payload의 req_id (없으면 0)
+    static uint32_t responseRequestId(const string &payload, uint8_t responseCodec);
+    // sentBytes가 있으면 실패하더라도 보낸 바이트 수를 채운다
+    static bool sendAll(int sock, const string &data, size_t *sentBytes = nullptr);
 };
 
 #endif // OTHERDVM_H
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "peerstockcache.h"
+
+PeerStockCache::PeerStockCache(int ttlMs) : ttl(ttlMs) {}
+
+PeerStockCache::Lookup PeerStockCache::lookup(int peerId, const string &itemCode, int count) {
+    if (count <= 0) {
+        misses++;
+        return Lookup::Miss;
+    }
+
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(cacheMutex);
+
+    auto it = entries.find(make_pair(peerId, itemCode));
+    if (it != entries.end() && now >= it->second.band.expiresAt && now >= it->second.polled.expiresAt) {
+        entries.erase(it);
+        it = entries.end();
+    }
+    if (it != entries.end()) {
+        // 더 최근에 확인한 조회 결과로 먼저 답하고, 판단할 수 없으면 구간으로 답한다
+        Lookup result = it->second.polled.decide(count, now);
+        if (result == Lookup::Miss) {
+            result = it->second.band.decide(count, now);
+        }
+        if (result != Lookup::Miss) {
+            hits++;
+            return result;
+        }
+    }
+    misses++;
+    return Lookup::Miss;
+}
+
+PeerStockCache::Lookup PeerStockCache::Bounds::decide(int count, chrono::steady_clock::time_point now) const {
+    if (now >= expiresAt) {
+        return Lookup::Miss;
+    }
+    if (count <= availableAtLeast) {
+        return Lookup::Available;
+    }
+    if (count >= unavailableFrom) {
+        return Lookup::Unavailable;
+    }
+    return Lookup::Miss;
+}
+
+void PeerStockCache::record(int peerId, const string &itemCode, int count, bool available) {
+    if (ttl.count() <= 0 || count <= 0) {
+        return;
+    }
+
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(cacheMutex);
+    Bounds &entry = entries[make_pair(peerId, itemCode)].polled;
+    if (now >= entry.expiresAt) {
+        entry = Bounds{};
+    }
+
+    if (available) {
+        entry.availableAtLeast = max(entry.availableAtLeast, count);
+        // 새 응답과 모순되는 이전 기록은 버린다 (그 사이 재고가 채워졌을 수 있음)
+        if (entry.unavailableFrom <= count) {
+            entry.unavailableFrom = INT_MAX;
+        }
+    } else {
+        entry.unavailableFrom = min(entry.unavailableFrom, count);
+        if (entry.availableAtLeast >= count) {
+            entry.availableAtLeast = 0;
+        }
+    }
+    entry.expiresAt = now + ttl;
+}
+
+void PeerStockCache::recordBand(int peerId, const string &itemCode, int count, int threshold, int leaseMs) {
+    if (leaseMs <= 0) {
+        return;
+    }
+
+    Bounds band;
+    if (count <= 0) {
+        band.unavailableFrom = 1;
+    } else if (count < threshold) {
+        band.availableAtLeast = 1;
+        band.unavailableFrom = threshold;
+    } else {
+        band.availableAtLeast = max(threshold, 1);
+    }
+    band.expiresAt = chrono::steady_clock::now() + chrono::milliseconds(leaseMs);
+
+    // 구간이 바뀌었다는 알림이므로 이전 조회 결과는 버린다
+    lock_guard<mutex> lock(cacheMutex);
+    entries[make_pair(peerId, itemCode)] = Entry{band, Bounds{}};
+}
+
+void PeerStockCache::invalidate(int peerId, const string &itemCode) {
+    lock_guard<mutex> lock(cacheMutex);
+    entries.erase(make_pair(peerId, itemCode));
+}
+
+void PeerStockCache::clear() {
+    lock_guard<mutex> lock(cacheMutex);
+    entries.clear();
+}
+
+void PeerStockCache::setTtl(int ttlMs) {
+    lock_guard<mutex> lock(cacheMutex);
+    ttl = chrono::milliseconds(ttlMs);
+    entries.clear();
+}
+
+size_t PeerStockCache::getHitCount() const {
+    return hits;
+}
+
+size_t PeerStockCache::getMissCount() const {
+    return misses;
+}
+
+size_t PeerStockCache::size() const {
+    lock_guard<mutex> lock(cacheMutex);
+    return entries.size();
+}
@@ -0,0 +1,66 @@
+#ifndef PEERSTOCKCACHE_H
+#define PEERSTOCKCACHE_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <climits>
+
+using namespace std;
+
+// 다른 DVM의 재고 조회 결과를 잠시 기억하는 캐시
+// 피어의 응답은 "요청 수량을 줄 수 있다/없다"만 알려주므로 (피어, 아이템)마다
+// 줄 수 있다고 확인된 최대 수량과 줄 수 없다고 확인된 최소 수량을 함께 기록한다.
+// 같은 아이템을 반복해서 조회할 때 TTL 안에서는 네트워크 없이 답한다.
+class PeerStockCache {
+public:
+    enum class Lookup { Miss, Available, Unavailable };
+
+    explicit PeerStockCache(int ttlMs);
+
+    // count개를 peerId에서 구할 수 있는지 조회. 판단할 수 없으면 Miss
+    Lookup lookup(int peerId, const string &itemCode, int count);
+
+    // 피어의 응답 기록. available이면 count개 이상, 아니면 count개 미만의 재고가 있다는 뜻
+    void record(int peerId, const string &itemCode, int count, bool available);
+
+    // 구독으로 받은 재고 구간 기록 (0개 / threshold 미만 / threshold 이상)
+    // 피어가 구간이 바뀔 때마다 알려 주므로 TTL 대신 구독 기간(leaseMs) 동안 유효하다.
+    // 조회 결과는 구간 안의 정확한 수량을 알려 주지만 구간이 바뀌지 않는 재고 변화는 알림이 오지 않으므로
+    // 구간과 따로 TTL 동안만 쓰고, 만료되면 구간으로 답한다.
+    void recordBand(int peerId, const string &itemCode, int count, int threshold, int leaseMs);
+
+    // 재고가 바뀐 것으로 알려진 항목 제거 (예: 선결제 성공)
+    void invalidate(int peerId, const string &itemCode);
+    void clear();
+
+    void setTtl(int ttlMs);
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+    size_t size() const;
+
+private:
+    struct Bounds {
+        int availableAtLeast = 0;        // 이 수량까지는 줄 수 있음
+        int unavailableFrom = INT_MAX;   // 이 수량부터는 줄 수 없음
+        chrono::steady_clock::time_point expiresAt;
+
+        Lookup decide(int count, chrono::steady_clock::time_point now) const;
+    };
+
+    struct Entry {
+        Bounds band;   // 구독으로 받은 구간 (구독 기간 동안 유효)
+        Bounds polled; // 조회 응답으로 좁힌 범위 (TTL 동안 유효)
+    };
+
+    mutable mutex cacheMutex;
+    map<pair<int, string>, Entry> entries;
+    chrono::milliseconds ttl;
+    atomic<size_t> hits{0};
+    atomic<size_t> misses{0};
+};
+
+#endif // PEERSTOCKCACHE_H
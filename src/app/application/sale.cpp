@@ -1,24 +1,16 @@
 #include "sale.h"
+#include "saleidgenerator.h"
 
-#include <ctime>  
-#include <chrono>
 #include <sstream>
 #include <stdexcept>
-#include <chrono>
 
 using namespace std;
   
 // Private constructors
 Sale::Sale(SaleRequest request) 
-    : saleId(""), datetime(""), item(request.item), 
+    : saleId(SaleIdGenerator::next()), createdAtMs(SaleIdGenerator::nowMs()), item(request.item), 
     count(request.itemNum), totalAmount(0), prepayment(nullptr) {
 
-    time_t now = time(nullptr);
-    char buf[26];
-    ctime_r(&now, buf);
-    datetime = string(buf);
-
-    saleId = "SALE_" + to_string(now);
     totalAmount = item.calculatePrice(count);
 }
 
@@ -34,7 +26,7 @@ Sale::Sale(SaleRequest request, const CertificationCode& certCode)
 
 // Copy constructor
 Sale::Sale(const Sale& other)
-    : saleId(other.saleId), datetime(other.datetime),
+    : saleId(other.saleId), createdAtMs(other.createdAtMs),
       item(other.item), count(other.count),
       totalAmount(other.totalAmount), prepayment(nullptr) {
     if (other.prepayment) {
@@ -46,7 +38,7 @@ Sale::Sale(const Sale& other)
 Sale& Sale::operator=(const Sale& other) {
     if (this != &other) {
         saleId = other.saleId;
-        datetime = other.datetime;
+        createdAtMs = other.createdAtMs;
         item = other.item;
         count = other.count;
         totalAmount = other.totalAmount;
@@ -87,6 +79,30 @@ bool Sale::receivePrepaidItem(const string& certCode) {
     return false;
 }
 
+string Sale::getCertCode() const {
+    return prepayment ? prepayment->getCertCode() : string();
+}
+
+uint64_t Sale::getSaleId() const {
+    return saleId;
+}
+
+int64_t Sale::getCreatedAtMs() const {
+    return createdAtMs;
+}
+
+const Item &Sale::getItem() const {
+    return item;
+}
+
+int Sale::getCount() const {
+    return count;
+}
+
+int Sale::getTotalAmount() const {
+    return totalAmount;
+}
+
 // 소멸자
 Sale::~Sale() {
     if (prepayment != nullptr) {
@@ -2,6 +2,7 @@
 #define SALE_H
 
 #include <string>
+#include <cstdint>
 #include <utility> // for pair
 #include "../domain/item.h"
 #include "../domain/prepayment.h"
@@ -11,8 +12,9 @@ using namespace std;
 
 class Sale {
 private:
-    string saleId;
-    string datetime;
+    // snowflake 방식 ID와 판매 시각 (Unix ms). 문자열은 표시할 때만 만든다
+    uint64_t saleId;
+    int64_t createdAtMs;
     Item item;
     int count;
     int totalAmount;
@@ -34,6 +36,15 @@ public:
     // 선결제된 아이템 수령 처리
     bool receivePrepaidItem(const string& certCode);
 
+    // 선결제 판매의 인증코드 (선결제가 아니면 빈 문자열)
+    string getCertCode() const;
+
+    uint64_t getSaleId() const;
+    int64_t getCreatedAtMs() const;
+    const Item &getItem() const;
+    int getCount() const;
+    int getTotalAmount() const;
+
     ~Sale();
 
     // methods for testing
@@ -0,0 +1,139 @@
+#include "saleidgenerator.h"
+#include <atomic>
+#include <chrono>
+#include <ctime>
+
+namespace
+{
+    constexpr uint64_t kSequenceMask = (1u << SaleIdGenerator::kSequenceBits) - 1;
+    constexpr uint64_t kSlotMask = (1u << SaleIdGenerator::kSlotBits) - 1;
+    constexpr uint64_t kNodeMask = (1u << SaleIdGenerator::kNodeBits) - 1;
+    constexpr int kSlotShift = SaleIdGenerator::kSequenceBits;
+    constexpr int kNodeShift = kSlotShift + SaleIdGenerator::kSlotBits;
+    constexpr int kTimestampShift = kNodeShift + SaleIdGenerator::kNodeBits;
+
+    atomic<uint32_t> nodeId{0};
+    // 쓰이는 중인 슬롯의 비트 (공유 슬롯은 항상 쓰이는 것으로 둔다)
+    atomic<uint32_t> usedSlots{1u << SaleIdGenerator::kSharedSlot};
+    // 끝난 스레드가 슬롯에서 마지막으로 발급한 [타임스탬프][순번]. 다음 스레드가 이어서 발급한다
+    uint64_t slotClocks[1u << SaleIdGenerator::kSlotBits];
+    // 공유 슬롯에서 마지막으로 발급한 [타임스탬프][순번]
+    atomic<uint64_t> sharedClock{0};
+
+    // 스레드가 처음 ID를 만들 때 빈 슬롯을 하나 잡고, 스레드가 끝나면 돌려준다
+    struct ThreadState
+    {
+        uint32_t slot = SaleIdGenerator::kSharedSlot;
+        int64_t lastMs = 0;
+        uint32_t sequence = 0;
+
+        ThreadState()
+        {
+            uint32_t used = usedSlots.load(memory_order_relaxed);
+            while (used != UINT32_MAX)
+            {
+                uint32_t free = static_cast<uint32_t>(__builtin_ctz(~used));
+                if (usedSlots.compare_exchange_weak(used, used | (1u << free), memory_order_acquire))
+                {
+                    slot = free;
+                    lastMs = static_cast<int64_t>(slotClocks[slot] >> SaleIdGenerator::kSequenceBits);
+                    sequence = static_cast<uint32_t>(slotClocks[slot] & kSequenceMask);
+                    return;
+                }
+            }
+        }
+
+        ~ThreadState()
+        {
+            if (slot != SaleIdGenerator::kSharedSlot)
+            {
+                slotClocks[slot] = (static_cast<uint64_t>(lastMs) << SaleIdGenerator::kSequenceBits) | sequence;
+                usedSlots.fetch_and(~(1u << slot), memory_order_release);
+            }
+        }
+    };
+
+    // 공유 슬롯의 다음 [타임스탬프][순번]. 순번을 다 쓰면 타임스탬프가 앞당겨진다
+    uint64_t nextSharedClock(int64_t now)
+    {
+        uint64_t floor = static_cast<uint64_t>(now) << SaleIdGenerator::kSequenceBits;
+        uint64_t last = sharedClock.load(memory_order_relaxed);
+        uint64_t next;
+        do
+        {
+            next = last + 1 > floor ? last + 1 : floor;
+        } while (!sharedClock.compare_exchange_weak(last, next, memory_order_relaxed));
+        return next;
+    }
+}
+
+void SaleIdGenerator::setNodeId(int id)
+{
+    nodeId.store(static_cast<uint32_t>(id) & kNodeMask, memory_order_relaxed);
+}
+
+uint64_t SaleIdGenerator::next()
+{
+    thread_local ThreadState state;
+    int64_t now = nowMs() - kEpochMs;
+    if (state.slot == kSharedSlot)
+    {
+        uint64_t clock = nextSharedClock(now);
+        return ((clock >> kSequenceBits) << kTimestampShift) |
+               (static_cast<uint64_t>(nodeId.load(memory_order_relaxed)) << kNodeShift) |
+               (static_cast<uint64_t>(kSharedSlot) << kSlotShift) |
+               (clock & kSequenceMask);
+    }
+    if (now > state.lastMs)
+    {
+        state.lastMs = now;
+        state.sequence = 0;
+    }
+    else if (++state.sequence > kSequenceMask)
+    {
+        // 시계가 뒤로 갔거나 이번 ms의 순번을 다 썼으면 다음 ms를 미리 쓴다
+        ++state.lastMs;
+        state.sequence = 0;
+    }
+    return (static_cast<uint64_t>(state.lastMs) << kTimestampShift) |
+           (static_cast<uint64_t>(nodeId.load(memory_order_relaxed)) << kNodeShift) |
+           (static_cast<uint64_t>(state.slot) << kSlotShift) |
+           state.sequence;
+}
+
+int64_t SaleIdGenerator::timestampOf(uint64_t id)
+{
+    return static_cast<int64_t>(id >> kTimestampShift) + kEpochMs;
+}
+
+int SaleIdGenerator::nodeOf(uint64_t id)
+{
+    return static_cast<int>((id >> kNodeShift) & kNodeMask);
+}
+
+uint32_t SaleIdGenerator::slotOf(uint64_t id)
+{
+    return static_cast<uint32_t>((id >> kSlotShift) & kSlotMask);
+}
+
+int64_t SaleIdGenerator::nowMs()
+{
+    return chrono::duration_cast<chrono::milliseconds>(
+               chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+string SaleIdGenerator::formatId(uint64_t id)
+{
+    return "SALE_" + to_string(id);
+}
+
+string SaleIdGenerator::formatTimestamp(int64_t unixMs)
+{
+    time_t seconds = static_cast<time_t>(unixMs / 1000);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    char buf[20];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local);
+    return string(buf);
+}
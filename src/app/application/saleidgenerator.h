@@ -0,0 +1,45 @@
+#ifndef SALEIDGENERATOR_H
+#define SALEIDGENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// 판매 ID 생성기 (snowflake 방식 64비트 ID)
+// [타임스탬프 ms 41비트][DVM ID 8비트][스레드 슬롯 5비트][순번 10비트]
+// 순번은 스레드마다 따로 세므로 스레드 사이에 공유하는 카운터나 잠금이 없다.
+// 한 스레드가 1ms에 1024개를 넘기면 타임스탬프를 1ms 앞당겨 이어서 발급하므로
+// 같은 스레드가 발급하는 ID는 항상 증가한다.
+// 슬롯은 스레드가 끝나면 돌려받아 다음 스레드가 이어서 쓴다. 마지막 슬롯은 공유 슬롯으로 남겨 두고,
+// 나머지 슬롯이 모두 쓰이는 중이면 그 뒤의 스레드는 공유 슬롯에서 원자적 순번으로 발급한다.
+namespace SaleIdGenerator {
+    constexpr int kTimestampBits = 41;
+    constexpr int kNodeBits = 8;
+    constexpr int kSlotBits = 5;
+    constexpr int kSequenceBits = 10;
+    // 스레드마다 나눠 주지 않고 함께 쓰는 슬롯
+    constexpr uint32_t kSharedSlot = (1u << kSlotBits) - 1;
+    // 타임스탬프 기준 시각 (2024-01-01T00:00:00Z, Unix ms)
+    constexpr int64_t kEpochMs = 1704067200000LL;
+
+    // ID에 넣을 DVM ID (하위 8비트만 사용)
+    void setNodeId(int nodeId);
+
+    // 새 판매 ID
+    uint64_t next();
+
+    // ID에서 각 부분을 꺼낸다
+    int64_t timestampOf(uint64_t id); // Unix ms
+    int nodeOf(uint64_t id);
+    uint32_t slotOf(uint64_t id);
+
+    // 현재 시각 (Unix ms)
+    int64_t nowMs();
+
+    // 표시/내보내기용 문자열 ("SALE_<ID>", "YYYY-MM-DD HH:MM:SS")
+    string formatId(uint64_t id);
+    string formatTimestamp(int64_t unixMs);
+}
+
+#endif // SALEIDGENERATOR_H
@@ -0,0 +1,200 @@
+#include "salesanalytics.h"
+#include "../storage/salessegment.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace
+{
+    int64_t hourOf(int64_t ms)
+    {
+        int64_t hour = ms / SalesAnalytics::kHourMs - (ms % SalesAnalytics::kHourMs < 0 ? 1 : 0);
+        return hour * SalesAnalytics::kHourMs;
+    }
+
+    // tasks개의 작업을 최대 threads개 스레드에 나누어 실행하고 스레드별 결과를 합친다
+    SalesStats runParallel(size_t tasks, size_t threads, const function<void(size_t, SalesStats &)> &run)
+    {
+        threads = max<size_t>(1, min(threads, tasks));
+        vector<SalesStats> partial(threads);
+        auto work = [&](size_t worker) {
+            for (size_t task = worker; task < tasks; task += threads)
+            {
+                run(task, partial[worker]);
+            }
+        };
+        vector<thread> workers;
+        for (size_t worker = 1; worker < threads; ++worker)
+        {
+            workers.emplace_back(work, worker);
+        }
+        work(0);
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        for (size_t worker = 1; worker < threads; ++worker)
+        {
+            partial[0].merge(partial[worker]);
+        }
+        return move(partial[0]);
+    }
+
+    size_t threadsFor(size_t rows, int threads)
+    {
+        return min<size_t>(max(threads, 1), rows / SalesAnalytics::kRowsPerThread + 1);
+    }
+}
+
+void SalesAnalytics::scan(const SalesLedger::Columns &columns, const vector<string> &itemCodes,
+                          const SalesQuery &query, SalesStats &stats)
+{
+    // 아이템 조건은 이 묶음의 아이템 번호로 바꿔 비교한다
+    int itemFilter = -1;
+    if (!query.item_code.empty())
+    {
+        auto found = find(itemCodes.begin(), itemCodes.end(), query.item_code);
+        if (found == itemCodes.end())
+        {
+            return;
+        }
+        itemFilter = (int)(found - itemCodes.begin());
+    }
+    const int64_t from = query.from_ms;
+    const int64_t to = query.to_ms;
+    const int sourceFilter = query.source_dvm;
+
+    vector<ItemSalesTotals> items(itemCodes.size());
+    int64_t sales = 0, units = 0, revenue = 0, prepaid = 0;
+    int64_t currentHour = INT64_MIN, hourUnits = 0;
+    uint8_t matched[kBlockRows];
+    uint8_t counted[kBlockRows];
+
+    for (size_t start = 0; start < columns.size; start += kBlockRows)
+    {
+        const size_t rows = min(kBlockRows, columns.size - start);
+        const int64_t *timestamps = columns.createdAt + start;
+        const uint16_t *itemIndexes = columns.itemIndexes + start;
+        const int32_t *counts = columns.counts + start;
+        const int32_t *amounts = columns.totalAmounts + start;
+        const uint8_t *flags = columns.flags + start;
+        const uint16_t *sources = columns.sourceDvms + start;
+
+        // 조건 검사: 분기 없이 행마다 0 또는 1을 남긴다
+        for (size_t i = 0; i < rows; ++i)
+        {
+            matched[i] = (uint8_t)((timestamps[i] >= from) & (timestamps[i] < to) &
+                                   ((itemFilter < 0) | (itemIndexes[i] == itemFilter)) &
+                                   ((sourceFilter < 0) | (sources[i] == sourceFilter)));
+            counted[i] = (uint8_t)(matched[i] & ((flags[i] & SalesLedger::FlagExpired) == 0));
+        }
+
+        // 전체 합계
+        for (size_t i = 0; i < rows; ++i)
+        {
+            sales += counted[i];
+            units += (int64_t)counted[i] * counts[i];
+            revenue += (int64_t)counted[i] * amounts[i];
+            prepaid += counted[i] & flags[i] & SalesLedger::FlagPrepaid;
+        }
+
+        // 아이템별 합계 (아이템 수가 적으므로 작은 배열에 모은다)
+        for (size_t i = 0; i < rows; ++i)
+        {
+            ItemSalesTotals &totals = items[itemIndexes[i]];
+            totals.sales += counted[i];
+            totals.units += (int64_t)counted[i] * counts[i];
+            totals.revenue += (int64_t)counted[i] * amounts[i];
+        }
+
+        // 시간별 수량과 출처 DVM별 선결제. 행은 대체로 시간 순이므로 같은 시간이 이어지는 동안 모아 둔다
+        for (size_t i = 0; i < rows; ++i)
+        {
+            if (counted[i])
+            {
+                int64_t hour = hourOf(timestamps[i]);
+                if (hour != currentHour)
+                {
+                    if (currentHour != INT64_MIN)
+                    {
+                        stats.units_by_hour[currentHour] += hourUnits;
+                    }
+                    currentHour = hour;
+                    hourUnits = 0;
+                }
+                hourUnits += counts[i];
+            }
+            if (matched[i] & flags[i] & SalesLedger::FlagPrepaid)
+            {
+                SourceSalesTotals &source = stats.sources[sources[i]];
+                ++source.prepaid;
+                source.redeemed += (flags[i] & SalesLedger::FlagReceived) != 0;
+                source.expired += (flags[i] & SalesLedger::FlagExpired) != 0;
+            }
+        }
+    }
+    if (currentHour != INT64_MIN)
+    {
+        stats.units_by_hour[currentHour] += hourUnits;
+    }
+
+    stats.sales += sales;
+    stats.units += units;
+    stats.revenue += revenue;
+    stats.prepaid += prepaid;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (items[i].sales > 0)
+        {
+            ItemSalesTotals &totals = stats.items[itemCodes[i]];
+            totals.sales += items[i].sales;
+            totals.units += items[i].units;
+            totals.revenue += items[i].revenue;
+        }
+    }
+}
+
+SalesStats SalesAnalytics::query(const SalesLedger &ledger, const SalesQuery &query, int threads)
+{
+    return runParallel(ledger.getShardCount(), threadsFor(ledger.size(), threads),
+                       [&](size_t shard, SalesStats &stats)
+                       {
+                           vector<string> itemCodes;
+                           ledger.forEachChunk(shard, [&](const SalesLedger::Columns &columns, const vector<Item> &items)
+                                               {
+                                                   // 조각의 아이템은 추가만 되므로 늘어난 것만 덧붙인다
+                                                   for (size_t i = itemCodes.size(); i < items.size(); ++i)
+                                                   {
+                                                       itemCodes.push_back(items[i].getItemCode());
+                                                   }
+                                                   scan(columns, itemCodes, query, stats);
+                                               });
+                       });
+}
+
+SalesStats SalesAnalytics::querySegments(const vector<string> &paths, const SalesQuery &query, int threads)
+{
+    return runParallel(paths.size(), max(threads, 1), [&](size_t index, SalesStats &stats)
+                       {
+                           SalesSegment segment;
+                           if (!segment.open(paths[index]))
+                           {
+                               return;
+                           }
+                           int64_t dayStart = segment.header().dayStartMs;
+                           if (dayStart >= query.to_ms || dayStart + SalesSegmentFormat::kDayMs <= query.from_ms)
+                           {
+                               return;
+                           }
+                           vector<string> itemCodes;
+                           for (uint32_t i = 0; i < segment.header().itemCount; ++i)
+                           {
+                               itemCodes.push_back(SnapshotFormat::getText(segment.items()[i].code));
+                           }
+                           // 파일의 열 배열을 복사하지 않고 그대로 훑는다
+                           SalesLedger::Columns columns{segment.size(), segment.saleIds(), segment.timestamps(),
+                                                        segment.itemIndexes(), segment.counts(), segment.amounts(),
+                                                        segment.flags(), segment.sourceDvms()};
+                           scan(columns, itemCodes, query, stats);
+                       });
+}
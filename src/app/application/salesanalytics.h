@@ -0,0 +1,33 @@
+#ifndef SALESANALYTICS_H
+#define SALESANALYTICS_H
+
+#include <string>
+#include <vector>
+#include "../dto.h"
+#include "salesledger.h"
+
+using namespace std;
+
+// 판매 기록의 열 배열 위에서 조건 검사와 아이템별, 시간별, 출처 DVM별 집계를 계산한다
+// 한 번에 kBlockRows 행씩 조건을 분기 없이 0/1 표시로 계산하고 그 표시를 곱해 더하므로,
+// 컴파일러가 반복문을 벡터 명령으로 바꿀 수 있다.
+// 메모리의 판매 장부는 조각 단위로, 판매 이력 파일은 파일 단위로 나누어 여러 스레드에서 계산한 뒤 합친다.
+namespace SalesAnalytics {
+    constexpr size_t kBlockRows = 256;
+    constexpr int64_t kHourMs = 60LL * 60 * 1000;
+    // 스레드 하나에 맡길 최소 판매 수 (이보다 적으면 스레드를 만드는 비용이 더 크다)
+    constexpr size_t kRowsPerThread = 64 * 1024;
+
+    // 열 묶음 하나를 집계해 stats에 더한다. itemCodes는 itemIndexes가 가리키는 아이템 코드
+    void scan(const SalesLedger::Columns &columns, const vector<string> &itemCodes, const SalesQuery &query,
+              SalesStats &stats);
+
+    // 판매 장부 전체를 최대 threads개 스레드로 집계한다 (판매 중에도 호출할 수 있다)
+    SalesStats query(const SalesLedger &ledger, const SalesQuery &query, int threads = 1);
+
+    // 판매 이력 파일(SalesSegment)들을 mmap하여 집계한다. 조회 기간과 겹치지 않는 날의 파일과
+    // 열 수 없는 파일은 건너뛴다
+    SalesStats querySegments(const vector<string> &paths, const SalesQuery &query, int threads = 1);
+}
+
+#endif // SALESANALYTICS_H
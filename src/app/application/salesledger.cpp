@@ -0,0 +1,155 @@
+#include "salesledger.h"
+#include "saleidgenerator.h"
+#include <functional>
+#include <thread>
+
+SalesLedger::SalesLedger(size_t shardCount)
+    : shardCount(shardCount > 0 ? shardCount : 1), shards(new Shard[this->shardCount]),
+      indexShards(new IndexShard[this->shardCount]) {}
+
+uint16_t SalesLedger::Shard::internItem(const Item &item) {
+    auto found = itemIndexByCode.find(item.getItemCode());
+    if (found != itemIndexByCode.end()) {
+        return found->second;
+    }
+    uint16_t index = (uint16_t)items.size();
+    items.push_back(item);
+    itemIndexByCode.emplace(item.getItemCode(), index);
+    return index;
+}
+
+void SalesLedger::append(const Sale &sale) {
+    string certCode = sale.getCertCode();
+    RecordRef ref = appendRecord(sale.getSaleId(), sale.getCreatedAtMs(), sale.getItem(), sale.getCount(),
+                                 sale.getTotalAmount(), certCode.empty() ? 0 : FlagPrepaid, 0);
+    if (!certCode.empty()) {
+        indexPending(certCode, ref, false);
+    }
+}
+
+SalesLedger::Record SalesLedger::record(const Item &item, int count, uint8_t flags, int sourceDvm) {
+    Record stored{SaleIdGenerator::next(), SaleIdGenerator::nowMs(), &item, count, item.calculatePrice(count), flags,
+                  sourceDvm};
+    appendRecord(stored.saleId, stored.createdAtMs, item, count, stored.totalAmount, flags, sourceDvm);
+    return stored;
+}
+
+SalesLedger::Record SalesLedger::recordPrepaid(const Item &item, int count, const string &certCode, int sourceDvm) {
+    Record stored{SaleIdGenerator::next(), SaleIdGenerator::nowMs(), &item, count, item.calculatePrice(count),
+                  FlagPrepaid, sourceDvm};
+    indexPending(certCode,
+                 appendRecord(stored.saleId, stored.createdAtMs, item, count, stored.totalAmount, FlagPrepaid, sourceDvm),
+                 true);
+    return stored;
+}
+
+void SalesLedger::restore(uint64_t saleId, int64_t createdAtMs, const Item &item, int count, int totalAmount,
+                          uint8_t flags, int sourceDvm, const string &certCode) {
+    RecordRef ref = appendRecord(saleId, createdAtMs, item, count, totalAmount, flags, sourceDvm);
+    if (!certCode.empty() && (flags & FlagPrepaid) && !(flags & (FlagReceived | FlagExpired))) {
+        indexPending(certCode, ref, true);
+    }
+}
+
+void SalesLedger::indexPending(const string &certCode, RecordRef ref, bool reserved) {
+    IndexShard &index = indexShard(certCode);
+    lock_guard<mutex> lock(index.indexMutex);
+    index.pending.emplace(certCode, PendingRef{ref, reserved});
+}
+
+vector<size_t> SalesLedger::shardSizes() const {
+    vector<size_t> sizes(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        lock_guard<mutex> lock(shards[i].shardMutex);
+        sizes[i] = shards[i].count;
+    }
+    return sizes;
+}
+
+SalesLedger::RecordRef SalesLedger::appendRecord(uint64_t saleId, int64_t createdAtMs, const Item &item, int count,
+                                                 int totalAmount, uint8_t flags, int sourceDvm) {
+    uint32_t shardIndex = (uint32_t)localShardIndex();
+    Shard &shard = shards[shardIndex];
+    lock_guard<mutex> lock(shard.shardMutex);
+    uint32_t recordIndex = (uint32_t)shard.count;
+    size_t at = shard.count % kChunkRecords;
+    if (at == 0) {
+        shard.chunks.push_back(make_unique<Chunk>());
+    }
+    Chunk &chunk = *shard.chunks.back();
+    chunk.saleIds[at] = saleId;
+    chunk.createdAt[at] = createdAtMs;
+    chunk.counts[at] = count;
+    chunk.totalAmounts[at] = totalAmount;
+    chunk.itemIndexes[at] = shard.internItem(item);
+    chunk.sourceDvms[at] = (uint16_t)sourceDvm;
+    chunk.flags[at] = flags;
+    ++shard.count;
+    return RecordRef{shardIndex, recordIndex};
+}
+
+bool SalesLedger::receivePrepaidItem(const string &certCode, int64_t *createdAtMs) {
+    return settlePrepaid(certCode, FlagReceived, createdAtMs);
+}
+
+bool SalesLedger::receiveUnreservedPrepaidItem(const string &certCode, int64_t *createdAtMs) {
+    return settlePrepaid(certCode, FlagReceived, createdAtMs, true);
+}
+
+bool SalesLedger::expirePrepaidItem(const string &certCode, int64_t *createdAtMs) {
+    return settlePrepaid(certCode, FlagExpired, createdAtMs);
+}
+
+bool SalesLedger::settlePrepaid(const string &certCode, uint8_t flag, int64_t *createdAtMs, bool unreservedOnly) {
+    IndexShard &index = indexShard(certCode);
+    lock_guard<mutex> lock(index.indexMutex);
+    // 같은 인증코드가 여러 번 기록된 경우 먼저 찾은 것을 쓴다
+    auto [found, last] = index.pending.equal_range(certCode);
+    while (found != last && unreservedOnly && found->second.reserved) {
+        ++found;
+    }
+    if (found == last) {
+        return false;
+    }
+    RecordRef ref = found->second.ref;
+    index.pending.erase(found);
+
+    Shard &shard = shards[ref.shard];
+    lock_guard<mutex> shardLock(shard.shardMutex);
+    flagsAt(shard, ref.index) |= flag;
+    if (createdAtMs) {
+        *createdAtMs = shard.chunks[ref.index / kChunkRecords]->createdAt[ref.index % kChunkRecords];
+    }
+    return true;
+}
+
+size_t SalesLedger::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shardCount; ++i) {
+        lock_guard<mutex> lock(shards[i].shardMutex);
+        total += shards[i].count;
+    }
+    return total;
+}
+
+size_t SalesLedger::getPendingPrepaidCount() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shardCount; ++i) {
+        lock_guard<mutex> lock(indexShards[i].indexMutex);
+        total += indexShards[i].pending.size();
+    }
+    return total;
+}
+
+SalesLedger::IndexShard &SalesLedger::indexShard(const string &certCode) const {
+    return indexShards[hash<string>{}(certCode) % shardCount];
+}
+
+uint8_t &SalesLedger::flagsAt(Shard &shard, uint32_t index) {
+    return shard.chunks[index / kChunkRecords]->flags[index % kChunkRecords];
+}
+
+size_t SalesLedger::localShardIndex() const {
+    static thread_local size_t threadHash = hash<thread::id>{}(this_thread::get_id());
+    return threadHash % shardCount;
+}
@@ -0,0 +1,210 @@
+#ifndef SALESLEDGER_H
+#define SALESLEDGER_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <memory_resource>
+#include "sale.h"
+
+using namespace std;
+
+// 여러 스레드가 동시에 판매를 기록하는 판매 장부
+// 장부를 여러 조각(shard)으로 나누고 스레드마다 다른 조각에 기록하여
+// 서로 관계없는 판매가 하나의 잠금에서 기다리지 않게 한다.
+// 판매는 Sale 객체로 보관하지 않고, 고정 크기 묶음(chunk)에 열(column)별 배열로 이어 붙인다.
+// 아이템은 조각마다 한 번만 저장하고 기록에는 그 번호만 남기므로 판매 하나는 29바이트이며,
+// 묶음은 한 번 할당되면 옮겨지지 않아 기록 위치가 바뀌지 않는다.
+// 아직 수령하지 않은 선결제 판매는 인증코드로 색인하여 판매 기록이 늘어도 바로 찾고,
+// 수령하거나 만료되면 상태 비트를 남기고 색인에서 지운다.
+class SalesLedger {
+public:
+    static constexpr size_t kChunkRecords = 1024;
+
+    // 기록의 상태 비트
+    // (FlagExpired: 수령하지 않아 만료되고 잡아 둔 재고가 돌아간 선결제)
+    enum Flag : uint8_t { FlagPrepaid = 1, FlagReceived = 2, FlagExpired = 4 };
+
+    // 방문할 때 열에서 모아 만드는 판매 한 건
+    struct Record {
+        uint64_t saleId;
+        int64_t createdAtMs;
+        const Item *item;
+        int count;
+        int totalAmount;
+        uint8_t flags;
+        int sourceDvm; // 판매를 받은 DVM (알 수 없으면 0)
+    };
+
+    // 묶음 하나의 열 배열을 복사하지 않고 보여 주는 view (size개가 유효하다)
+    struct Columns {
+        size_t size;
+        const uint64_t *saleIds;
+        const int64_t *createdAt;
+        const uint16_t *itemIndexes;
+        const int32_t *counts;
+        const int32_t *totalAmounts;
+        const uint8_t *flags;
+        const uint16_t *sourceDvms;
+    };
+
+    explicit SalesLedger(size_t shardCount = 8);
+
+    SalesLedger(const SalesLedger &) = delete;
+    SalesLedger &operator=(const SalesLedger &) = delete;
+
+    void append(const Sale &sale);
+    // Sale 객체를 만들지 않고 판매를 바로 기록하고 기록한 값을 반환한다 (인증코드 색인은 만들지 않는다)
+    Record record(const Item &item, int count, uint8_t flags = 0, int sourceDvm = 0);
+    // 다른 DVM에서 선결제된 판매를 기록하고 수령이나 만료를 표시할 수 있게 인증코드로 색인한다
+    Record recordPrepaid(const Item &item, int count, const string &certCode, int sourceDvm);
+    // 스냅샷이나 로그에서 읽은 판매를 그대로 다시 기록한다
+    // (certCode가 있고 아직 수령하거나 만료되지 않은 판매이면 인증코드로 색인한다)
+    void restore(uint64_t saleId, int64_t createdAtMs, const Item &item, int count, int totalAmount, uint8_t flags,
+                 int sourceDvm = 0, const string &certCode = {});
+
+    // 인증코드에 해당하는 선결제 판매가 있으면 수령 처리하고 true
+    // createdAtMs가 있으면 처리한 판매의 시각을 채운다 (내보낸 이력을 다시 쓸 날을 찾을 때 쓴다)
+    bool receivePrepaidItem(const string &certCode, int64_t *createdAtMs = nullptr);
+    // append로 받은 (인증코드 목록에 재고를 잡아 두지 않은) 선결제 판매만 수령 처리한다.
+    // recordPrepaid나 restore로 기록한 판매의 수령과 만료는 인증코드 목록이 정한다
+    bool receiveUnreservedPrepaidItem(const string &certCode, int64_t *createdAtMs = nullptr);
+    // 인증코드에 해당하는 선결제 판매가 있으면 만료 처리하고 true
+    bool expirePrepaidItem(const string &certCode, int64_t *createdAtMs = nullptr);
+
+    size_t size() const;
+    // 수령을 기다리는 선결제 판매 수
+    size_t getPendingPrepaidCount() const;
+
+    // 조각별 기록 수. forEach의 limits로 넘기면 이 시점까지의 기록만 방문한다
+    // (starts로 넘기면 이 시점 이후에 추가된 기록만 방문한다)
+    vector<size_t> shardSizes() const;
+
+    size_t getShardCount() const { return shardCount; }
+
+    // 조각 하나의 묶음마다 visit(묶음의 열, 조각의 아이템 목록)을 호출한다
+    // 시작할 때의 기록 수와 묶음 위치만 잠금 안에서 잡고 열은 잠금 밖에서 보여 주므로,
+    // 훑는 동안에도 같은 조각에 판매를 기록할 수 있다 (그 판매는 방문하지 않는다).
+    // 기록 후에도 바뀌는 상태 비트 열만 묶음마다 잠깐 잠가 복사한다.
+    template <typename Visit>
+    void forEachChunk(size_t shardIndex, Visit &&visit) const {
+        const Shard &shard = shards[shardIndex];
+        size_t count;
+        vector<const Chunk *> chunks;
+        vector<Item> items;
+        {
+            lock_guard<mutex> lock(shard.shardMutex);
+            count = shard.count;
+            chunks.reserve(shard.chunks.size());
+            for (const auto &chunk : shard.chunks) {
+                chunks.push_back(chunk.get());
+            }
+            items = shard.items;
+        }
+        uint8_t flags[kChunkRecords];
+        for (size_t start = 0; start < count; start += kChunkRecords) {
+            const Chunk &chunk = *chunks[start / kChunkRecords];
+            size_t size = count - start < kChunkRecords ? count - start : kChunkRecords;
+            {
+                lock_guard<mutex> lock(shard.shardMutex);
+                memcpy(flags, chunk.flags, size);
+            }
+            visit(Columns{size, chunk.saleIds, chunk.createdAt, chunk.itemIndexes, chunk.counts, chunk.totalAmounts,
+                          flags, chunk.sourceDvms},
+                  items);
+        }
+    }
+
+    // 수령을 기다리는 선결제마다 visit(인증코드, 판매 ID)를 호출한다
+    template <typename Visit>
+    void forEachPending(Visit &&visit) const {
+        for (size_t i = 0; i < shardCount; ++i) {
+            lock_guard<mutex> lock(indexShards[i].indexMutex);
+            for (const auto &[certCode, pending] : indexShards[i].pending) {
+                const RecordRef &ref = pending.ref;
+                const Shard &shard = shards[ref.shard];
+                lock_guard<mutex> shardLock(shard.shardMutex);
+                visit(certCode, shard.chunks[ref.index / kChunkRecords]->saleIds[ref.index % kChunkRecords]);
+            }
+        }
+    }
+
+    // 조각 순서, 조각 안에서는 기록 순서로 판매를 방문한다
+    template <typename Visit>
+    void forEach(Visit &&visit, const vector<size_t> &limits = {}, const vector<size_t> &starts = {}) const {
+        for (size_t s = 0; s < shardCount; ++s) {
+            const Shard &shard = shards[s];
+            lock_guard<mutex> lock(shard.shardMutex);
+            size_t count = s < limits.size() && limits[s] < shard.count ? limits[s] : shard.count;
+            for (size_t i = s < starts.size() ? starts[s] : 0; i < count; ++i) {
+                const Chunk &chunk = *shard.chunks[i / kChunkRecords];
+                size_t at = i % kChunkRecords;
+                visit(Record{chunk.saleIds[at], chunk.createdAt[at], &shard.items[chunk.itemIndexes[at]],
+                             chunk.counts[at], chunk.totalAmounts[at], chunk.flags[at], chunk.sourceDvms[at]});
+            }
+        }
+    }
+
+private:
+    // 열별 배열 묶음. 같은 열을 훑을 때 이웃한 기록이 같은 캐시 라인에 있다
+    struct Chunk {
+        uint64_t saleIds[kChunkRecords];
+        int64_t createdAt[kChunkRecords];
+        int32_t counts[kChunkRecords];
+        int32_t totalAmounts[kChunkRecords];
+        uint16_t itemIndexes[kChunkRecords];
+        uint16_t sourceDvms[kChunkRecords];
+        uint8_t flags[kChunkRecords];
+    };
+
+    // 인접한 조각의 잠금이 같은 캐시 라인을 나눠 쓰지 않게 한다
+    struct alignas(64) Shard {
+        mutable mutex shardMutex;
+        vector<unique_ptr<Chunk>> chunks;
+        size_t count = 0;
+        // 이 조각에 기록된 아이템과 코드 -> 아이템 번호
+        vector<Item> items;
+        unordered_map<string, uint16_t> itemIndexByCode;
+
+        uint16_t internItem(const Item &item);
+    };
+
+    // 기록 위치 (조각 번호, 조각 안 순번)
+    struct RecordRef {
+        uint32_t shard;
+        uint32_t index;
+    };
+
+    // 수령 전 선결제 판매의 위치와, 인증코드 목록이 그 재고를 잡아 두었는지 여부
+    struct PendingRef {
+        RecordRef ref;
+        bool reserved;
+    };
+
+    // 인증코드 -> 수령 전 판매
+    // 지운 노드는 풀에 모아 다시 쓰므로 선결제 저장과 수령이 이어져도 할당이 없다
+    struct alignas(64) IndexShard {
+        mutable mutex indexMutex;
+        pmr::unsynchronized_pool_resource nodePool;
+        pmr::unordered_multimap<string, PendingRef> pending{&nodePool};
+    };
+
+    size_t shardCount;
+    unique_ptr<Shard[]> shards;
+    unique_ptr<IndexShard[]> indexShards;
+
+    // 현재 스레드의 조각에 기록하고 (조각 번호, 순번)을 반환
+    RecordRef appendRecord(uint64_t saleId, int64_t createdAtMs, const Item &item, int count, int totalAmount,
+                           uint8_t flags, int sourceDvm);
+    void indexPending(const string &certCode, RecordRef ref, bool reserved);
+    // 인증코드에 해당하는 판매에 flag를 남기고 색인에서 지운다 (unreservedOnly이면 append로 받은 판매만)
+    bool settlePrepaid(const string &certCode, uint8_t flag, int64_t *createdAtMs, bool unreservedOnly = false);
+    size_t localShardIndex() const;
+    IndexShard &indexShard(const string &certCode) const;
+    uint8_t &flagsAt(Shard &shard, uint32_t index);
+};
+
+#endif // SALESLEDGER_H
@@ -0,0 +1,73 @@
+#include "stocktable.h"
+
+StockTable::StockTable(const map<Item, int> &initial) {
+    int overflowCount = 0;
+    for (const auto &[item, count] : initial) {
+        if (denseIndex(item.getItemCode()) < 0) {
+            ++overflowCount;
+        }
+    }
+
+    slotCount = kDenseSlots + overflowCount;
+    counters.reset(new Counter[slotCount]);
+    metas.reset(new Meta[slotCount]);
+    overflow.reserve(overflowCount);
+    ordered.reserve(initial.size());
+
+    // map은 코드 순서이므로 ordered도 코드 순서가 된다
+    for (const auto &[item, count] : initial) {
+        int slot = denseIndex(item.getItemCode());
+        if (slot < 0) {
+            slot = kDenseSlots + (int)overflow.size();
+            overflow.emplace_back(item.getItemCode(), slot);
+        }
+        counters[slot].count.store(count, memory_order_relaxed);
+        metas[slot].item = make_unique<Item>(item);
+        metas[slot].published = count;
+        ordered.push_back(slot);
+    }
+}
+
+int StockTable::find(string_view itemCode) const {
+    int slot = denseIndex(itemCode);
+    if (slot >= 0) {
+        return metas[slot].item ? slot : -1;
+    }
+    for (const auto &[code, overflowSlot] : overflow) {
+        if (code == itemCode) {
+            return overflowSlot;
+        }
+    }
+    return -1;
+}
+
+const Item *StockTable::item(int slot) const {
+    return slot >= 0 && slot < slotCount ? metas[slot].item.get() : nullptr;
+}
+
+int StockTable::load(int slot) const {
+    return counters[slot].count.load(memory_order_acquire);
+}
+
+bool StockTable::tryTake(int slot, int amount) {
+    atomic<int> &count = counters[slot].count;
+    int current = count.load(memory_order_relaxed);
+    do {
+        if (current < amount) {
+            return false;
+        }
+    } while (!count.compare_exchange_weak(current, current - amount, memory_order_acq_rel, memory_order_relaxed));
+    return true;
+}
+
+void StockTable::add(int slot, int amount) {
+    counters[slot].count.fetch_add(amount, memory_order_acq_rel);
+}
+
+int StockTable::denseIndex(string_view itemCode) {
+    if (itemCode.size() != 2 || itemCode[0] < '0' || itemCode[0] > '9' ||
+        itemCode[1] < '0' || itemCode[1] > '9') {
+        return -1;
+    }
+    return (itemCode[0] - '0') * 10 + (itemCode[1] - '0');
+}
@@ -0,0 +1,85 @@
+#ifndef STOCKTABLE_H
+#define STOCKTABLE_H
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include "../domain/item.h"
+
+using namespace std;
+
+// 아이템 코드로 바로 찾는 재고 표
+// 두 자리 숫자 코드("01"~"99")는 코드 값을 그대로 배열 위치로 써서 한 번의 배열 접근으로 찾고,
+// 그 밖의 코드는 생성 시 정한 뒤쪽 칸을 순서대로 찾는다. 아이템 구성은 생성 후 바뀌지 않는다.
+// 수량은 칸마다 캐시 라인 하나를 차지하는 atomic 값으로, 잠금 없이 비교-감소(CAS)한다.
+class StockTable {
+public:
+    static constexpr int kDenseSlots = 100;
+
+    explicit StockTable(const map<Item, int> &initial);
+
+    StockTable(const StockTable &) = delete;
+    StockTable &operator=(const StockTable &) = delete;
+
+    // 코드에 해당하는 칸 번호 (없으면 -1)
+    int find(string_view itemCode) const;
+
+    // 해당 칸의 아이템 (없는 칸이면 nullptr)
+    const Item *item(int slot) const;
+    int load(int slot) const;
+
+    // amount개를 잠금 없이 꺼낸다. 재고가 부족하면 아무것도 바꾸지 않고 false
+    bool tryTake(int slot, int amount);
+    void add(int slot, int amount);
+
+    // 마지막으로 알린 뒤 수량이 바뀌었으면 onChange(알린 수량, 현재 수량)를 호출한다.
+    // 같은 칸의 알림은 칸의 잠금 안에서 차례로 호출되므로 순서가 뒤바뀌지 않고,
+    // 동시에 일어난 변경은 하나의 알림으로 합쳐질 수 있다.
+    template <typename OnChange>
+    void publish(int slot, OnChange &&onChange) {
+        Meta &meta = metas[slot];
+        lock_guard<mutex> lock(meta.publishMutex);
+        int current = load(slot);
+        if (current != meta.published) {
+            int before = meta.published;
+            meta.published = current;
+            onChange(before, current);
+        }
+    }
+
+    // 코드 순서로 (아이템, 수량)을 방문
+    template <typename Visit>
+    void forEach(Visit &&visit) const {
+        for (int slot : ordered) {
+            visit(*metas[slot].item, load(slot));
+        }
+    }
+
+private:
+    // 칸마다 캐시 라인을 따로 써서 다른 아이템의 구매가 서로의 캐시 라인을 무효화하지 않게 한다
+    struct alignas(64) Counter {
+        atomic<int> count{0};
+    };
+    struct Meta {
+        unique_ptr<Item> item;
+        mutex publishMutex;
+        int published = 0;
+    };
+
+    int slotCount;
+    unique_ptr<Counter[]> counters;
+    unique_ptr<Meta[]> metas;
+    // 두 자리 숫자가 아닌 코드와 그 칸 번호
+    vector<pair<string, int>> overflow;
+    // 코드 순서의 칸 번호
+    vector<int> ordered;
+
+    static int denseIndex(string_view itemCode);
+};
+
+#endif // STOCKTABLE_H
@@ -0,0 +1,80 @@
+#include "subscriptionregistry.h"
+#include <algorithm>
+#include <iterator>
+
+void SubscriptionRegistry::subscribe(int subscriberId, const string &itemCode, int threshold, int leaseMs) {
+    if (leaseMs <= 0) {
+        return;
+    }
+    auto expiresAt = chrono::steady_clock::now() + chrono::milliseconds(leaseMs);
+    lock_guard<mutex> lock(registryMutex);
+    auto [found, inserted] = subscriptions[itemCode].insert_or_assign(subscriberId, Subscription{max(threshold, 1), expiresAt});
+    if (inserted) {
+        countOf(itemCode).fetch_add(1, memory_order_release);
+    }
+}
+
+void SubscriptionRegistry::unsubscribe(int subscriberId) {
+    lock_guard<mutex> lock(registryMutex);
+    for (auto it = subscriptions.begin(); it != subscriptions.end();) {
+        if (it->second.erase(subscriberId) > 0) {
+            countOf(it->first).fetch_sub(1, memory_order_relaxed);
+        }
+        it = it->second.empty() ? subscriptions.erase(it) : next(it);
+    }
+}
+
+vector<SubscriptionRegistry::Notification> SubscriptionRegistry::collectChanges(const string &itemCode, int before, int after) {
+    vector<Notification> notifications;
+    if (before == after || !hasSubscribers(itemCode)) {
+        return notifications;
+    }
+
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(registryMutex);
+    auto item = subscriptions.find(itemCode);
+    if (item == subscriptions.end()) {
+        return notifications;
+    }
+
+    auto &subscribers = item->second;
+    for (auto it = subscribers.begin(); it != subscribers.end();) {
+        if (now >= it->second.expiresAt) {
+            it = subscribers.erase(it);
+            countOf(itemCode).fetch_sub(1, memory_order_relaxed);
+            continue;
+        }
+        if (band(before, it->second.threshold) != band(after, it->second.threshold)) {
+            notifications.push_back(Notification{it->first, itemCode, after, it->second.threshold});
+        }
+        ++it;
+    }
+    if (subscribers.empty()) {
+        subscriptions.erase(item);
+    }
+    return notifications;
+}
+
+bool SubscriptionRegistry::hasSubscribers(const string &itemCode) const {
+    return subscriberCounts[hash<string>{}(itemCode) % kCountSlots].load(memory_order_acquire) > 0;
+}
+
+atomic<int> &SubscriptionRegistry::countOf(const string &itemCode) {
+    return subscriberCounts[hash<string>{}(itemCode) % kCountSlots];
+}
+
+size_t SubscriptionRegistry::size() const {
+    lock_guard<mutex> lock(registryMutex);
+    size_t count = 0;
+    for (const auto &[itemCode, subscribers] : subscriptions) {
+        count += subscribers.size();
+    }
+    return count;
+}
+
+int SubscriptionRegistry::band(int count, int threshold) {
+    if (count <= 0) {
+        return 0;
+    }
+    return count < threshold ? 1 : 2;
+}
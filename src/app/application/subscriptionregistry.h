@@ -0,0 +1,58 @@
+#ifndef SUBSCRIPTIONREGISTRY_H
+#define SUBSCRIPTIONREGISTRY_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+// 이 DVM의 재고 변화를 알려 달라고 구독한 다른 DVM 목록
+// 구독자는 아이템마다 threshold를 정하고, 재고가 0개 / threshold 미만 / threshold 이상
+// 구간 사이를 옮겨 갈 때만 알림을 받는다. 구독은 lease 기간이 지나면 사라지므로
+// 구독자는 주기적으로 다시 구독해야 한다.
+class SubscriptionRegistry {
+public:
+    struct Notification {
+        int subscriberId;
+        string itemCode;
+        int itemNum;
+        int threshold;
+    };
+
+    void subscribe(int subscriberId, const string &itemCode, int threshold, int leaseMs);
+    void unsubscribe(int subscriberId);
+
+    // 재고가 before에서 after로 바뀌었을 때 알림을 보내야 하는 구독자 목록
+    // 아이템에 구독자가 없으면 잠금 없이 바로 돌아간다
+    vector<Notification> collectChanges(const string &itemCode, int before, int after);
+
+    // 아이템에 구독자가 있을 수 있으면 true (잠금 없이 확인하며, 다른 아이템과 칸을 나눠 쓰면 true일 수 있다)
+    bool hasSubscribers(const string &itemCode) const;
+
+    size_t size() const;
+
+    // 재고 구간 (0: 없음, 1: threshold 미만, 2: threshold 이상)
+    static int band(int count, int threshold);
+
+private:
+    struct Subscription {
+        int threshold;
+        chrono::steady_clock::time_point expiresAt;
+    };
+
+    static constexpr size_t kCountSlots = 128;
+
+    mutable mutex registryMutex;
+    // 아이템 코드 -> (구독자 ID -> 구독)
+    map<string, map<int, Subscription>> subscriptions;
+    // 아이템 코드의 해시 칸마다 구독 수 (registryMutex 안에서만 바꾼다)
+    atomic<int> subscriberCounts[kCountSlots] = {};
+
+    atomic<int> &countOf(const string &itemCode);
+};
+
+#endif // SUBSCRIPTIONREGISTRY_H
@@ -0,0 +1,45 @@
+#include "certcodegenerator.h"
+#include <random>
+#include <thread>
+#include <functional>
+
+namespace
+{
+    const char kCharacters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    std::mt19937_64 &threadEngine()
+    {
+        // 스레드의 첫 호출에서만 시드한다. 같은 시각에 시작한 스레드끼리 같은 수열을 쓰지 않도록
+        // random_device 값에 스레드 ID를 섞는다.
+        thread_local std::mt19937_64 engine([] {
+            std::random_device device;
+            std::seed_seq seed{device(), device(), device(), device(),
+                               static_cast<unsigned int>(std::hash<std::thread::id>{}(std::this_thread::get_id()))};
+            return std::mt19937_64(seed);
+        }());
+        return engine;
+    }
+}
+
+uint32_t CertCodeGenerator::nextValue()
+{
+    // kCodeSpace의 배수 범위 밖의 값은 버려 나머지 연산의 치우침을 없앤다
+    constexpr uint64_t limit = UINT64_MAX - UINT64_MAX % kCodeSpace;
+    std::mt19937_64 &engine = threadEngine();
+    uint64_t value;
+    do
+    {
+        value = engine();
+    } while (value >= limit);
+    return static_cast<uint32_t>(value % kCodeSpace);
+}
+
+void CertCodeGenerator::generate(char (&out)[kLength])
+{
+    uint32_t value = nextValue();
+    for (size_t i = 0; i < kLength; ++i)
+    {
+        out[i] = kCharacters[value % 62];
+        value /= 62;
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef CERTCODEGENERATOR_H
+#define CERTCODEGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 선결제 인증코드 생성기
+// 스레드마다 한 번만 시드한 난수 엔진을 재사용하고, 62^5 범위의 균등한 값 하나로
+// 5자리 코드를 만든다. 호출자가 준 고정 크기 버퍼에 쓰므로 힙 할당이 없다.
+// 서로 다른 DVM이 만든 코드의 중복은 받는 쪽 등록부가 거절하고 요청한 쪽이 다시 만든다.
+namespace CertCodeGenerator {
+    constexpr size_t kLength = 5;
+    // 코드 하나가 가질 수 있는 값의 수 (62^5)
+    constexpr uint32_t kCodeSpace = 62u * 62u * 62u * 62u * 62u;
+
+    // [0, kCodeSpace) 범위의 균등한 값
+    uint32_t nextValue();
+
+    // out에 5자리 코드를 쓴다 (널 문자를 붙이지 않음)
+    void generate(char (&out)[kLength]);
+}
+
+#endif // CERTCODEGENERATOR_H
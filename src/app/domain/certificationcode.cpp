@@ -1,23 +1,12 @@
 #include "certificationcode.h"
-#include <random>
-#include <chrono>
+#include "certcodegenerator.h"
 
 CertificationCode::CertificationCode()
 {
-    // 랜덤 5자리 인증코드 생성
-    const std::string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-    const int codeLength = 5;
-
-    std::mt19937 rng(static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count()));
-    std::uniform_int_distribution<int> dist(0, characters.size() - 1);
-
-    value = "";
-
-    for (int i = 0; i < codeLength; ++i)
-    {
-        value += characters[dist(rng)];
-    }
-
+    // 랜덤 5자리 인증코드 생성 (짧은 문자열이라 힙 할당 없이 저장된다)
+    char code[CertCodeGenerator::kLength];
+    CertCodeGenerator::generate(code);
+    value.assign(code, CertCodeGenerator::kLength);
     isUsed = false;
 }
 
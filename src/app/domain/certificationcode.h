@@ -13,6 +13,7 @@ public:
     CertificationCode();
     CertificationCode(std::string value);
     bool markUsed(const std::string& certCode);
+    const std::string& getValue() const { return value; }
 
     friend std::ostream& operator<<(std::ostream& os, const CertificationCode& code) {
         return os << code.value;
@@ -21,8 +21,8 @@ public:
     }
 
     // Add getters (for tests)
-    std::string getItemCode() const { return itemCode; }
-    std::string getName() const { return name; }
+    const std::string& getItemCode() const { return itemCode; }
+    const std::string& getName() const { return name; }
     int getPrice() const { return price; }
 };
 
@@ -14,6 +14,7 @@ public:
     explicit Prepayment(int dvmId);
     explicit Prepayment(int dvmId, CertificationCode certCode);
     bool isCertificationCode(const std::string &inputCertCode);
+    const std::string &getCertCode() const { return certCode.getValue(); }
 };
 
 #endif // PREPAYMENT_H
\ No newline at end of file
@@ -2,7 +2,10 @@
 #include <sstream> 
 #include <map>
 #include <vector>
+#include <cstdint>
+#include <climits>
 #include "domain/item.h"
+#include "network/messageparser.h"
 
 using namespace std;
 
@@ -13,6 +16,51 @@ struct Config
 {
     const char* target_ip = "172.20.10.2";
     int port = 9001;
+    // 피어 요청을 처리하는 워커 스레드 수와 대기 큐 크기
+    int workerThreads = 1;
+    int workerQueueCapacity = 1024;
+    // 서버가 유휴 keep-alive 연결을 유지하는 시간
+    int serverIdleTimeoutMs = 30000;
+    // 피어별 연결 풀: 최대 유휴 연결 수와 유휴 연결 재사용 제한 시간
+    // (서버의 유휴 제한 시간보다 짧아야 끊긴 연결 재사용이 줄어든다)
+    int peerPoolMaxIdle = 4;
+    int peerPoolMaxIdleMs = 10000;
+    // 다른 DVM들에 재고를 병렬 조회할 때 전체 조회에 허용하는 시간
+    int peerQueryDeadlineMs = 3000;
+    // 다른 DVM의 재고 조회 결과를 재사용하는 시간 (0이면 캐시하지 않음)
+    int peerStockCacheTtlMs = 2000;
+    // 다른 DVM에 재고 변화 알림을 구독하는 기간. 절반이 지날 때마다 갱신한다 (0이면 구독하지 않음)
+    int peerSubscriptionLeaseMs = 60000;
+    // 구독 알림을 받을 재고 구간의 경계 (0개, threshold 미만, threshold 이상)
+    int peerSubscriptionThreshold = 5;
+    // 재고 가십: 주기, 한 번에 교환할 피어 수, 한 응답에 담는 최대 항목 수 (주기가 0이면 끔)
+    int gossipIntervalMs = 1000;
+    int gossipFanout = 2;
+    // (한 번에 다 보내지 못한 항목은 다음 주기에 먼저 보낸다)
+    int gossipMaxEntries = 24;
+    // 가십으로 받은 다른 DVM의 재고를 조회에 사용하는 시간
+    int gossipMaxAgeMs = 10000;
+    // 수령하지 않은 선결제 인증코드의 유효 기간과 만료 처리 간격 (유효 기간이 0이면 만료하지 않음)
+    int certCodeExpiryMs = 24 * 60 * 60 * 1000;
+    int certExpiryTickMs = 60 * 1000;
+    // 피어와 길이 프리픽스 프레임으로 통신할지 여부 (기존 텍스트 프로토콜 피어와 호환하려면 false)
+    bool peerFraming = false;
+    // 피어 요청을 바이너리 codec으로 보낼지 여부 (프레임 모드를 함께 사용)
+    bool peerBinaryCodec = false;
+    // 프레임 하나에 허용하는 최대 payload 크기
+    int maxFrameBytes = 1 << 20;
+    // 재고와 판매를 기록하는 선행 기록 로그 파일 (비어 있으면 기록하지 않음)
+    string walPath;
+    // 로그를 fdatasync로 디스크까지 내보낼지 여부
+    bool walSync = true;
+    // 상태 스냅샷 파일과 쓰는 간격 (경로가 비어 있으면 쓰지 않음)
+    string snapshotPath;
+    int snapshotIntervalMs = 60 * 1000;
+    // 판매 이력을 하루 단위 열 형식 파일로 내보낼 디렉터리와 간격 (경로가 비어 있으면 내보내지 않음)
+    string historyDir;
+    int historyExportIntervalMs = 5 * 60 * 1000;
+    // 판매 통계를 계산할 때 쓰는 최대 스레드 수 (판매 기록이 적으면 더 적게 쓴다)
+    int statsThreads = 1;
     
     static Config &get()
     {
@@ -43,14 +91,24 @@ struct SocketMessage
     string msg_type;
     string src_id;
     string dst_id;
+    // 한 연결에서 여러 요청을 보낼 때 응답을 구분하기 위한 식별자 (비어 있으면 보내지 않음)
+    string req_id;
     map<string, string> msg_content;
 
+    // 한 번의 recv보다 길 수 있는 응답(resp_stats)의 마지막 필드
+    // 프레임 없이 받을 때 이 필드가 도착할 때까지 읽어 잘린 응답과 구분한다
+    static constexpr string_view kEndField = "end:1;";
+
     string serialize() const
     {
         ostringstream oss;
         oss << "msg_type:" << msg_type << ";"
             << "src_id:" << src_id << ";"
             << "dst_id:" << dst_id << ";";
+        if (!req_id.empty())
+        {
+            oss << "req_id:" << req_id << ";";
+        }
         for (const auto &[key, value] : msg_content)
         {
             oss << key << ":" << value << ";";
@@ -61,23 +119,20 @@ struct SocketMessage
     static SocketMessage deserialize(const string &raw)
     {
         SocketMessage msg;
-        istringstream iss(raw);
-        string token;
-        while (getline(iss, token, ';'))
+        MessageParser parser(raw);
+        string_view key, value;
+        while (parser.next(key, value))
         {
-            size_t pos = token.find(':');
-            if (pos == string::npos)
-                continue;
-            string key = token.substr(0, pos);
-            string value = token.substr(pos + 1);
             if (key == "msg_type")
                 msg.msg_type = value;
             else if (key == "src_id")
                 msg.src_id = value;
             else if (key == "dst_id")
                 msg.dst_id = value;
+            else if (key == "req_id")
+                msg.req_id = value;
             else
-                msg.msg_content[key] = value;
+                msg.msg_content[string(key)] = value;
         }
         return msg;
     }
@@ -102,16 +157,324 @@ struct CheckStockResponse {
     int coor_y;
 };
 
+// 이 DVM의 재고만으로 판단한 결과 (다른 DVM에는 묻지 않는다)
+struct LocalStockEvaluation {
+    string item_code;
+    int requested;
+    int on_hand;      // 현재 재고 (취급하지 않는 아이템이면 0)
+    bool sufficient;  // 요청 수량을 모두 줄 수 있는지
+};
+
+// 여러 아이템을 한 번에 조회하는 묶음 조회 응답
+// items의 item_num은 해당 DVM이 요청 수량을 모두 줄 수 있으면 요청 수량, 아니면 0
+struct CheckStockBatchResponse {
+    int dst_id;
+    vector<CheckStockRequest> items;
+    int coor_x;
+    int coor_y;
+};
+
+// 묶음 조회 메시지의 items 필드 ("01=3,02=1")
+struct StockBatchField {
+    static string format(const vector<CheckStockRequest> &items)
+    {
+        string out;
+        for (const auto &item : items)
+        {
+            if (!out.empty())
+                out += ',';
+            out += item.item_code;
+            out += '=';
+            out += to_string(item.item_num);
+        }
+        return out;
+    }
+
+    static vector<CheckStockRequest> parse(string_view field)
+    {
+        vector<CheckStockRequest> items;
+        while (!field.empty())
+        {
+            size_t end = field.find(',');
+            string_view entry = field.substr(0, end);
+            field = end == string_view::npos ? string_view() : field.substr(end + 1);
+
+            size_t eq = entry.find('=');
+            if (eq == string_view::npos || eq == 0)
+                continue;
+            items.push_back(CheckStockRequest{string(entry.substr(0, eq)),
+                                              MessageParser::toIntOr(entry.substr(eq + 1), 0)});
+        }
+        return items;
+    }
+};
+
+// 가십으로 주고받는 한 DVM의 재고 (version은 해당 DVM이 재고가 바뀔 때마다 올린다)
+struct InventoryEntry {
+    int dvm_id;
+    uint64_t version;
+    vector<CheckStockRequest> stocks;
+};
+
+// 가십 메시지의 digest 필드 ("1=17,2=9": DVM ID=알고 있는 version)와
+// entries 필드 ("2@9@01=3,02=0|3@4@01=1": DVM ID@version@재고, 항목은 '|'로 구분)
+struct GossipField {
+    static string formatDigest(const map<int, uint64_t> &digest)
+    {
+        string out;
+        for (const auto &[dvmId, version] : digest)
+        {
+            if (!out.empty())
+                out += ',';
+            out += to_string(dvmId);
+            out += '=';
+            out += to_string(version);
+        }
+        return out;
+    }
+
+    static map<int, uint64_t> parseDigest(string_view field)
+    {
+        map<int, uint64_t> digest;
+        while (!field.empty())
+        {
+            size_t end = field.find(',');
+            string_view entry = field.substr(0, end);
+            field = end == string_view::npos ? string_view() : field.substr(end + 1);
+
+            size_t eq = entry.find('=');
+            int dvmId;
+            uint64_t version;
+            if (eq != string_view::npos && MessageParser::toInt(entry.substr(0, eq), dvmId) &&
+                MessageParser::toInt(entry.substr(eq + 1), version))
+                digest[dvmId] = version;
+        }
+        return digest;
+    }
+
+    static string formatEntries(const vector<InventoryEntry> &entries)
+    {
+        string out;
+        for (const auto &entry : entries)
+        {
+            if (!out.empty())
+                out += '|';
+            out += to_string(entry.dvm_id);
+            out += '@';
+            out += to_string(entry.version);
+            out += '@';
+            out += StockBatchField::format(entry.stocks);
+        }
+        return out;
+    }
+
+    static vector<InventoryEntry> parseEntries(string_view field)
+    {
+        vector<InventoryEntry> entries;
+        while (!field.empty())
+        {
+            size_t end = field.find('|');
+            string_view entry = field.substr(0, end);
+            field = end == string_view::npos ? string_view() : field.substr(end + 1);
+
+            size_t first = entry.find('@');
+            size_t second = first == string_view::npos ? first : entry.find('@', first + 1);
+            InventoryEntry parsed{};
+            if (second == string_view::npos ||
+                !MessageParser::toInt(entry.substr(0, first), parsed.dvm_id) ||
+                !MessageParser::toInt(entry.substr(first + 1, second - first - 1), parsed.version))
+                continue;
+            parsed.stocks = StockBatchField::parse(entry.substr(second + 1));
+            entries.push_back(move(parsed));
+        }
+        return entries;
+    }
+};
+
 struct askPrepaymentRequest {
     string item_code;
     int item_num;
     string cert_code;
+    // 선결제를 받은 DVM (판매 기록의 출처로 남긴다. 알 수 없으면 0)
+    int src_id = 0;
 };
 
 struct askPrepaymentResponse {
     string item_code;
     int item_num;
     bool availability;
+    // 상대 DVM에 아직 수령되지 않은 같은 인증코드가 있어 거절된 경우 (새 코드로 다시 요청)
+    bool duplicate_code = false;
+};
+
+// 판매 통계 조회 조건 (req_stats). 비워 둔 조건은 모든 판매에 맞는다
+struct SalesQuery {
+    int64_t from_ms = INT64_MIN; // 이 시각 이상 (Unix ms)
+    int64_t to_ms = INT64_MAX;   // 이 시각 미만
+    string item_code;
+    int source_dvm = -1;         // 판매를 받은 DVM (음수이면 모든 DVM)
+};
+
+struct ItemSalesTotals {
+    int64_t sales = 0;
+    int64_t units = 0;
+    int64_t revenue = 0;
+};
+
+// 다른 DVM에서 선결제되어 이 DVM이 내주기로 한 판매 (결제받은 DVM별)
+struct SourceSalesTotals {
+    int64_t prepaid = 0;
+    int64_t redeemed = 0;
+    int64_t expired = 0;
+};
+
+// 판매 통계. 만료되어 재고가 돌아간 선결제는 판매, 수량, 매출에서 빼고 sources에서만 센다
+struct SalesStats {
+    int64_t sales = 0;
+    int64_t units = 0;
+    int64_t revenue = 0;
+    int64_t prepaid = 0; // 선결제 판매 수 (나머지는 직접 판매)
+    map<string, ItemSalesTotals> items;
+    map<int64_t, int64_t> units_by_hour; // 시간의 시작 시각 (Unix ms) -> 수량
+    map<int, SourceSalesTotals> sources;
+
+    // 판매 중 선결제의 비율 (판매가 없으면 0)
+    double prepaidRatio() const
+    {
+        return sales > 0 ? (double)prepaid / sales : 0.0;
+    }
+
+    void merge(const SalesStats &other)
+    {
+        sales += other.sales;
+        units += other.units;
+        revenue += other.revenue;
+        prepaid += other.prepaid;
+        for (const auto &[code, totals] : other.items)
+        {
+            ItemSalesTotals &mine = items[code];
+            mine.sales += totals.sales;
+            mine.units += totals.units;
+            mine.revenue += totals.revenue;
+        }
+        for (const auto &[hour, count] : other.units_by_hour)
+            units_by_hour[hour] += count;
+        for (const auto &[dvmId, totals] : other.sources)
+        {
+            SourceSalesTotals &mine = sources[dvmId];
+            mine.prepaid += totals.prepaid;
+            mine.redeemed += totals.redeemed;
+            mine.expired += totals.expired;
+        }
+    }
+};
+
+// 통계 응답의 필드
+// items: "01=3/5/5000,04=1/1/1500" (아이템 코드=판매/수량/매출)
+// hours: "1700000000000=4,1700003600000=2" (시간의 시작 시각=수량)
+// sources: "2=3/1/0" (결제받은 DVM ID=선결제/수령/만료)
+struct StatsField {
+    static string formatItems(const map<string, ItemSalesTotals> &items)
+    {
+        string out;
+        for (const auto &[code, totals] : items)
+        {
+            if (!out.empty())
+                out += ',';
+            out += code + '=' + to_string(totals.sales) + '/' + to_string(totals.units) + '/' +
+                   to_string(totals.revenue);
+        }
+        return out;
+    }
+
+    static map<string, ItemSalesTotals> parseItems(string_view field)
+    {
+        map<string, ItemSalesTotals> items;
+        forEachEntry(field, [&items](string_view key, string_view value) {
+            int64_t parts[3];
+            if (!key.empty() && parseParts(value, parts))
+                items[string(key)] = ItemSalesTotals{parts[0], parts[1], parts[2]};
+        });
+        return items;
+    }
+
+    static string formatHours(const map<int64_t, int64_t> &hours)
+    {
+        string out;
+        for (const auto &[hour, units] : hours)
+        {
+            if (!out.empty())
+                out += ',';
+            out += to_string(hour) + '=' + to_string(units);
+        }
+        return out;
+    }
+
+    static map<int64_t, int64_t> parseHours(string_view field)
+    {
+        map<int64_t, int64_t> hours;
+        forEachEntry(field, [&hours](string_view key, string_view value) {
+            int64_t hour, units;
+            if (MessageParser::toInt(key, hour) && MessageParser::toInt(value, units))
+                hours[hour] = units;
+        });
+        return hours;
+    }
+
+    static string formatSources(const map<int, SourceSalesTotals> &sources)
+    {
+        string out;
+        for (const auto &[dvmId, totals] : sources)
+        {
+            if (!out.empty())
+                out += ',';
+            out += to_string(dvmId) + '=' + to_string(totals.prepaid) + '/' + to_string(totals.redeemed) + '/' +
+                   to_string(totals.expired);
+        }
+        return out;
+    }
+
+    static map<int, SourceSalesTotals> parseSources(string_view field)
+    {
+        map<int, SourceSalesTotals> sources;
+        forEachEntry(field, [&sources](string_view key, string_view value) {
+            int dvmId;
+            int64_t parts[3];
+            if (MessageParser::toInt(key, dvmId) && parseParts(value, parts))
+                sources[dvmId] = SourceSalesTotals{parts[0], parts[1], parts[2]};
+        });
+        return sources;
+    }
+
+private:
+    // ','로 구분한 "키=값" 항목마다 visit(키, 값)
+    template <typename Visit>
+    static void forEachEntry(string_view field, Visit &&visit)
+    {
+        while (!field.empty())
+        {
+            size_t end = field.find(',');
+            string_view entry = field.substr(0, end);
+            field = end == string_view::npos ? string_view() : field.substr(end + 1);
+
+            size_t eq = entry.find('=');
+            if (eq != string_view::npos)
+                visit(entry.substr(0, eq), entry.substr(eq + 1));
+        }
+    }
+
+    // "a/b/c"
+    static bool parseParts(string_view value, int64_t (&parts)[3])
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            size_t end = i < 2 ? value.find('/') : value.size();
+            if (end == string_view::npos || !MessageParser::toInt(value.substr(0, end), parts[i]))
+                return false;
+            value = i < 2 ? value.substr(end + 1) : string_view();
+        }
+        return true;
+    }
 };
 
 #endif 
\ No newline at end of file
@@ -10,4 +10,11 @@ public:
         : std::runtime_error("DVM not found with ID: " + std::to_string(dvmId)) {}
 };
 
+// 아직 수령하지 않은 같은 인증코드가 이미 있는 경우
+class DuplicateCertCodeException : public std::runtime_error {
+public:
+    explicit DuplicateCertCodeException(const std::string &certCode)
+        : std::runtime_error("Duplicate certification code: " + certCode) {}
+};
+
 #endif // DVMEXCEPTION_H
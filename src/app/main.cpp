@@ -52,6 +52,10 @@ int main(int argc, char* argv[])
   }
   
   Config::get().setPort(myPort);
+  // 재고와 판매 변경은 포트별 로그 파일에 남긴다
+  Config::get().walPath = "dvm_" + to_string(myPort) + ".wal";
+  Config::get().snapshotPath = "dvm_" + to_string(myPort) + ".snap";
+  Config::get().historyDir = "dvm_" + to_string(myPort) + "_history";
   Location loc(1, 2);
 
   // OtherDVM 리스트 - 두 번째 매개변수부터 다른 DVM 정보들을 파싱
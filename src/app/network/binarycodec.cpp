@@ -0,0 +1,257 @@
+#include "binarycodec.h"
+
+#include <cstring>
+
+namespace {
+    // 필드 태그 = (필드 번호 << 3) | 와이어 타입
+    enum WireType : uint8_t {
+        Varint = 0,
+        Bytes = 2,
+    };
+
+    enum Field : uint8_t {
+        FieldType = 1,
+        FieldSrcId = 2,
+        FieldDstId = 3,
+        FieldItemCode = 4,
+        FieldItemNum = 5,
+        FieldCoorX = 6,
+        FieldCoorY = 7,
+        FieldAvailability = 8,
+        FieldCertCode = 9,
+        FieldReqId = 10,
+        FieldBatch = 11, // (아이템 코드 1바이트, zigzag varint 수량) 반복
+        FieldReason = 12,
+    };
+
+    constexpr uint8_t tag(Field field, WireType wireType) {
+        return (uint8_t)((field << 3) | wireType);
+    }
+
+    uint32_t zigzag(int32_t value) {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    int32_t unzigzag(uint32_t value) {
+        return (int32_t)((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    class Writer {
+    public:
+        Writer(uint8_t *out, size_t capacity) : out(out), capacity(capacity) {}
+
+        void varint(Field field, uint32_t value) {
+            byte(tag(field, Varint));
+            while (value >= 0x80) {
+                byte((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            byte((uint8_t)value);
+        }
+
+        // 길이 1바이트 뒤에 내용이 오는 필드. 내용을 쓴 뒤 endBytes로 길이를 채운다
+        size_t beginBytes(Field field) {
+            byte(tag(field, Bytes));
+            byte(0);
+            return size;
+        }
+
+        void endBytes(size_t start) {
+            if (overflow || size - start > 0xFF) {
+                overflow = true;
+                return;
+            }
+            out[start - 1] = (uint8_t)(size - start);
+        }
+
+        void rawVarint(uint32_t value) {
+            while (value >= 0x80) {
+                byte((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            byte((uint8_t)value);
+        }
+
+        void rawByte(uint8_t value) {
+            byte(value);
+        }
+
+        void bytes(Field field, const char *data, uint8_t length) {
+            byte(tag(field, Bytes));
+            byte(length);
+            if (size + length > capacity) {
+                overflow = true;
+                return;
+            }
+            memcpy(out + size, data, length);
+            size += length;
+        }
+
+        size_t finish() const {
+            return overflow ? 0 : size;
+        }
+
+    private:
+        uint8_t *out;
+        size_t capacity;
+        size_t size = 0;
+        bool overflow = false;
+
+        void byte(uint8_t value) {
+            if (size >= capacity) {
+                overflow = true;
+                return;
+            }
+            out[size++] = value;
+        }
+    };
+
+    bool readVarint(const uint8_t *&pos, const uint8_t *end, uint32_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (pos >= end) {
+                return false;
+            }
+            uint8_t byte = *pos++;
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+string_view BinaryMessage::getCertCode() const {
+    return string_view(certCode, certLength);
+}
+
+bool BinaryMessage::setCertCode(string_view code) {
+    if (code.size() > kMaxCertCodeLength) {
+        return false;
+    }
+    memcpy(certCode, code.data(), code.size());
+    certLength = (uint8_t)code.size();
+    return true;
+}
+
+bool BinaryMessage::addBatchItem(uint8_t itemCode, int32_t itemNum) {
+    if (batchCount >= kMaxBatchItems) {
+        return false;
+    }
+    batch[batchCount++] = BatchItem{itemCode, itemNum};
+    return true;
+}
+
+size_t BinaryCodec::encode(const BinaryMessage &msg, uint8_t *out, size_t capacity) {
+    Writer writer(out, capacity);
+    // 0인 필드는 생략한다 (디코딩 시 기본값 0)
+    writer.varint(FieldType, (uint32_t)msg.type);
+    if (msg.srcId) writer.varint(FieldSrcId, zigzag(msg.srcId));
+    if (msg.dstId) writer.varint(FieldDstId, zigzag(msg.dstId));
+    if (msg.reqId) writer.varint(FieldReqId, msg.reqId);
+    if (msg.itemCode) writer.varint(FieldItemCode, msg.itemCode);
+    if (msg.itemNum) writer.varint(FieldItemNum, zigzag(msg.itemNum));
+    if (msg.coorX) writer.varint(FieldCoorX, zigzag(msg.coorX));
+    if (msg.coorY) writer.varint(FieldCoorY, zigzag(msg.coorY));
+    if (msg.availability) writer.varint(FieldAvailability, 1);
+    if (msg.reason) writer.varint(FieldReason, msg.reason);
+    if (msg.certLength) writer.bytes(FieldCertCode, msg.certCode, msg.certLength);
+    if (msg.batchCount) {
+        size_t start = writer.beginBytes(FieldBatch);
+        for (uint8_t i = 0; i < msg.batchCount; ++i) {
+            writer.rawByte(msg.batch[i].itemCode);
+            writer.rawVarint(zigzag(msg.batch[i].itemNum));
+        }
+        writer.endBytes(start);
+    }
+    return writer.finish();
+}
+
+bool BinaryCodec::decode(const uint8_t *data, size_t size, BinaryMessage &msg) {
+    msg = BinaryMessage{};
+    const uint8_t *pos = data;
+    const uint8_t *end = data + size;
+
+    while (pos < end) {
+        uint8_t fieldTag = *pos++;
+        uint8_t wireType = fieldTag & 0x07;
+
+        if (wireType == Bytes) {
+            if (pos >= end) return false;
+            uint8_t length = *pos++;
+            if ((size_t)(end - pos) < length) return false;
+            if (fieldTag == tag(FieldCertCode, Bytes) &&
+                !msg.setCertCode(string_view((const char *)pos, length))) {
+                return false;
+            }
+            if (fieldTag == tag(FieldBatch, Bytes)) {
+                const uint8_t *item = pos;
+                const uint8_t *itemsEnd = pos + length;
+                while (item < itemsEnd) {
+                    uint8_t itemCode = *item++;
+                    uint32_t itemNum;
+                    if (itemCode > 99 || !readVarint(item, itemsEnd, itemNum) ||
+                        !msg.addBatchItem(itemCode, unzigzag(itemNum))) {
+                        return false;
+                    }
+                }
+            }
+            pos += length;
+            continue;
+        }
+        if (wireType != Varint) {
+            return false;
+        }
+
+        uint32_t value;
+        if (!readVarint(pos, end, value)) {
+            return false;
+        }
+        switch (fieldTag >> 3) {
+        case FieldType: msg.type = (BinaryMessage::Type)value; break;
+        case FieldSrcId: msg.srcId = unzigzag(value); break;
+        case FieldDstId: msg.dstId = unzigzag(value); break;
+        case FieldReqId: msg.reqId = value; break;
+        case FieldItemCode:
+            if (value > 99) return false;
+            msg.itemCode = (uint8_t)value;
+            break;
+        case FieldItemNum: msg.itemNum = unzigzag(value); break;
+        case FieldCoorX: msg.coorX = unzigzag(value); break;
+        case FieldCoorY: msg.coorY = unzigzag(value); break;
+        case FieldAvailability: msg.availability = value != 0; break;
+        case FieldReason: msg.reason = (uint8_t)value; break;
+        default: break; // 이후 버전에서 추가된 필드
+        }
+    }
+    return msg.type != BinaryMessage::Type::None;
+}
+
+bool BinaryCodec::encodeItemCode(string_view code, uint8_t &out) {
+    if (code.size() != 2 || code[0] < '0' || code[0] > '9' || code[1] < '0' || code[1] > '9') {
+        return false;
+    }
+    out = (uint8_t)((code[0] - '0') * 10 + (code[1] - '0'));
+    return true;
+}
+
+void BinaryCodec::formatItemCode(uint8_t code, char *out) {
+    out[0] = (char)('0' + code / 10);
+    out[1] = (char)('0' + code % 10);
+}
+
+bool BinaryCodec::encodePeerId(string_view id, int32_t &out) {
+    if (id.size() < 2 || id.size() > 10 || id[0] != 'T') {
+        return false;
+    }
+    int32_t value = 0;
+    for (size_t i = 1; i < id.size(); ++i) {
+        if (id[i] < '0' || id[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (id[i] - '0');
+    }
+    out = value;
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef BINARYCODEC_H
+#define BINARYCODEC_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// SocketMessage의 바이너리 표현
+// 필드마다 고정된 숫자 태그를 붙이고, 정수는 zigzag varint로, 아이템 코드("01"~"99")는 1바이트 정수로 보낸다.
+// 모든 필드를 고정 크기 멤버에 담으므로 인코딩/디코딩 중 힙 할당이 없다.
+struct BinaryMessage {
+    enum class Type : uint8_t {
+        None = 0,
+        ReqStock = 1,
+        RespStock = 2,
+        ReqPrepay = 3,
+        RespPrepay = 4,
+        ReqStockBatch = 5,
+        RespStockBatch = 6,
+        Error = 15,
+    };
+    static constexpr size_t kMaxCertCodeLength = 16;
+    // 묶음 조회 한 번에 담을 수 있는 아이템 수 (아이템 사전 크기)
+    static constexpr size_t kMaxBatchItems = 20;
+
+    struct BatchItem {
+        uint8_t itemCode;
+        int32_t itemNum;
+    };
+
+    Type type = Type::None;
+    int32_t srcId = 0;
+    int32_t dstId = 0;
+    uint32_t reqId = 0; // 파이프라이닝 시 응답을 구분하는 식별자 (0이면 없음)
+    uint8_t itemCode = 0;
+    int32_t itemNum = 0;
+    int32_t coorX = 0;
+    int32_t coorY = 0;
+    bool availability = false;
+    // 거절 사유 (0: 없음)
+    enum Reason : uint8_t { ReasonNone = 0, ReasonDuplicateCode = 1 };
+    uint8_t reason = ReasonNone;
+    uint8_t certLength = 0;
+    char certCode[kMaxCertCodeLength] = {};
+    uint8_t batchCount = 0;
+    BatchItem batch[kMaxBatchItems] = {};
+
+    string_view getCertCode() const;
+    // 인증 코드가 최대 길이를 넘으면 false
+    bool setCertCode(string_view code);
+    // 묶음이 가득 차 있으면 false
+    bool addBatchItem(uint8_t itemCode, int32_t itemNum);
+};
+
+namespace BinaryCodec {
+    // 인코딩 결과의 최대 크기 (태그 + varint 최대 길이 기준)
+    const size_t kMaxEncodedSize = 64 + BinaryMessage::kMaxBatchItems * 6;
+
+    // out에 인코딩하고 기록한 바이트 수를 반환한다. 공간이 부족하면 0
+    size_t encode(const BinaryMessage &msg, uint8_t *out, size_t capacity);
+
+    // 잘못된 형식이면 false. 알 수 없는 태그는 건너뛴다.
+    bool decode(const uint8_t *data, size_t size, BinaryMessage &msg);
+
+    // 두 자리 숫자 아이템 코드("01")를 정수로 변환. 다른 형식이면 false
+    bool encodeItemCode(string_view code, uint8_t &out);
+    // 정수 아이템 코드를 두 자리 문자열로 변환 (out은 2바이트)
+    void formatItemCode(uint8_t code, char *out);
+
+    // "T12" 형식의 DVM 식별자를 정수로 변환. 다른 형식이면 false
+    bool encodePeerId(string_view id, int32_t &out);
+}
+
+#endif // BINARYCODEC_H
@@ -0,0 +1,78 @@
+#include "frame.h"
+
+void Frame::append(string &out, const string &payload, uint8_t codec) {
+    uint32_t length = payload.size();
+    char header[kHeaderSize] = {
+        (char)kMagic,
+        (char)codec,
+        (char)((length >> 24) & 0xFF),
+        (char)((length >> 16) & 0xFF),
+        (char)((length >> 8) & 0xFF),
+        (char)(length & 0xFF)};
+    out.append(header, kHeaderSize);
+    out.append(payload);
+}
+
+string Frame::encode(const string &payload, uint8_t codec) {
+    string out;
+    out.reserve(kHeaderSize + payload.size());
+    append(out, payload, codec);
+    return out;
+}
+
+bool Frame::isFramed(const char *data, size_t size) {
+    return size > 0 && (uint8_t)data[0] == kMagic;
+}
+
+FrameDecoder::FrameDecoder() : FrameDecoder(1 << 20) {}
+
+FrameDecoder::FrameDecoder(size_t maxFrameSize) : maxFrameSize(maxFrameSize) {}
+
+void FrameDecoder::feed(const char *data, size_t size) {
+    // 이미 읽은 앞부분은 버퍼가 커질 때만 정리해 복사를 줄인다
+    if (readOffset > 0 && readOffset >= buffer.size() / 2) {
+        buffer.erase(0, readOffset);
+        readOffset = 0;
+    }
+    buffer.append(data, size);
+}
+
+FrameDecoder::Result FrameDecoder::next(string &payload, uint8_t &codec) {
+    if (failed) {
+        return Result::Error;
+    }
+
+    size_t available = buffer.size() - readOffset;
+    if (available < Frame::kHeaderSize) {
+        return Result::NeedMore;
+    }
+
+    const unsigned char *header = (const unsigned char *)buffer.data() + readOffset;
+    if (header[0] != Frame::kMagic) {
+        failed = true;
+        return Result::Error;
+    }
+
+    uint32_t length = ((uint32_t)header[2] << 24) | ((uint32_t)header[3] << 16) |
+                      ((uint32_t)header[4] << 8) | (uint32_t)header[5];
+    if (length > maxFrameSize) {
+        failed = true;
+        return Result::Error;
+    }
+    if (available < Frame::kHeaderSize + length) {
+        return Result::NeedMore;
+    }
+
+    codec = header[1];
+    payload.assign(buffer, readOffset + Frame::kHeaderSize, length);
+    readOffset += Frame::kHeaderSize + length;
+    if (readOffset == buffer.size()) {
+        buffer.clear();
+        readOffset = 0;
+    }
+    return Result::Ready;
+}
+
+size_t FrameDecoder::getBufferedSize() const {
+    return buffer.size() - readOffset;
+}
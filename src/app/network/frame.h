@@ -0,0 +1,55 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// 피어 프로토콜의 길이 프리픽스 프레임
+// [magic 1바이트][codec 1바이트][payload 길이 4바이트 big-endian][payload]
+// 기존 텍스트 메시지는 'm'(msg_type)으로 시작하므로 첫 바이트로 프레임 모드를 구분할 수 있다.
+namespace Frame {
+    const uint8_t kMagic = 0xFA;
+    const size_t kHeaderSize = 6;
+
+    // payload 인코딩 방식
+    enum Codec : uint8_t {
+        Text = 0,   // SocketMessage 텍스트 형식
+        Binary = 1, // BinaryCodec 형식
+    };
+
+    // payload를 프레임으로 감싸 out 뒤에 붙인다
+    void append(string &out, const string &payload, uint8_t codec = Text);
+    string encode(const string &payload, uint8_t codec = Text);
+
+    // 수신 데이터의 첫 바이트가 프레임 헤더인지 확인
+    bool isFramed(const char *data, size_t size);
+}
+
+// 스트림으로 들어오는 바이트를 프레임 단위로 다시 조립한다
+// 한 번의 recv에 프레임 일부만 오거나 여러 프레임이 함께 와도 처리할 수 있다.
+class FrameDecoder {
+public:
+    enum class Result { NeedMore, Ready, Error };
+
+    FrameDecoder();
+    explicit FrameDecoder(size_t maxFrameSize);
+
+    void feed(const char *data, size_t size);
+
+    // 완성된 프레임이 있으면 payload와 codec을 채우고 Ready를 반환한다.
+    // 헤더가 잘못되었거나 최대 크기를 넘으면 Error (이후 스트림은 신뢰할 수 없다)
+    Result next(string &payload, uint8_t &codec);
+
+    size_t getBufferedSize() const;
+
+private:
+    string buffer;
+    size_t readOffset = 0;
+    size_t maxFrameSize;
+    bool failed = false;
+};
+
+#endif // FRAME_H
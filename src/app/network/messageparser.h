@@ -0,0 +1,75 @@
+#ifndef MESSAGEPARSER_H
+#define MESSAGEPARSER_H
+
+#include <string_view>
+#include <charconv>
+
+using namespace std;
+
+// "key:value;key:value;" 형식의 메시지를 복사 없이 순회하는 파서
+// 원본 문자열을 가리키는 string_view만 돌려주므로 필드를 읽는 동안 할당이 없다.
+// 기존 istringstream/getline 파싱과 같은 규칙을 따른다:
+//  - ';'로 토큰을 나누고 ':'가 없는 토큰은 건너뛴다
+//  - key는 첫 ':' 앞, value는 그 뒤 전체 (value 안의 ':'는 그대로 유지)
+class MessageParser {
+public:
+    explicit MessageParser(string_view message) : rest(message) {}
+
+    // 다음 필드를 key/value에 채운다. 더 이상 필드가 없으면 false
+    bool next(string_view &key, string_view &value) {
+        while (!rest.empty()) {
+            size_t end = rest.find(';');
+            string_view token = rest.substr(0, end);
+            rest = end == string_view::npos ? string_view() : rest.substr(end + 1);
+
+            size_t colon = token.find(':');
+            if (colon == string_view::npos) {
+                continue;
+            }
+            key = token.substr(0, colon);
+            value = token.substr(colon + 1);
+            return true;
+        }
+        return false;
+    }
+
+    // key에 해당하는 값을 찾는다. 같은 key가 여러 번 나오면 마지막 값 (없으면 빈 값)
+    static string_view find(string_view message, string_view key) {
+        MessageParser parser(message);
+        string_view fieldKey, fieldValue, found;
+        while (parser.next(fieldKey, fieldValue)) {
+            if (fieldKey == key) {
+                found = fieldValue;
+            }
+        }
+        return found;
+    }
+
+    // 앞쪽 공백과 '+' 부호를 허용하고 숫자 뒤의 문자는 무시한다 (stoi와 같은 규칙)
+    // 숫자로 시작하지 않거나 범위를 넘으면 false
+    template <typename Int>
+    static bool toInt(string_view text, Int &out) {
+        size_t pos = 0;
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) {
+            ++pos;
+        }
+        if (pos < text.size() && text[pos] == '+') {
+            ++pos;
+        }
+        const char *begin = text.data() + pos;
+        const char *end = text.data() + text.size();
+        auto [ptr, error] = from_chars(begin, end, out);
+        return error == errc() && ptr != begin;
+    }
+
+    // 숫자로 변환할 수 없으면 fallback을 반환
+    static int toIntOr(string_view text, int fallback) {
+        int value;
+        return toInt(text, value) ? value : fallback;
+    }
+
+private:
+    string_view rest;
+};
+
+#endif // MESSAGEPARSER_H
@@ -0,0 +1,159 @@
+#include "peerconnectionpool.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <iostream>
+
+PeerConnectionPool::PeerConnectionPool(const string &ip, int port, size_t maxIdle, int maxIdleMs)
+    : ip(ip), port(port), maxIdle(maxIdle), maxIdleTime(maxIdleMs) {}
+
+PeerConnectionPool::~PeerConnectionPool() {
+    for (const auto &conn : idle) {
+        ::close(conn.fd);
+    }
+}
+
+int PeerConnectionPool::acquire(bool &reused) {
+    int fd = acquireIdle();
+    if (fd >= 0) {
+        reused = true;
+        return fd;
+    }
+
+    reused = false;
+    return connectNew();
+}
+
+int PeerConnectionPool::acquireIdle() {
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(poolMutex);
+    // 가장 최근에 쓴 연결부터 재사용 (LIFO)
+    while (!idle.empty()) {
+        IdleConnection conn = idle.back();
+        idle.pop_back();
+        if (now - conn.lastUsed <= maxIdleTime && isAlive(conn.fd)) {
+            return conn.fd;
+        }
+        ::close(conn.fd);
+    }
+    return -1;
+}
+
+void PeerConnectionPool::release(int fd) {
+    lock_guard<mutex> lock(poolMutex);
+    if (idle.size() >= maxIdle) {
+        ::close(fd);
+        return;
+    }
+    idle.push_back({fd, chrono::steady_clock::now()});
+}
+
+void PeerConnectionPool::discard(int fd) {
+    ::close(fd);
+}
+
+int PeerConnectionPool::createSocket(int extraFlags) const {
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | extraFlags, 0);
+    if (sock < 0) {
+        cerr << "Socket creation failed\n";
+        return -1;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = 3;
+    timeout.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return sock;
+}
+
+struct sockaddr_in PeerConnectionPool::makeAddress() const {
+    struct sockaddr_in serverAddr {};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    inet_pton(AF_INET, ip.c_str(), &serverAddr.sin_addr);
+    return serverAddr;
+}
+
+int PeerConnectionPool::connectNew() const {
+    int sock = createSocket(0);
+    if (sock < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in serverAddr = makeAddress();
+    if (connect(sock, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0) {
+        cerr << "Connection failed\n";
+        ::close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+int PeerConnectionPool::connectAsync(bool &inProgress) const {
+    inProgress = false;
+    int sock = createSocket(SOCK_NONBLOCK);
+    if (sock < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in serverAddr = makeAddress();
+    if (connect(sock, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0) {
+        if (errno != EINPROGRESS) {
+            ::close(sock);
+            return -1;
+        }
+        inProgress = true;
+    }
+    return sock;
+}
+
+bool PeerConnectionPool::finishConnect(int fd) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
+        return false;
+    }
+    return error == 0;
+}
+
+void PeerConnectionPool::setNonBlocking(int fd, bool enable) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return;
+    fcntl(fd, F_SETFL, enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+}
+
+size_t PeerConnectionPool::getIdleCount() const {
+    lock_guard<mutex> lock(poolMutex);
+    return idle.size();
+}
+
+const string &PeerConnectionPool::getIp() const {
+    return ip;
+}
+
+int PeerConnectionPool::getPort() const {
+    return port;
+}
+
+// 유휴 연결이 피어에 의해 닫혔는지 확인
+bool PeerConnectionPool::isAlive(int fd) {
+    char probe;
+    ssize_t result = ::recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (result == 0) {
+        return false; // 피어가 연결을 닫음
+    }
+    if (result > 0) {
+        return false; // 요청하지 않은 데이터가 남아 있으면 재사용하지 않음
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
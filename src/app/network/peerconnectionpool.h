@@ -0,0 +1,67 @@
+#ifndef PEERCONNECTIONPOOL_H
+#define PEERCONNECTIONPOOL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <netinet/in.h>
+
+using namespace std;
+
+// 하나의 피어 DVM에 대한 TCP 연결 풀
+// 요청마다 새 연결을 맺는 대신 유휴 연결을 재사용하여
+// 핸드셰이크 비용과 TIME_WAIT 소켓 누적을 줄인다.
+class PeerConnectionPool {
+public:
+    PeerConnectionPool(const string &ip, int port, size_t maxIdle, int maxIdleMs);
+    ~PeerConnectionPool();
+
+    PeerConnectionPool(const PeerConnectionPool &) = delete;
+    PeerConnectionPool &operator=(const PeerConnectionPool &) = delete;
+
+    // 연결을 하나 가져온다. 유휴 연결이 있으면 재사용하고 없으면 새로 연결한다.
+    // 실패 시 -1, reused에는 재사용 여부를 기록한다.
+    int acquire(bool &reused);
+
+    // 살아 있는 유휴 연결만 꺼낸다. 없으면 -1 (새로 연결하지 않음)
+    int acquireIdle();
+
+    // 정상적으로 요청/응답을 마친 연결을 풀에 반납
+    void release(int fd);
+
+    // 오류가 발생한 연결을 닫고 버린다
+    void discard(int fd);
+
+    // 새 연결 생성 (풀을 거치지 않음)
+    int connectNew() const;
+
+    // non-blocking 연결 시작. 연결이 진행 중이면 inProgress가 true가 되고,
+    // 호출자는 POLLOUT으로 완료를 기다린 뒤 finishConnect로 결과를 확인한다.
+    int connectAsync(bool &inProgress) const;
+    static bool finishConnect(int fd);
+    static void setNonBlocking(int fd, bool enable);
+
+    size_t getIdleCount() const;
+    const string &getIp() const;
+    int getPort() const;
+
+private:
+    struct IdleConnection {
+        int fd;
+        chrono::steady_clock::time_point lastUsed;
+    };
+
+    string ip;
+    int port;
+    size_t maxIdle;
+    chrono::milliseconds maxIdleTime;
+    mutable mutex poolMutex;
+    vector<IdleConnection> idle;
+
+    static bool isAlive(int fd);
+    int createSocket(int extraFlags) const;
+    struct sockaddr_in makeAddress() const;
+};
+
+#endif // PEERCONNECTIONPOOL_H
@@ -0,0 +1,392 @@
+#include "peerserver.h"
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <iostream>
+
+namespace {
+    const int kMaxEvents = 256;
+    const int kSweepIntervalMs = 500;
+}
+
+PeerServer::CompletionQueue::~CompletionQueue() {
+    if (wakeFd >= 0) ::close(wakeFd);
+}
+
+void PeerServer::CompletionQueue::push(int fd, uint64_t connectionId, uint8_t codec, string response) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        completions.push_back({fd, connectionId, codec, move(response)});
+    }
+    wake();
+}
+
+void PeerServer::CompletionQueue::wake() {
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+PeerServer::PeerServer(int port, RequestHandler handler, int idleTimeoutMs, WorkerPool *workerPool)
+    : port(port), handler(move(handler)), idleTimeout(idleTimeoutMs), workerPool(workerPool),
+      completionQueue(make_shared<CompletionQueue>()) {}
+
+PeerServer::~PeerServer() {
+    for (auto &[fd, conn] : connections) {
+        ::close(fd);
+    }
+    if (listenFd >= 0) ::close(listenFd);
+    if (epollFd >= 0) ::close(epollFd);
+}
+
+bool PeerServer::start() {
+    listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        cerr << "Failed to create server socket\n";
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in serverAddr {};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    serverAddr.sin_port = htons(port);
+
+    if (::bind(listenFd, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0) {
+        cerr << "Bind failed\n";
+        return false;
+    }
+    if (::listen(listenFd, SOMAXCONN) < 0) {
+        cerr << "Listen failed\n";
+        return false;
+    }
+
+    // port 0으로 bind한 경우 실제 할당된 포트 확인
+    socklen_t len = sizeof(serverAddr);
+    if (getsockname(listenFd, (struct sockaddr *)&serverAddr, &len) == 0) {
+        port = ntohs(serverAddr.sin_port);
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    completionQueue->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || completionQueue->wakeFd < 0) {
+        cerr << "epoll setup failed\n";
+        return false;
+    }
+
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = completionQueue->wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, completionQueue->wakeFd, &ev);
+
+    running = true;
+    return true;
+}
+
+void PeerServer::run() {
+    struct epoll_event events[kMaxEvents];
+    auto lastSweep = chrono::steady_clock::now();
+
+    while (running) {
+        int n = epoll_wait(epollFd, events, kMaxEvents, kSweepIntervalMs);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            cerr << "epoll_wait failed\n";
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t flags = events[i].events;
+
+            if (fd == listenFd) {
+                acceptConnections();
+            } else if (fd == completionQueue->wakeFd) {
+                uint64_t value;
+                while (::read(fd, &value, sizeof(value)) > 0) {}
+                drainCompletions();
+            } else {
+                if (flags & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(fd);
+                    continue;
+                }
+                if (flags & (EPOLLIN | EPOLLRDHUP)) {
+                    handleReadable(fd);
+                }
+                if ((flags & EPOLLOUT) && connections.count(fd)) {
+                    handleWritable(fd);
+                }
+            }
+        }
+
+        auto now = chrono::steady_clock::now();
+        if (now - lastSweep >= chrono::milliseconds(kSweepIntervalMs)) {
+            closeIdleConnections();
+            lastSweep = now;
+        }
+    }
+}
+
+void PeerServer::stop() {
+    running = false;
+    if (completionQueue->wakeFd >= 0) {
+        completionQueue->wake();
+    }
+}
+
+void PeerServer::setCodecHandler(uint8_t codec, RequestHandler codecHandler) {
+    codecHandlers[codec] = move(codecHandler);
+}
+
+void PeerServer::setMaxFrameSize(size_t size) {
+    maxFrameSize = size;
+}
+
+void PeerServer::setMaxInFlight(int count) {
+    maxInFlight = count > 0 ? count : 1;
+}
+
+int PeerServer::getPort() const {
+    return port;
+}
+
+size_t PeerServer::getConnectionCount() const {
+    return connectionCount;
+}
+
+size_t PeerServer::getQueueDepth() const {
+    return workerPool ? workerPool->getQueueDepth() : 0;
+}
+
+void PeerServer::acceptConnections() {
+    while (true) {
+        int clientFd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                cerr << "Accept failed\n";
+            }
+            return;
+        }
+
+        int enable = 1;
+        setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        struct epoll_event ev {};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = clientFd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &ev) < 0) {
+            ::close(clientFd);
+            continue;
+        }
+
+        Connection &conn = connections[clientFd];
+        conn.id = nextConnectionId++;
+        conn.decoder = FrameDecoder(maxFrameSize);
+        conn.lastActive = chrono::steady_clock::now();
+        connectionCount = connections.size();
+    }
+}
+
+void PeerServer::handleReadable(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    Connection &conn = it->second;
+
+    bool peerClosed = false;
+    char buffer[4096];
+    while (true) {
+        ssize_t bytesRead = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (bytesRead > 0) {
+            if (conn.mode == Connection::Mode::Framed) {
+                conn.decoder.feed(buffer, bytesRead);
+            } else {
+                conn.inBuffer.append(buffer, bytesRead);
+            }
+            continue;
+        }
+        if (bytesRead == 0) {
+            peerClosed = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            peerClosed = true;
+        }
+        break;
+    }
+    conn.lastActive = chrono::steady_clock::now();
+    if (peerClosed) {
+        conn.peerClosed = true;
+    }
+
+    processBufferedRequest(fd, conn);
+}
+
+// 텍스트 모드에서는 기존 프로토콜과 동일하게, 한 번에 도착한 데이터를 하나의 요청으로 처리한다.
+// 프레임 모드에서는 완성된 프레임마다 하나의 요청으로 처리한다.
+// 텍스트 모드는 이전 요청의 응답이 나가기 전에는 다음 요청을 처리하지 않고,
+// 프레임 모드는 연결당 maxInFlight개까지 동시에 처리한다.
+void PeerServer::processBufferedRequest(int fd, Connection &conn) {
+    if (conn.mode == Connection::Mode::Unknown && !conn.inBuffer.empty()) {
+        bool framed = Frame::isFramed(conn.inBuffer.data(), conn.inBuffer.size());
+        conn.mode = framed ? Connection::Mode::Framed : Connection::Mode::Legacy;
+    }
+
+    if (conn.mode == Connection::Mode::Framed) {
+        if (!conn.inBuffer.empty()) {
+            conn.decoder.feed(conn.inBuffer.data(), conn.inBuffer.size());
+            conn.inBuffer.clear();
+        }
+        while (conn.pendingRequests < maxInFlight) {
+            string payload;
+            uint8_t codec = Frame::Text;
+            FrameDecoder::Result result = conn.decoder.next(payload, codec);
+            if (result == FrameDecoder::Result::NeedMore) {
+                break;
+            }
+            if (result == FrameDecoder::Result::Error) {
+                // 잘못된 헤더나 너무 큰 프레임: 이후 스트림을 해석할 수 없으므로 연결을 닫는다
+                closeConnection(fd);
+                return;
+            }
+            processRequest(fd, conn, codec, move(payload));
+            if (!connections.count(fd)) return;
+        }
+    } else if (!conn.inBuffer.empty() && conn.pendingRequests == 0) {
+        string request;
+        request.swap(conn.inBuffer);
+        processRequest(fd, conn, Frame::Text, move(request));
+        if (!connections.count(fd)) return;
+    }
+
+    if (conn.peerClosed && conn.pendingRequests == 0 && conn.outOffset >= conn.outBuffer.size()) {
+        closeConnection(fd);
+    }
+}
+
+void PeerServer::processRequest(int fd, Connection &conn, uint8_t codec, string request) {
+    const RequestHandler *selected = &handler;
+    if (codec != Frame::Text) {
+        auto it = codecHandlers.find(codec);
+        if (it == codecHandlers.end()) {
+            sendResponse(fd, conn, Frame::Text, "msg_type:error;detail:unsupported_codec;");
+            return;
+        }
+        selected = &it->second;
+    }
+
+    if (!workerPool) {
+        sendResponse(fd, conn, codec, (*selected)(request));
+        return;
+    }
+
+    conn.pendingRequests++;
+    shared_ptr<CompletionQueue> queue = completionQueue;
+    uint64_t connectionId = conn.id;
+    bool submitted = workerPool->trySubmit([queue, fd, connectionId, codec, requestHandler = *selected, request = move(request)]() {
+        queue->push(fd, connectionId, codec, requestHandler(request));
+    });
+
+    if (!submitted) {
+        // 큐가 가득 찬 경우 처리하지 않고 즉시 거절
+        conn.pendingRequests--;
+        sendResponse(fd, conn, Frame::Text, "msg_type:error;detail:server_busy;");
+    }
+}
+
+void PeerServer::drainCompletions() {
+    vector<CompletionQueue::Completion> ready;
+    {
+        lock_guard<mutex> lock(completionQueue->queueMutex);
+        ready.swap(completionQueue->completions);
+    }
+
+    for (auto &completion : ready) {
+        auto it = connections.find(completion.fd);
+        // 응답을 기다리는 동안 닫히고 재사용된 fd는 무시
+        if (it == connections.end() || it->second.id != completion.connectionId) {
+            continue;
+        }
+        it->second.pendingRequests--;
+        sendResponse(completion.fd, it->second, completion.codec, move(completion.response));
+
+        it = connections.find(completion.fd);
+        if (it != connections.end()) {
+            processBufferedRequest(completion.fd, it->second);
+        }
+    }
+}
+
+void PeerServer::sendResponse(int fd, Connection &conn, uint8_t codec, string response) {
+    if (conn.mode == Connection::Mode::Framed) {
+        Frame::append(conn.outBuffer, response, codec);
+    } else {
+        conn.outBuffer.append(response);
+    }
+    conn.lastActive = chrono::steady_clock::now();
+    flushOutput(fd, conn);
+}
+
+void PeerServer::handleWritable(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    flushOutput(fd, it->second);
+}
+
+// 보낼 데이터를 최대한 전송한다. 연결이 닫힌 경우 false를 반환한다.
+bool PeerServer::flushOutput(int fd, Connection &conn) {
+    while (conn.outOffset < conn.outBuffer.size()) {
+        ssize_t sent = ::send(fd, conn.outBuffer.data() + conn.outOffset,
+                              conn.outBuffer.size() - conn.outOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.outOffset += sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true; // EPOLLOUT 이벤트에서 이어서 전송
+        }
+        closeConnection(fd);
+        return false;
+    }
+
+    conn.outBuffer.clear();
+    conn.outOffset = 0;
+    // 피어가 닫았더라도 아직 처리하지 않은 프레임이 남아 있으면 응답을 마저 보낸다
+    if (conn.peerClosed && conn.pendingRequests == 0 && conn.decoder.getBufferedSize() == 0) {
+        closeConnection(fd);
+        return false;
+    }
+    return true;
+}
+
+void PeerServer::closeConnection(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+    connectionCount = connections.size();
+}
+
+void PeerServer::closeIdleConnections() {
+    auto now = chrono::steady_clock::now();
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (it->second.pendingRequests == 0 && now - it->second.lastActive > idleTimeout) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, it->first, nullptr);
+            ::close(it->first);
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    connectionCount = connections.size();
+}
@@ -0,0 +1,122 @@
+#ifndef PEERSERVER_H
+#define PEERSERVER_H
+
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "workerpool.h"
+#include "frame.h"
+
+using namespace std;
+
+// epoll 기반 non-blocking 피어 서버
+// 하나의 스레드가 수천 개의 피어 연결을 동시에 처리한다.
+// 응답 후에도 연결을 유지(keep-alive)하여 클라이언트가 연결을 재사용할 수 있고,
+// 유휴 제한 시간을 넘긴 연결만 닫는다.
+// WorkerPool이 주어지면 요청 처리는 워커 스레드에서 수행하고,
+// 이벤트 루프 스레드는 accept와 송수신만 담당한다.
+// 연결의 첫 바이트로 기존 텍스트 프로토콜과 길이 프리픽스 프레임 프로토콜을 구분하며,
+// 프레임 모드에서는 요청이 여러 번에 나뉘어 오거나 한 번에 여러 개가 와도 처리한다.
+// 또한 WorkerPool과 함께 쓰면 한 연결의 여러 요청을 동시에 처리하고 완료된 순서대로 응답한다
+// (클라이언트는 req_id로 응답을 구분한다).
+class PeerServer {
+public:
+    // 수신한 요청 메시지를 받아 응답 메시지를 돌려주는 핸들러
+    using RequestHandler = function<string(const string &)>;
+
+    PeerServer(int port, RequestHandler handler, int idleTimeoutMs = 3000, WorkerPool *workerPool = nullptr);
+    ~PeerServer();
+
+    PeerServer(const PeerServer &) = delete;
+    PeerServer &operator=(const PeerServer &) = delete;
+
+    // 소켓 생성, bind, listen 및 epoll 등록 (port 0이면 임의 포트)
+    bool start();
+
+    // 이벤트 루프 실행 (stop() 호출 전까지 반환하지 않음)
+    void run();
+
+    // 다른 스레드에서 이벤트 루프 종료 요청
+    void stop();
+
+    // 프레임 codec별 핸들러 등록 (start 전에 설정). 텍스트 codec은 생성자의 핸들러를 사용한다.
+    // 등록되지 않은 codec의 요청에는 텍스트 오류로 응답한다.
+    void setCodecHandler(uint8_t codec, RequestHandler codecHandler);
+
+    // 프레임 모드에서 허용하는 최대 payload 크기 (start 전에 설정)
+    void setMaxFrameSize(size_t size);
+
+    // 프레임 모드에서 한 연결이 동시에 처리 중일 수 있는 요청 수 (start 전에 설정)
+    void setMaxInFlight(int count);
+
+    int getPort() const;
+    size_t getConnectionCount() const;
+    size_t getQueueDepth() const;
+
+private:
+    // 워커 스레드에서 완료된 응답을 이벤트 루프로 넘기는 큐
+    // 서버보다 늦게 끝나는 작업이 있을 수 있으므로 shared_ptr로 공유한다.
+    struct CompletionQueue {
+        struct Completion {
+            int fd;
+            uint64_t connectionId;
+            uint8_t codec;
+            string response;
+        };
+        int wakeFd = -1;
+        mutex queueMutex;
+        vector<Completion> completions;
+
+        ~CompletionQueue();
+        void push(int fd, uint64_t connectionId, uint8_t codec, string response);
+        void wake();
+    };
+
+    struct Connection {
+        enum class Mode { Unknown, Legacy, Framed };
+
+        uint64_t id = 0;
+        Mode mode = Mode::Unknown;
+        FrameDecoder decoder;
+        int pendingRequests = 0;
+        string inBuffer;
+        string outBuffer;
+        size_t outOffset = 0;
+        bool peerClosed = false;
+        chrono::steady_clock::time_point lastActive;
+    };
+
+    int port;
+    RequestHandler handler;
+    unordered_map<uint8_t, RequestHandler> codecHandlers;
+    chrono::milliseconds idleTimeout;
+    size_t maxFrameSize = 1 << 20;
+    int maxInFlight = 32;
+    WorkerPool *workerPool;
+    shared_ptr<CompletionQueue> completionQueue;
+    uint64_t nextConnectionId = 1;
+
+    int listenFd = -1;
+    int epollFd = -1;
+    atomic<bool> running{false};
+    atomic<size_t> connectionCount{0};
+    unordered_map<int, Connection> connections;
+
+    void acceptConnections();
+    void handleReadable(int fd);
+    void handleWritable(int fd);
+    void processBufferedRequest(int fd, Connection &conn);
+    void processRequest(int fd, Connection &conn, uint8_t codec, string request);
+    void drainCompletions();
+    void sendResponse(int fd, Connection &conn, uint8_t codec, string response);
+    bool flushOutput(int fd, Connection &conn);
+    void closeConnection(int fd);
+    void closeIdleConnections();
+};
+
+#endif // PEERSERVER_H
@@ -0,0 +1,40 @@
+#include "periodictask.h"
+
+PeriodicTask::PeriodicTask(int intervalMs, function<void()> task)
+    : interval(intervalMs), task(move(task)) {}
+
+PeriodicTask::~PeriodicTask() {
+    stop();
+}
+
+void PeriodicTask::start() {
+    if (interval.count() <= 0 || worker.joinable()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(stopMutex);
+        stopping = false;
+    }
+    worker = thread(&PeriodicTask::loop, this);
+}
+
+void PeriodicTask::stop() {
+    {
+        lock_guard<mutex> lock(stopMutex);
+        stopping = true;
+    }
+    stopCondition.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void PeriodicTask::loop() {
+    unique_lock<mutex> lock(stopMutex);
+    while (!stopping) {
+        lock.unlock();
+        task();
+        lock.lock();
+        stopCondition.wait_for(lock, interval, [this] { return stopping; });
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef PERIODICTASK_H
+#define PERIODICTASK_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+using namespace std;
+
+// 백그라운드 스레드에서 작업을 일정 간격으로 반복 실행한다
+// start 직후 한 번 실행하고, stop 또는 소멸 시 대기 중인 스레드를 바로 깨워 종료한다.
+class PeriodicTask {
+public:
+    PeriodicTask(int intervalMs, function<void()> task);
+    ~PeriodicTask();
+
+    PeriodicTask(const PeriodicTask &) = delete;
+    PeriodicTask &operator=(const PeriodicTask &) = delete;
+
+    // 간격이 0 이하이면 시작하지 않는다
+    void start();
+    void stop();
+
+private:
+    chrono::milliseconds interval;
+    function<void()> task;
+    thread worker;
+    mutex stopMutex;
+    condition_variable stopCondition;
+    bool stopping = false;
+
+    void loop();
+};
+
+#endif // PERIODICTASK_H
@@ -0,0 +1,83 @@
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(size_t threadCount, size_t queueCapacity)
+    : queueCapacity(queueCapacity > 0 ? queueCapacity : 1) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+bool WorkerPool::trySubmit(function<void()> task) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (stopping || tasks.size() >= queueCapacity) {
+            return false;
+        }
+        tasks.push_back(move(task));
+        size_t depth = tasks.size();
+        queueDepth = depth;
+        if (depth > peakQueueDepth) {
+            peakQueueDepth = depth;
+        }
+    }
+    queueCondition.notify_one();
+    return true;
+}
+
+void WorkerPool::shutdown() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (stopping && workers.empty()) {
+            return;
+        }
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (auto &worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+size_t WorkerPool::getQueueDepth() const {
+    return queueDepth;
+}
+
+size_t WorkerPool::getPeakQueueDepth() const {
+    return peakQueueDepth;
+}
+
+size_t WorkerPool::getQueueCapacity() const {
+    return queueCapacity;
+}
+
+size_t WorkerPool::getThreadCount() const {
+    return workers.size();
+}
+
+void WorkerPool::workerLoop() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return; // stopping이고 남은 작업 없음
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+            queueDepth = tasks.size();
+        }
+        task();
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+// 고정 크기 작업 큐를 가진 워커 스레드 풀
+// 큐가 가득 차면 작업을 거절하여 요청 폭주 시 메모리 사용량을 제한한다.
+class WorkerPool {
+public:
+    WorkerPool(size_t threadCount, size_t queueCapacity);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // 큐에 작업을 추가 (큐가 가득 찼거나 종료된 경우 false)
+    bool trySubmit(function<void()> task);
+
+    // 남은 작업을 모두 처리한 뒤 워커 스레드 종료
+    void shutdown();
+
+    size_t getQueueDepth() const;
+    size_t getPeakQueueDepth() const;
+    size_t getQueueCapacity() const;
+    size_t getThreadCount() const;
+
+private:
+    size_t queueCapacity;
+    vector<thread> workers;
+    deque<function<void()>> tasks;
+    mutable mutex queueMutex;
+    condition_variable queueCondition;
+    bool stopping = false;
+    atomic<size_t> queueDepth{0};
+    atomic<size_t> peakQueueDepth{0};
+
+    void workerLoop();
+};
+
+#endif // WORKERPOOL_H
@@ -3,6 +3,14 @@
 #include <poll.h>
 #include <unistd.h>
 #include <limits>
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+    // 워커 스레드들이 server_log.txt에 동시에 기록하지 않도록 보호
+    std::mutex serverLogMutex;
+}
 
 Controller::Controller(DVM *dvm) : dvm(dvm), location(dvm->getLocation()), stocks(dvm->getStocks()), dvmId(dvm->getDvmId())
 {
@@ -13,17 +21,11 @@ Controller::~Controller() {}
 map<string, string> Controller::parseStockResponse(const string &response)
 {
     map<string, string> parsed;
-    istringstream stream(response);
-    string token;
-    while (getline(stream, token, ';'))
+    MessageParser parser(response);
+    string_view key, value;
+    while (parser.next(key, value))
     {
-        size_t pos = token.find(':');
-        if (pos != string::npos)
-        {
-            string key = token.substr(0, pos);
-            string value = token.substr(pos + 1);
-            parsed[key] = value;
-        }
+        parsed[string(key)] = value;
     }
     return parsed;
 }
@@ -39,82 +41,105 @@ void Controller::run()
 
 void Controller::runServer()
 {
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0)
+    WorkerPool pool(Config::get().workerThreads, Config::get().workerQueueCapacity);
+    PeerServer server(Config::get().port, [this](const string &request)
+                      { return dispatchRequest(request); },
+                      Config::get().serverIdleTimeoutMs, &pool);
+    server.setMaxFrameSize(Config::get().maxFrameBytes);
+    server.setCodecHandler(Frame::Binary, [this](const string &payload)
+                           { return dispatchBinaryRequest(payload); });
+    if (!server.start())
     {
-        cerr << "Failed to create server socket\n";
         return;
     }
 
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(Config::get().port);
+    // 다른 DVM에 재고 변화 알림을 구독하고 구독 기간의 절반마다 갱신한다
+    PeriodicTask subscriptionRenewal(Config::get().peerSubscriptionLeaseMs / 2, [this]
+                                     { dvm->subscribeToPeers(); });
+    subscriptionRenewal.start();
+    // 주기적으로 무작위 피어와 재고 표를 교환한다
+    PeriodicTask gossip(Config::get().gossipIntervalMs, [this]
+                        { dvm->gossipRound(); });
+    gossip.start();
+    // 수령하지 않은 인증코드를 만료시키고 재고를 되돌린다
+    PeriodicTask certExpiry(Config::get().certExpiryTickMs, [this]
+                            { dvm->expireCertCodes(); });
+    certExpiry.start();
+    // 재시작 때 긴 로그를 다시 읽지 않도록 주기적으로 상태 스냅샷을 남긴다
+    PeriodicTask snapshots(Config::get().snapshotPath.empty() ? 0 : Config::get().snapshotIntervalMs, [this]
+                           { dvm->writeSnapshot(); });
+    snapshots.start();
+    // 분석용 판매 이력 파일을 주기적으로 내보낸다
+    PeriodicTask historyExport(Config::get().historyDir.empty() ? 0 : Config::get().historyExportIntervalMs, [this]
+                               { dvm->exportSalesHistory(Config::get().historyDir); });
+    historyExport.start();
+
+    workerPool = &pool;
+    server.run();
+    workerPool = nullptr;
+    certExpiry.stop();
+    gossip.stop();
+    subscriptionRenewal.stop();
+    pool.shutdown();
+}
 
-    if (::bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+string Controller::dispatchRequest(const string &request)
+{
+    static std::ofstream logFile("server_log.txt", std::ios::app);
+    WorkerPool *pool = workerPool;
     {
-        cerr << "Bind failed\n";
-        return;
+        std::lock_guard<std::mutex> lock(serverLogMutex);
+        logFile << "[SERVER] Received (queue depth "
+                << (pool ? pool->getQueueDepth() : 0) << "): " << request << std::endl;
     }
 
-    if (::listen(server_fd, 5) < 0)
+    string response;
+    // req_stock_batch가 req_stock으로 시작하므로 먼저 확인한다
+    if (request.find("msg_type:req_stock_batch") != string::npos)
     {
-        cerr << "Listen failed\n";
-        return;
+        response = handleCheckStockBatchRequest(request);
     }
-
-    static std::ofstream logFile("server_log.txt", std::ios::app);
-
-    // cout << "DVM Controller Server is running on port 9000...\n";
-
-    while (true)
+    else if (request.find("msg_type:req_stock") != string::npos)
     {
-        int client_fd = ::accept(server_fd, nullptr, nullptr);
-        if (client_fd < 0)
-        {
-            cerr << "Accept failed\n";
-            continue;
-        }
-
-        struct timeval timeout;
-        timeout.tv_sec = 3;
-        timeout.tv_usec = 0;
-        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout));
-        setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, (char *)&timeout, sizeof(timeout));
-
-        char buffer[1024] = {0};
-        int bytesRead = ::read(client_fd, buffer, sizeof(buffer));
-        if (bytesRead > 0)
-        {
-            string request(buffer);
-            logFile << "[SERVER] Received: " << request << std::endl;
-            string response;
-
-            if (request.find("msg_type:req_stock") != string::npos)
-            {
-                response = handleCheckStockRequest(request);
-            }
-            else if (request.find("msg_type:req_prepay") != string::npos)
-            {
-                response = handlePrepaymentRequest(request);
-            }
-            else
-            {
-                response = "msg_type:error;detail:unknown_request;";
-            }
-
-            logFile << "[SERVER] Response generated: " << response << std::endl;
-            ssize_t sent = ::send(client_fd, response.c_str(), response.size(), 0);
-            if (sent < 0)
-            {
-                logFile << "[SERVER] Send failed" << std::endl;
-            }
-        }
+        response = handleCheckStockRequest(request);
+    }
+    else if (request.find("msg_type:req_prepay") != string::npos)
+    {
+        response = handlePrepaymentRequest(request);
+    }
+    else if (request.find("msg_type:req_subscribe") != string::npos)
+    {
+        response = handleSubscribeRequest(request);
+    }
+    else if (request.find("msg_type:stock_changed") != string::npos)
+    {
+        response = handleStockChanged(request);
+    }
+    else if (request.find("msg_type:req_gossip") != string::npos)
+    {
+        response = handleGossipRequest(request);
+    }
+    else if (request.find("msg_type:req_stats") != string::npos)
+    {
+        response = handleStatsRequest(request);
+    }
+    else
+    {
+        response = "msg_type:error;detail:unknown_request;";
+    }
 
-        ::close(client_fd);
+    // 파이프라이닝 요청이면 응답에 같은 req_id를 붙여 클라이언트가 짝을 맞출 수 있게 한다
+    string_view reqId = MessageParser::find(request, "req_id");
+    if (!reqId.empty())
+    {
+        response.append("req_id:").append(reqId).append(";");
     }
 
-    ::close(server_fd);
+    {
+        std::lock_guard<std::mutex> lock(serverLogMutex);
+        logFile << "[SERVER] Response generated: " << response << std::endl;
+    }
+    return response;
 }
 
 int Controller::displayMenu()
@@ -370,54 +395,28 @@ void Controller::handlePrepaidPurchase()
 
 string Controller::handleCheckStockRequest(const string &msg)
 {
-    istringstream iss(msg);
-    string token, item_code, src_id;
+    MessageParser parser(msg);
+    string_view key, value, item_code, src_id;
     int item_num = 0;
 
-    while (getline(iss, token, ';'))
+    while (parser.next(key, value))
     {
-        size_t pos = token.find(':');
-        if (pos == string::npos)
-            continue;
-        string key = token.substr(0, pos);
-        string value = token.substr(pos + 1);
         if (key == "item_code")
             item_code = value;
         else if (key == "item_num")
-            item_num = stoi(value);
+            item_num = MessageParser::toIntOr(value, 0);
         else if (key == "src_id")
             src_id = value;
     }
 
-    string result = dvm->queryStocks(item_code, item_num);
-    static std::ofstream logFile("server_log.txt", std::ios::app);
-    logFile << "[SERVER] queryStocks: " << result << std::endl;
-    auto parsed = parseStockResponse(result);
-
-    string resp_num = ""; // 초기화는 명시적으로
-
-    if (parsed["flag"] == "other")
-    {
-        resp_num = "0";
-    }
-    else if (parsed["flag"] == "this")
-    {
-        if (parsed.count("count"))
-            resp_num = parsed["count"];
-        else
-            resp_num = "0";
-    }
-    else
-    {
-        resp_num = "0";
-    }
+    CheckStockResponse answer = answerStockQuery(string(item_code), item_num);
 
     ostringstream oss;
     oss << "msg_type:resp_stock;"
         << "src_id:T" << dvmId << ";"
         << "dst_id:" << src_id << ";"
         << "item_code:" << item_code << ";"
-        << "item_num:" << resp_num << ";"
+        << "item_num:" << answer.item_num << ";"
         << "coor_x:" << location.getX() << ";"
         << "coor_y:" << location.getY() << ";";
 
@@ -426,37 +425,24 @@ string Controller::handleCheckStockRequest(const string &msg)
 
 string Controller::handlePrepaymentRequest(const string &msg)
 {
-    istringstream iss(msg);
-    string token, item_code, src_id;
+    MessageParser parser(msg);
+    string_view key, value, item_code, src_id, cert_code;
     int item_num = 0;
-    string cert_code;
 
-    while (getline(iss, token, ';'))
+    while (parser.next(key, value))
     {
-        size_t pos = token.find(':');
-        if (pos == string::npos)
-            continue;
-        string key = token.substr(0, pos);
-        string value = token.substr(pos + 1);
         if (key == "item_code")
             item_code = value;
         else if (key == "item_num")
-            item_num = stoi(value);
+            item_num = MessageParser::toIntOr(value, 0);
         else if (key == "cert_code")
             cert_code = value;
         else if (key == "src_id")
             src_id = value;
     }
 
-    string result = dvm->queryStocks(item_code, item_num);
-    auto parsed = parseStockResponse(result);
-    string availability = "F";
-
-    if (parsed["flag"] == "this")
-    {
-        availability = "T";
-        dvm->saveSaleFromOther(item_code, item_num, cert_code);
-    }
+    askPrepaymentResponse answer = answerPrepayment(
+        askPrepaymentRequest{string(item_code), item_num, string(cert_code), max(parsePeerId(src_id), 0)});
 
     ostringstream oss;
     oss << "msg_type:resp_prepay;"
@@ -464,7 +450,281 @@ string Controller::handlePrepaymentRequest(const string &msg)
         << "dst_id:T" << src_id << ";"
         << "item_code:" << item_code << ";"
         << "item_num:" << item_num << ";"
-        << "availability:" << availability << ";";
+        << "availability:" << (answer.availability ? "T" : "F") << ";";
+    if (answer.duplicate_code)
+    {
+        oss << "reason:duplicate_code;";
+    }
+
+    return oss.str();
+}
+
+string Controller::handleCheckStockBatchRequest(const string &msg)
+{
+    MessageParser parser(msg);
+    string_view key, value, items, src_id;
+    while (parser.next(key, value))
+    {
+        if (key == "items")
+            items = value;
+        else if (key == "src_id")
+            src_id = value;
+    }
+
+    // 요청한 아이템들을 로컬 재고에서 한 번에 확인
+    vector<CheckStockRequest> answer = dvm->checkLocalStocks(StockBatchField::parse(items));
+
+    ostringstream oss;
+    oss << "msg_type:resp_stock_batch;"
+        << "src_id:T" << dvmId << ";"
+        << "dst_id:" << src_id << ";"
+        << "items:" << StockBatchField::format(answer) << ";"
+        << "coor_x:" << location.getX() << ";"
+        << "coor_y:" << location.getY() << ";";
+
+    return oss.str();
+}
+
+string Controller::handleSubscribeRequest(const string &msg)
+{
+    MessageParser parser(msg);
+    string_view key, value, items, src_id, lease_ms;
+    while (parser.next(key, value))
+    {
+        if (key == "items")
+            items = value;
+        else if (key == "src_id")
+            src_id = value;
+        else if (key == "lease_ms")
+            lease_ms = value;
+    }
 
+    vector<CheckStockRequest> current = dvm->acceptSubscription(
+        parsePeerId(src_id), StockBatchField::parse(items), MessageParser::toIntOr(lease_ms, 0));
+    if (current.empty())
+    {
+        return "msg_type:error;detail:subscription_rejected;";
+    }
+
+    ostringstream oss;
+    oss << "msg_type:resp_subscribe;"
+        << "src_id:T" << dvmId << ";"
+        << "dst_id:" << src_id << ";"
+        << "items:" << StockBatchField::format(current) << ";";
+    return oss.str();
+}
+
+string Controller::handleStockChanged(const string &msg)
+{
+    MessageParser parser(msg);
+    string_view key, value, item_code, src_id;
+    int item_num = -1;
+    int threshold = 0;
+    while (parser.next(key, value))
+    {
+        if (key == "item_code")
+            item_code = value;
+        else if (key == "src_id")
+            src_id = value;
+        else if (key == "item_num")
+            item_num = MessageParser::toIntOr(value, -1);
+        else if (key == "threshold")
+            threshold = MessageParser::toIntOr(value, 0);
+    }
+
+    int peerId = parsePeerId(src_id);
+    if (peerId < 0 || item_code.empty() || item_num < 0)
+    {
+        return "msg_type:error;detail:invalid_stock_changed;";
+    }
+    dvm->applyStockChange(peerId, string(item_code), item_num, threshold);
+
+    ostringstream oss;
+    oss << "msg_type:resp_stock_changed;"
+        << "src_id:T" << dvmId << ";"
+        << "dst_id:" << src_id << ";";
     return oss.str();
 }
+
+string Controller::handleGossipRequest(const string &msg)
+{
+    MessageParser parser(msg);
+    string_view key, value, digest, entries, src_id;
+    while (parser.next(key, value))
+    {
+        if (key == "digest")
+            digest = value;
+        else if (key == "entries")
+            entries = value;
+        else if (key == "src_id")
+            src_id = value;
+    }
+
+    vector<InventoryEntry> newer = dvm->acceptGossip(
+        parsePeerId(src_id), GossipField::parseDigest(digest), GossipField::parseEntries(entries));
+
+    ostringstream oss;
+    oss << "msg_type:resp_gossip;"
+        << "src_id:T" << dvmId << ";"
+        << "dst_id:" << src_id << ";"
+        << "entries:" << GossipField::formatEntries(newer) << ";"
+        << SocketMessage::kEndField;
+    return oss.str();
+}
+
+string Controller::handleStatsRequest(const string &msg)
+{
+    MessageParser parser(msg);
+    string_view key, value, src_id;
+    SalesQuery query;
+    while (parser.next(key, value))
+    {
+        if (key == "from_ms")
+            MessageParser::toInt(value, query.from_ms);
+        else if (key == "to_ms")
+            MessageParser::toInt(value, query.to_ms);
+        else if (key == "item_code")
+            query.item_code = value;
+        else if (key == "source")
+            query.source_dvm = parsePeerId(value);
+        else if (key == "src_id")
+            src_id = value;
+    }
+
+    SalesStats stats = dvm->querySales(query);
+
+    ostringstream oss;
+    oss << "msg_type:resp_stats;"
+        << "src_id:T" << dvmId << ";"
+        << "dst_id:" << src_id << ";"
+        << "sales:" << stats.sales << ";"
+        << "units:" << stats.units << ";"
+        << "revenue:" << stats.revenue << ";"
+        << "prepaid:" << stats.prepaid << ";"
+        << "items:" << StatsField::formatItems(stats.items) << ";"
+        << "hours:" << StatsField::formatHours(stats.units_by_hour) << ";"
+        << "sources:" << StatsField::formatSources(stats.sources) << ";"
+        << SocketMessage::kEndField;
+    return oss.str();
+}
+
+int Controller::parsePeerId(string_view id)
+{
+    if (!id.empty() && id.front() == 'T')
+    {
+        id.remove_prefix(1);
+    }
+    int peerId = MessageParser::toIntOr(id, -1);
+    return peerId >= 0 ? peerId : -1;
+}
+
+// 피어 요청에는 이 DVM의 재고만으로 답한다.
+// queryStocks는 재고가 없으면 다시 다른 DVM들에 묻기 때문에 품절 시 조회가 피어들 사이로 번진다.
+CheckStockResponse Controller::answerStockQuery(const string &itemCode, int itemNum)
+{
+    LocalStockEvaluation local = dvm->evaluateLocalStock(itemCode, itemNum);
+    static std::ofstream logFile("server_log.txt", std::ios::app);
+    {
+        std::lock_guard<std::mutex> lock(serverLogMutex);
+        logFile << "[SERVER] local stock " << itemCode << ": " << local.on_hand
+                << " (requested " << itemNum << ")" << std::endl;
+    }
+    // 이 DVM에 재고가 있을 때만 수량을 알려주고, 그 외에는 0
+    return CheckStockResponse{
+        .dst_id = 0,
+        .item_code = itemCode,
+        .item_num = local.sufficient ? itemNum : 0,
+        .coor_x = location.getX(),
+        .coor_y = location.getY()};
+}
+
+askPrepaymentResponse Controller::answerPrepayment(const askPrepaymentRequest &request)
+{
+    bool available = dvm->evaluateLocalStock(request.item_code, request.item_num).sufficient;
+    bool duplicate = false;
+    if (available)
+    {
+        // 확인과 차감 사이에 다른 구매가 끼어들 수 있으므로 차감 실패도 거절로 처리한다
+        try
+        {
+            dvm->saveSaleFromOther(request.item_code, request.item_num, request.cert_code, request.src_id);
+        }
+        catch (const DuplicateCertCodeException &)
+        {
+            available = false;
+            duplicate = true;
+        }
+        catch (const runtime_error &)
+        {
+            available = false;
+        }
+    }
+
+    return askPrepaymentResponse{
+        .item_code = request.item_code,
+        .item_num = request.item_num,
+        .availability = available,
+        .duplicate_code = duplicate};
+}
+
+string Controller::dispatchBinaryRequest(const string &payload)
+{
+    BinaryMessage request;
+    BinaryMessage response;
+    response.type = BinaryMessage::Type::Error;
+    response.srcId = dvmId;
+
+    if (BinaryCodec::decode((const uint8_t *)payload.data(), payload.size(), request))
+    {
+        response.dstId = request.srcId;
+        response.reqId = request.reqId;
+        response.itemCode = request.itemCode;
+        char itemCode[2];
+        BinaryCodec::formatItemCode(request.itemCode, itemCode);
+
+        if (request.type == BinaryMessage::Type::ReqStock)
+        {
+            CheckStockResponse answer = answerStockQuery(string(itemCode, 2), request.itemNum);
+            response.type = BinaryMessage::Type::RespStock;
+            response.itemNum = answer.item_num;
+            response.coorX = answer.coor_x;
+            response.coorY = answer.coor_y;
+        }
+        else if (request.type == BinaryMessage::Type::ReqStockBatch)
+        {
+            vector<CheckStockRequest> items;
+            items.reserve(request.batchCount);
+            for (uint8_t i = 0; i < request.batchCount; ++i)
+            {
+                BinaryCodec::formatItemCode(request.batch[i].itemCode, itemCode);
+                items.push_back(CheckStockRequest{string(itemCode, 2), request.batch[i].itemNum});
+            }
+            vector<CheckStockRequest> answer = dvm->checkLocalStocks(items);
+            response.type = BinaryMessage::Type::RespStockBatch;
+            response.itemCode = 0;
+            for (size_t i = 0; i < answer.size(); ++i)
+            {
+                response.addBatchItem(request.batch[i].itemCode, answer[i].item_num);
+            }
+            response.coorX = location.getX();
+            response.coorY = location.getY();
+        }
+        else if (request.type == BinaryMessage::Type::ReqPrepay)
+        {
+            askPrepaymentResponse answer = answerPrepayment(
+                askPrepaymentRequest{string(itemCode, 2), request.itemNum, string(request.getCertCode()),
+                                     static_cast<int>(request.srcId)});
+            response.type = BinaryMessage::Type::RespPrepay;
+            response.itemNum = answer.item_num;
+            response.availability = answer.availability;
+            if (answer.duplicate_code)
+            {
+                response.reason = BinaryMessage::ReasonDuplicateCode;
+            }
+        }
+    }
+
+    uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+    size_t size = BinaryCodec::encode(response, buffer, sizeof(buffer));
+    return string((const char *)buffer, size);
+}
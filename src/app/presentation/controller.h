@@ -5,10 +5,14 @@
 #include "../domain/location.h"
 #include "../domain/item.h"
 #include "../application/dvm.h"
+#include "../network/peerserver.h"
+#include "../network/binarycodec.h"
+#include "../network/periodictask.h"
 #include <string>
 #include <iostream>
 #include <regex>
 #include <map>
+#include <atomic>
 
 using namespace std;
 
@@ -23,9 +27,26 @@ private:
     
     //추가
     int dvmId;
+    // runServer 실행 중에만 유효한 워커 풀 (큐 깊이 보고용)
+    std::atomic<WorkerPool *> workerPool{nullptr};
     map<string, string> parseStockResponse(const string &response);
     string handleCheckStockRequest(const string &msg);
     string handlePrepaymentRequest(const string &msg);
+    string handleCheckStockBatchRequest(const string &msg);
+    string handleSubscribeRequest(const string &msg);
+    string handleStockChanged(const string &msg);
+    string handleGossipRequest(const string &msg);
+    // 판매 통계 요청 (req_stats): 판매 기록 대신 집계만 돌려준다
+    string handleStatsRequest(const string &msg);
+    // "T3" 형식의 DVM ID를 숫자로 변환 (형식이 맞지 않으면 -1)
+    static int parsePeerId(string_view id);
+    // 메시지 형식과 무관한 요청 처리 (텍스트/바이너리 핸들러가 공유)
+    CheckStockResponse answerStockQuery(const string &itemCode, int itemNum);
+    askPrepaymentResponse answerPrepayment(const askPrepaymentRequest &request);
+    // 수신한 피어 요청을 메시지 타입에 맞는 핸들러로 전달
+    string dispatchRequest(const string &request);
+    // 바이너리 codec으로 수신한 피어 요청 처리
+    string dispatchBinaryRequest(const string &payload);
 public:
     Controller(DVM* dvm);
     ~Controller();
@@ -0,0 +1,17 @@
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// 파일 전체를 원자적으로 바꿔 쓴다
+// 임시 파일에 쓰고 fdatasync한 뒤 rename하고 디렉터리를 동기화하므로,
+// 읽는 쪽은 전원이 꺼지더라도 이전 파일이나 새 파일 중 하나만 본다.
+namespace AtomicFile {
+    bool write(const string &path, const uint8_t *data, size_t size);
+}
+
+#endif // ATOMICFILE_H
@@ -0,0 +1,27 @@
+#include "checksum.h"
+#include <array>
+
+using namespace std;
+
+uint32_t Checksum::crc32(const uint8_t *data, size_t size)
+{
+    static const array<uint32_t, 256> table = [] {
+        array<uint32_t, 256> values{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            values[i] = c;
+        }
+        return values;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
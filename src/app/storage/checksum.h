@@ -0,0 +1,12 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 저장 파일의 손상을 확인하는 CRC32 (IEEE 802.3 다항식)
+namespace Checksum {
+    uint32_t crc32(const uint8_t *data, size_t size);
+}
+
+#endif // CHECKSUM_H
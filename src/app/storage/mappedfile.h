@@ -0,0 +1,31 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// 읽기 전용으로 mmap한 파일. 소멸 시 해제한다
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // 파일이 없거나 비어 있으면 false
+    bool open(const string &path);
+    void close();
+
+    const uint8_t *data() const { return mapped; }
+    size_t size() const { return mappedSize; }
+
+private:
+    const uint8_t *mapped = nullptr;
+    size_t mappedSize = 0;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,190 @@
+#include "salessegment.h"
+#include "checksum.h"
+#include "atomicfile.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <numeric>
+
+using namespace SalesSegmentFormat;
+
+namespace
+{
+    // 열마다 한 칸의 크기
+    constexpr size_t kEntrySizes[ColumnCount] = {
+        sizeof(SnapshotFormat::ItemEntry), sizeof(uint64_t), sizeof(int64_t), sizeof(uint16_t),
+        sizeof(int32_t), sizeof(int32_t), sizeof(uint8_t), sizeof(uint16_t)};
+
+    size_t alignUp(size_t offset)
+    {
+        return (offset + 7) & ~size_t(7);
+    }
+
+    // 아이템 수와 행 수로 열 위치를 정하고 파일 전체 크기를 반환한다
+    size_t layout(uint64_t itemCount, uint64_t rowCount, uint64_t (&offsets)[ColumnCount])
+    {
+        size_t offset = sizeof(Header);
+        for (uint32_t column = 0; column < ColumnCount; ++column)
+        {
+            offsets[column] = offset;
+            offset = alignUp(offset + kEntrySizes[column] * (column == ColumnItems ? itemCount : rowCount));
+        }
+        return offset;
+    }
+
+    template <typename Entry>
+    void copyColumn(vector<uint8_t> &out, uint64_t offset, const vector<Entry> &entries)
+    {
+        if (!entries.empty())
+        {
+            memcpy(out.data() + offset, entries.data(), entries.size() * sizeof(Entry));
+        }
+    }
+
+    template <typename Entry>
+    void permute(vector<Entry> &entries, const vector<size_t> &order)
+    {
+        vector<Entry> sorted;
+        sorted.reserve(order.size());
+        for (size_t index : order)
+        {
+            sorted.push_back(entries[index]);
+        }
+        entries.swap(sorted);
+    }
+}
+
+void SalesSegmentData::sortByTime()
+{
+    vector<size_t> order(size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [this](size_t a, size_t b)
+         { return timestamps[a] != timestamps[b] ? timestamps[a] < timestamps[b] : saleIds[a] < saleIds[b]; });
+    permute(saleIds, order);
+    permute(timestamps, order);
+    permute(itemIndexes, order);
+    permute(counts, order);
+    permute(amounts, order);
+    permute(flags, order);
+    permute(sourceDvms, order);
+}
+
+bool SalesSegment::open(const string &path)
+{
+    if (!file.open(path))
+    {
+        return false;
+    }
+    if (file.size() < sizeof(Header))
+    {
+        file.close();
+        return false;
+    }
+    const Header &head = header();
+    uint64_t offsets[ColumnCount];
+    // 행 수가 터무니없이 크면 위치 계산이 넘치므로 파일 크기로 먼저 거른다
+    bool valid = memcmp(head.magic, kMagic, sizeof(kMagic)) == 0 && head.rowCount <= file.size() &&
+                 head.itemCount <= file.size() && layout(head.itemCount, head.rowCount, offsets) == file.size() &&
+                 memcmp(offsets, head.columnOffsets, sizeof(offsets)) == 0;
+    if (!valid ||
+        Checksum::crc32(file.data() + sizeof(Header), file.size() - sizeof(Header)) != head.bodyCrc)
+    {
+        file.close();
+        return false;
+    }
+    // 읽는 쪽이 아이템 번호를 그대로 배열 첨자로 쓸 수 있게 한다
+    const uint16_t *indexes = itemIndexes();
+    for (uint64_t i = 0; i < head.rowCount; ++i)
+    {
+        if (indexes[i] >= head.itemCount)
+        {
+            file.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SalesSegment::write(const string &path, const SalesSegmentData &data)
+{
+    Header header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.itemCount = static_cast<uint32_t>(data.items.size());
+    header.rowCount = data.size();
+    header.dayStartMs = data.dayStartMs;
+
+    vector<uint8_t> buffer(layout(header.itemCount, header.rowCount, header.columnOffsets), 0);
+    copyColumn(buffer, header.columnOffsets[ColumnItems], data.items);
+    copyColumn(buffer, header.columnOffsets[ColumnSaleIds], data.saleIds);
+    copyColumn(buffer, header.columnOffsets[ColumnTimestamps], data.timestamps);
+    copyColumn(buffer, header.columnOffsets[ColumnItemIndexes], data.itemIndexes);
+    copyColumn(buffer, header.columnOffsets[ColumnCounts], data.counts);
+    copyColumn(buffer, header.columnOffsets[ColumnAmounts], data.amounts);
+    copyColumn(buffer, header.columnOffsets[ColumnFlags], data.flags);
+    copyColumn(buffer, header.columnOffsets[ColumnSourceDvms], data.sourceDvms);
+    header.bodyCrc = Checksum::crc32(buffer.data() + sizeof(Header), buffer.size() - sizeof(Header));
+    memcpy(buffer.data(), &header, sizeof(Header));
+
+    return AtomicFile::write(path, buffer.data(), buffer.size());
+}
+
+int64_t SalesSegment::dayStart(int64_t ms)
+{
+    int64_t day = ms / kDayMs - (ms % kDayMs < 0 ? 1 : 0);
+    return day * kDayMs;
+}
+
+string SalesSegment::fileName(int64_t dayStartMs)
+{
+    time_t seconds = static_cast<time_t>(dayStartMs / 1000);
+    tm utc{};
+    gmtime_r(&seconds, &utc);
+    char name[32];
+    strftime(name, sizeof(name), "sales-%Y%m%d.col", &utc);
+    return name;
+}
+
+const Header &SalesSegment::header() const
+{
+    return *reinterpret_cast<const Header *>(file.data());
+}
+
+const SnapshotFormat::ItemEntry *SalesSegment::items() const
+{
+    return column<SnapshotFormat::ItemEntry>(ColumnItems);
+}
+
+const uint64_t *SalesSegment::saleIds() const
+{
+    return column<uint64_t>(ColumnSaleIds);
+}
+
+const int64_t *SalesSegment::timestamps() const
+{
+    return column<int64_t>(ColumnTimestamps);
+}
+
+const uint16_t *SalesSegment::itemIndexes() const
+{
+    return column<uint16_t>(ColumnItemIndexes);
+}
+
+const int32_t *SalesSegment::counts() const
+{
+    return column<int32_t>(ColumnCounts);
+}
+
+const int32_t *SalesSegment::amounts() const
+{
+    return column<int32_t>(ColumnAmounts);
+}
+
+const uint8_t *SalesSegment::flags() const
+{
+    return column<uint8_t>(ColumnFlags);
+}
+
+const uint16_t *SalesSegment::sourceDvms() const
+{
+    return column<uint16_t>(ColumnSourceDvms);
+}
@@ -0,0 +1,97 @@
+#ifndef SALESSEGMENT_H
+#define SALESSEGMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+#include "snapshot.h"
+
+using namespace std;
+
+// 하루치 판매 기록을 열(column)별로 담는 판매 이력 파일 (sales-YYYYMMDD.col, UTC 기준)
+// 고정 크기 헤더 뒤에 아이템 배열과 열 배열이 8바이트 경계에 맞춰 이어지고,
+// 헤더에 각 열의 시작 위치를 적어 둔다. 행은 판매 시각 순으로 정렬되어 있다.
+// 파일을 mmap한 뒤 필요한 열만 복사하지 않고 그대로 훑을 수 있으며,
+// 스냅샷과 같이 원자적으로 바꿔 쓰므로 실행 중인 DVM이 내보내는 중에도 읽을 수 있다.
+namespace SalesSegmentFormat {
+    constexpr char kMagic[8] = {'D', 'V', 'M', 'S', 'A', 'L', 'E', '1'};
+    constexpr int64_t kDayMs = 24LL * 60 * 60 * 1000;
+
+    enum Column : uint32_t {
+        ColumnItems,       // SnapshotFormat::ItemEntry[itemCount]
+        ColumnSaleIds,     // u64
+        ColumnTimestamps,  // i64 (Unix ms)
+        ColumnItemIndexes, // u16 (아이템 배열의 순번)
+        ColumnCounts,      // i32
+        ColumnAmounts,     // i32
+        ColumnFlags,       // u8 (SalesLedger::Flag)
+        ColumnSourceDvms,  // u16 (판매를 받은 DVM)
+        ColumnCount
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t itemCount;
+        uint32_t bodyCrc; // 헤더 뒤 전체의 CRC32
+        uint64_t rowCount;
+        int64_t dayStartMs; // 이 파일이 담는 날의 시작 (UTC 자정, Unix ms)
+        uint64_t columnOffsets[ColumnCount]; // 파일 처음부터의 위치
+    };
+
+    static_assert(sizeof(Header) == 96, "sales segment header layout");
+}
+
+// 판매 이력 파일 하나에 쓸 내용. 열 배열의 길이는 모두 같다
+struct SalesSegmentData {
+    int64_t dayStartMs = 0;
+    vector<SnapshotFormat::ItemEntry> items;
+    vector<uint64_t> saleIds;
+    vector<int64_t> timestamps;
+    vector<uint16_t> itemIndexes;
+    vector<int32_t> counts;
+    vector<int32_t> amounts;
+    vector<uint8_t> flags;
+    vector<uint16_t> sourceDvms;
+
+    size_t size() const { return saleIds.size(); }
+    // 행들을 판매 시각(같으면 판매 ID) 순으로 정렬한다
+    void sortByTime();
+};
+
+// mmap한 판매 이력 파일을 읽는 view
+class SalesSegment {
+public:
+    // 파일이 없거나 형식, 열 위치, 크기, CRC, 아이템 번호가 맞지 않으면 false
+    bool open(const string &path);
+
+    // data를 path에 원자적으로 쓴다
+    static bool write(const string &path, const SalesSegmentData &data);
+
+    // ms가 속한 날의 UTC 자정
+    static int64_t dayStart(int64_t ms);
+    // 그날의 파일 이름 (sales-YYYYMMDD.col)
+    static string fileName(int64_t dayStartMs);
+
+    const SalesSegmentFormat::Header &header() const;
+    uint64_t size() const { return header().rowCount; }
+    const SnapshotFormat::ItemEntry *items() const;
+    const uint64_t *saleIds() const;
+    const int64_t *timestamps() const;
+    const uint16_t *itemIndexes() const;
+    const int32_t *counts() const;
+    const int32_t *amounts() const;
+    const uint8_t *flags() const;
+    const uint16_t *sourceDvms() const;
+
+private:
+    MappedFile file;
+
+    template <typename T>
+    const T *column(SalesSegmentFormat::Column column) const {
+        return reinterpret_cast<const T *>(file.data() + header().columnOffsets[column]);
+    }
+};
+
+#endif // SALESSEGMENT_H
@@ -0,0 +1,93 @@
+#include "snapshot.h"
+#include "checksum.h"
+#include "atomicfile.h"
+#include <cstring>
+
+using namespace SnapshotFormat;
+
+namespace
+{
+    size_t bodySize(const Header &header)
+    {
+        return header.itemCount * sizeof(ItemEntry) + header.stockCount * sizeof(StockEntry) +
+               header.certCount * sizeof(CertEntry) + header.saleCount * sizeof(SaleEntry);
+    }
+
+    template <typename Entry>
+    void appendArray(vector<uint8_t> &out, const vector<Entry> &entries)
+    {
+        const uint8_t *begin = reinterpret_cast<const uint8_t *>(entries.data());
+        out.insert(out.end(), begin, begin + entries.size() * sizeof(Entry));
+    }
+}
+
+bool MappedSnapshot::open(const string &path)
+{
+    if (!file.open(path))
+    {
+        return false;
+    }
+    if (file.size() < sizeof(Header))
+    {
+        file.close();
+        return false;
+    }
+    const Header &head = header();
+    if (memcmp(head.magic, kMagic, sizeof(kMagic)) != 0 ||
+        file.size() != sizeof(Header) + bodySize(head) ||
+        Checksum::crc32(file.data() + sizeof(Header), file.size() - sizeof(Header)) != head.bodyCrc)
+    {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedSnapshot::write(const string &path, const SnapshotData &data)
+{
+    Header header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.itemCount = static_cast<uint32_t>(data.items.size());
+    header.stockCount = static_cast<uint32_t>(data.stocks.size());
+    header.certCount = static_cast<uint32_t>(data.certs.size());
+    header.saleCount = data.sales.size();
+    header.walOffset = data.walOffset;
+    header.createdAtMs = data.createdAtMs;
+
+    vector<uint8_t> buffer;
+    buffer.reserve(sizeof(Header) + bodySize(header));
+    buffer.resize(sizeof(Header));
+    appendArray(buffer, data.items);
+    appendArray(buffer, data.stocks);
+    appendArray(buffer, data.certs);
+    appendArray(buffer, data.sales);
+    header.bodyCrc = Checksum::crc32(buffer.data() + sizeof(Header), buffer.size() - sizeof(Header));
+    memcpy(buffer.data(), &header, sizeof(Header));
+
+    return AtomicFile::write(path, buffer.data(), buffer.size());
+}
+
+const Header &MappedSnapshot::header() const
+{
+    return *reinterpret_cast<const Header *>(file.data());
+}
+
+const ItemEntry *MappedSnapshot::items() const
+{
+    return reinterpret_cast<const ItemEntry *>(file.data() + sizeof(Header));
+}
+
+const StockEntry *MappedSnapshot::stocks() const
+{
+    return reinterpret_cast<const StockEntry *>(items() + header().itemCount);
+}
+
+const CertEntry *MappedSnapshot::certs() const
+{
+    return reinterpret_cast<const CertEntry *>(stocks() + header().stockCount);
+}
+
+const SaleEntry *MappedSnapshot::sales() const
+{
+    return reinterpret_cast<const SaleEntry *>(certs() + header().certCount);
+}
@@ -0,0 +1,116 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+using namespace std;
+
+// DVM 상태의 한 시점 스냅샷 파일
+// 고정 크기 헤더 뒤에 아이템, 재고, 인증코드, 판매 배열이 이어지는 형식으로,
+// 파일을 mmap한 뒤 각 배열을 복사하거나 해석하지 않고 그대로 읽는다.
+// 임시 파일에 쓰고 fdatasync한 뒤 rename하므로 읽는 쪽은 항상 완전한 최신 파일을 본다.
+namespace SnapshotFormat {
+    constexpr char kMagic[8] = {'D', 'V', 'M', 'S', 'N', 'A', 'P', '2'};
+
+    struct Header {
+        char magic[8];
+        uint32_t itemCount;
+        uint32_t stockCount;
+        uint32_t certCount;
+        uint32_t bodyCrc; // 헤더 뒤 전체의 CRC32
+        uint64_t saleCount;
+        // 스냅샷에 반영된 로그의 끝 위치 (복구 시 여기부터 다시 읽는다)
+        uint64_t walOffset;
+        int64_t createdAtMs;
+    };
+
+    // 문자열은 널 문자로 끝나는 고정 크기 칸에 담는다
+    struct ItemEntry {
+        char code[16];
+        char name[64];
+        int32_t price;
+        int32_t reserved;
+    };
+
+    struct StockEntry {
+        char code[16];
+        int32_t count;
+        int32_t reserved;
+    };
+
+    struct CertEntry {
+        char code[16];
+        char itemCode[16];
+        int32_t count;
+        int32_t reserved;
+        int64_t expiresAtMs; // Unix ms (0이면 만료하지 않음)
+        uint64_t saleId;     // 이 코드로 수령할 판매 (0이면 없음)
+    };
+
+    struct SaleEntry {
+        uint64_t saleId;
+        int64_t createdAtMs;
+        int32_t count;
+        int32_t amount;
+        uint32_t itemIndex; // ItemEntry 배열의 순번
+        uint8_t flags;
+        uint8_t reserved;
+        uint16_t sourceDvm;
+    };
+
+    static_assert(sizeof(Header) == 48, "snapshot header layout");
+    static_assert(sizeof(ItemEntry) == 88 && sizeof(StockEntry) == 24, "snapshot entry layout");
+    static_assert(sizeof(CertEntry) == 56 && sizeof(SaleEntry) == 32, "snapshot entry layout");
+
+    // 고정 크기 칸에 문자열을 넣고 꺼낸다 (칸보다 길면 잘린다)
+    template <size_t N>
+    void setText(char (&field)[N], const string &value) {
+        size_t size = value.size() < N - 1 ? value.size() : N - 1;
+        value.copy(field, size);
+        field[size] = '\0';
+    }
+
+    template <size_t N>
+    string getText(const char (&field)[N]) {
+        size_t size = 0;
+        while (size < N && field[size] != '\0') {
+            ++size;
+        }
+        return string(field, size);
+    }
+}
+
+// 스냅샷에 쓸 내용
+struct SnapshotData {
+    uint64_t walOffset = 0;
+    int64_t createdAtMs = 0;
+    vector<SnapshotFormat::ItemEntry> items;
+    vector<SnapshotFormat::StockEntry> stocks;
+    vector<SnapshotFormat::CertEntry> certs;
+    vector<SnapshotFormat::SaleEntry> sales;
+};
+
+// mmap한 스냅샷 파일을 읽는 view
+class MappedSnapshot {
+public:
+    // 파일이 없거나 형식, 크기, CRC가 맞지 않으면 false
+    bool open(const string &path);
+
+    // data를 path에 원자적으로 쓴다
+    static bool write(const string &path, const SnapshotData &data);
+
+    const SnapshotFormat::Header &header() const;
+    const SnapshotFormat::ItemEntry *items() const;
+    const SnapshotFormat::StockEntry *stocks() const;
+    const SnapshotFormat::CertEntry *certs() const;
+    const SnapshotFormat::SaleEntry *sales() const;
+
+private:
+    MappedFile file;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,477 @@
+#include "writeaheadlog.h"
+#include "checksum.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+    const size_t kHeaderSize = 8;
+    // Segment 기록 하나의 크기 ([길이][CRC][종류][시작 위치 u64])
+    const size_t kSegmentSize = kHeaderSize + 1 + 8;
+    // 한 기록의 최대 길이 (이보다 길면 깨진 기록으로 본다)
+    const uint32_t kMaxRecordSize = 1024;
+
+    template <typename Int>
+    void put(vector<uint8_t> &out, Int value)
+    {
+        for (size_t i = 0; i < sizeof(Int); ++i)
+        {
+            out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+        }
+    }
+
+    void putText(vector<uint8_t> &out, string_view text)
+    {
+        size_t size = text.size() < 255 ? text.size() : 255;
+        out.push_back(static_cast<uint8_t>(size));
+        out.insert(out.end(), text.begin(), text.begin() + size);
+    }
+
+    // 내용을 읽는 커서. 범위를 넘으면 ok가 false가 된다
+    struct Reader
+    {
+        const uint8_t *data;
+        size_t size;
+        size_t offset = 0;
+        bool ok = true;
+
+        template <typename Int>
+        Int get()
+        {
+            if (size - offset < sizeof(Int))
+            {
+                ok = false;
+                return 0;
+            }
+            uint64_t value = 0;
+            for (size_t i = 0; i < sizeof(Int); ++i)
+            {
+                value |= static_cast<uint64_t>(data[offset + i]) << (8 * i);
+            }
+            offset += sizeof(Int);
+            return static_cast<Int>(value);
+        }
+
+        string_view text()
+        {
+            uint8_t length = get<uint8_t>();
+            if (!ok || size - offset < length)
+            {
+                ok = false;
+                return {};
+            }
+            string_view value(reinterpret_cast<const char *>(data + offset), length);
+            offset += length;
+            return value;
+        }
+    };
+
+    // start부터 쓴 기록 내용 앞에 길이와 CRC를 채운다
+    void seal(vector<uint8_t> &out, size_t start)
+    {
+        uint32_t length = static_cast<uint32_t>(out.size() - start - kHeaderSize);
+        uint32_t crc = Checksum::crc32(out.data() + start + kHeaderSize, length);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            out[start + i] = static_cast<uint8_t>(length >> (8 * i));
+            out[start + 4 + i] = static_cast<uint8_t>(crc >> (8 * i));
+        }
+    }
+
+    // 파일 맨 앞의 Segment 기록에서 첫 바이트의 논리 위치를 읽는다. 없으면 0 (앞부분을 버린 적이 없는 파일)
+    // 반환값은 Segment 기록의 크기
+    size_t readSegment(const uint8_t *data, size_t size, uint64_t &fileStart)
+    {
+        fileStart = 0;
+        if (size < kSegmentSize)
+        {
+            return 0;
+        }
+        Reader reader{data, kSegmentSize};
+        uint32_t length = reader.get<uint32_t>();
+        uint32_t crc = reader.get<uint32_t>();
+        if (length != kSegmentSize - kHeaderSize || Checksum::crc32(data + kHeaderSize, length) != crc ||
+            static_cast<WalRecordType>(reader.get<uint8_t>()) != WalRecordType::Segment)
+        {
+            return 0;
+        }
+        fileStart = reader.get<uint64_t>();
+        return kSegmentSize;
+    }
+
+    size_t readSegment(const string &path, uint64_t &fileStart)
+    {
+        uint8_t head[kSegmentSize];
+        ifstream file(path, ios::binary);
+        size_t size = file ? static_cast<size_t>(file.read(reinterpret_cast<char *>(head), kSegmentSize).gcount()) : 0;
+        return readSegment(head, size, fileStart);
+    }
+
+    bool hasSale(WalRecordType type)
+    {
+        return type == WalRecordType::Order || type == WalRecordType::PrepaidSaved;
+    }
+
+    bool hasItem(WalRecordType type)
+    {
+        return hasSale(type) || type == WalRecordType::Restock;
+    }
+
+    bool hasCertCode(WalRecordType type)
+    {
+        return type == WalRecordType::PrepaidSaved || type == WalRecordType::PrepaidRedeemed ||
+               type == WalRecordType::CertExpired;
+    }
+}
+
+WalRecord WalRecord::order(uint64_t saleId, int64_t createdAtMs, string_view itemCode, int32_t count, int32_t amount,
+                           int32_t sourceDvm)
+{
+    WalRecord record;
+    record.type = WalRecordType::Order;
+    record.saleId = saleId;
+    record.createdAtMs = createdAtMs;
+    record.itemCode = itemCode;
+    record.count = count;
+    record.amount = amount;
+    record.sourceDvm = sourceDvm;
+    return record;
+}
+
+WalRecord WalRecord::prepaidSaved(uint64_t saleId, int64_t createdAtMs, string_view itemCode, int32_t count,
+                                  int32_t amount, string_view certCode, int32_t sourceDvm)
+{
+    WalRecord record = order(saleId, createdAtMs, itemCode, count, amount, sourceDvm);
+    record.type = WalRecordType::PrepaidSaved;
+    record.certCode = certCode;
+    return record;
+}
+
+WalRecord WalRecord::prepaidRedeemed(string_view certCode)
+{
+    WalRecord record;
+    record.type = WalRecordType::PrepaidRedeemed;
+    record.certCode = certCode;
+    return record;
+}
+
+WalRecord WalRecord::restock(string_view itemCode, int32_t count)
+{
+    WalRecord record;
+    record.type = WalRecordType::Restock;
+    record.itemCode = itemCode;
+    record.count = count;
+    return record;
+}
+
+WalRecord WalRecord::certExpired(string_view certCode)
+{
+    WalRecord record;
+    record.type = WalRecordType::CertExpired;
+    record.certCode = certCode;
+    return record;
+}
+
+WriteAheadLog::WriteAheadLog(string path, bool sync) : path(move(path)), sync(sync) {}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    uint64_t last;
+    {
+        lock_guard<mutex> lock(logMutex);
+        last = appendedLsn;
+    }
+    commit(last);
+    close(fd);
+}
+
+bool WriteAheadLog::open()
+{
+    return open(readAll(path, [](const WalRecord &) {}));
+}
+
+bool WriteAheadLog::open(uint64_t validEnd)
+{
+    size_t segmentSize = readSegment(path, fileStart);
+    if (validEnd < fileStart + segmentSize)
+    {
+        return false;
+    }
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    // 기록 도중 멈춘 흔적을 지워야 뒤에 붙이는 기록을 다시 읽을 수 있다
+    if (ftruncate(fd, static_cast<off_t>(validEnd - fileStart)) != 0 || lseek(fd, 0, SEEK_END) < 0)
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    appendedBytes = validEnd;
+    writtenBytes = validEnd;
+    pending.reserve(64 * 1024);
+    writing.reserve(64 * 1024);
+    return true;
+}
+
+uint64_t WriteAheadLog::append(const WalRecord &record)
+{
+    lock_guard<mutex> lock(logMutex);
+    size_t start = pending.size();
+    pending.resize(start + kHeaderSize);
+    pending.push_back(static_cast<uint8_t>(record.type));
+    if (hasSale(record.type))
+    {
+        put(pending, record.saleId);
+        put(pending, record.createdAtMs);
+        put(pending, record.amount);
+        put(pending, static_cast<uint16_t>(record.sourceDvm));
+    }
+    if (hasItem(record.type))
+    {
+        put(pending, record.count);
+        putText(pending, record.itemCode);
+    }
+    if (hasCertCode(record.type))
+    {
+        putText(pending, record.certCode);
+    }
+    seal(pending, start);
+    appendedBytes += pending.size() - start;
+    return ++appendedLsn;
+}
+
+bool WriteAheadLog::commit(uint64_t lsn)
+{
+    unique_lock<mutex> lock(logMutex);
+    while (durableLsn < lsn)
+    {
+        if (failed || fd < 0)
+        {
+            return false;
+        }
+        if (flushing)
+        {
+            // 다른 스레드가 내보내는 중이면 끝나기를 기다린 뒤 내 기록이 포함되었는지 본다
+            flushedCondition.wait(lock);
+            continue;
+        }
+
+        flushing = true;
+        swap(pending, writing);
+        uint64_t upTo = appendedLsn;
+        lock.unlock();
+        bool ok = writeAll(fd, writing.data(), writing.size()) && (!sync || fdatasync(fd) == 0);
+        size_t written = writing.size();
+        writing.clear();
+        lock.lock();
+
+        flushing = false;
+        if (ok)
+        {
+            writtenBytes += written;
+            durableLsn = upTo;
+            ++syncCount;
+        }
+        else
+        {
+            failed = true;
+        }
+        flushedCondition.notify_all();
+    }
+    return true;
+}
+
+uint64_t WriteAheadLog::getSyncCount() const
+{
+    lock_guard<mutex> lock(logMutex);
+    return syncCount;
+}
+
+uint64_t WriteAheadLog::getAppendedBytes() const
+{
+    lock_guard<mutex> lock(logMutex);
+    return appendedBytes;
+}
+
+bool WriteAheadLog::discardBefore(uint64_t offset)
+{
+    uint64_t last;
+    {
+        lock_guard<mutex> lock(logMutex);
+        last = appendedLsn;
+    }
+    // offset까지의 기록이 파일에 있어야 그 뒤를 옮길 수 있다
+    if (!commit(last))
+    {
+        return false;
+    }
+    unique_lock<mutex> lock(logMutex);
+    if (failed || fd < 0 || discarding || offset <= fileStart + kSegmentSize || offset > writtenBytes)
+    {
+        return false;
+    }
+    discarding = true;
+    uint64_t oldStart = fileStart;
+    uint64_t copiedEnd = writtenBytes;
+    lock.unlock();
+
+    // 새 파일을 끝까지 기록한 뒤 이름을 바꾸므로, 언제 멈춰도 옛 파일이나 새 파일 중 하나가 온전히 남는다.
+    // 옛 파일은 뒤에 붙기만 하므로 여기까지는 잠그지 않고 복사와 fdatasync를 한다
+    vector<uint8_t> header(kHeaderSize);
+    header.push_back(static_cast<uint8_t>(WalRecordType::Segment));
+    // offset에 있던 기록이 새 파일에서는 Segment 기록 바로 뒤에 온다
+    put(header, offset - kSegmentSize);
+    seal(header, 0);
+    string temporary = path + ".tmp";
+    int source = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    int next = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = source >= 0 && next >= 0 && writeAll(next, header.data(), header.size()) &&
+              copyRange(source, next, offset - oldStart, copiedEnd - offset) && fdatasync(next) == 0;
+
+    // 그 사이 옛 파일에 붙은 기록을 옮기는 동안만 다른 스레드가 내보내지 못하게 한다 (append는 계속된다)
+    lock.lock();
+    if (ok)
+    {
+        flushedCondition.wait(lock, [this] { return !flushing; });
+        flushing = true;
+        uint64_t tailEnd = writtenBytes;
+        lock.unlock();
+        ok = copyRange(source, next, copiedEnd - oldStart, tailEnd - copiedEnd) &&
+             (tailEnd == copiedEnd || fdatasync(next) == 0) && rename(temporary.c_str(), path.c_str()) == 0;
+        lock.lock();
+    }
+    if (source >= 0)
+    {
+        close(source);
+    }
+    if (ok)
+    {
+        close(fd);
+        fd = next;
+        fileStart = offset - kSegmentSize;
+    }
+    else if (next >= 0)
+    {
+        close(next);
+        unlink(temporary.c_str());
+    }
+    flushing = false;
+    discarding = false;
+    flushedCondition.notify_all();
+    return ok;
+}
+
+size_t WriteAheadLog::readAll(const string &path, const function<void(const WalRecord &)> &visit, size_t from)
+{
+    uint64_t fileStart = 0;
+    size_t segmentSize = readSegment(path, fileStart);
+    // 버린 위치부터 읽으라고 하면 남은 첫 기록부터 읽는다
+    if (from < fileStart + segmentSize)
+    {
+        from = fileStart + segmentSize;
+    }
+    ifstream file(path, ios::binary);
+    if (!file || !file.seekg(static_cast<streamoff>(from - fileStart)))
+    {
+        return from;
+    }
+    vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    while (data.size() - offset >= kHeaderSize)
+    {
+        Reader header{data.data() + offset, kHeaderSize};
+        uint32_t length = header.get<uint32_t>();
+        uint32_t crc = header.get<uint32_t>();
+        if (length == 0 || length > kMaxRecordSize || data.size() - offset - kHeaderSize < length)
+        {
+            break;
+        }
+        const uint8_t *body = data.data() + offset + kHeaderSize;
+        if (Checksum::crc32(body, length) != crc)
+        {
+            break;
+        }
+
+        Reader reader{body, length};
+        WalRecord record;
+        record.type = static_cast<WalRecordType>(reader.get<uint8_t>());
+        if (record.type < WalRecordType::Order || record.type > WalRecordType::CertExpired)
+        {
+            break;
+        }
+        if (hasSale(record.type))
+        {
+            record.saleId = reader.get<uint64_t>();
+            record.createdAtMs = reader.get<int64_t>();
+            record.amount = reader.get<int32_t>();
+            record.sourceDvm = reader.get<uint16_t>();
+        }
+        if (hasItem(record.type))
+        {
+            record.count = reader.get<int32_t>();
+            record.itemCode = reader.text();
+        }
+        if (hasCertCode(record.type))
+        {
+            record.certCode = reader.text();
+        }
+        if (!reader.ok)
+        {
+            break;
+        }
+        visit(record);
+        offset += kHeaderSize + length;
+    }
+    return from + offset;
+}
+
+bool WriteAheadLog::writeAll(int target, const uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(target, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool WriteAheadLog::copyRange(int source, int target, uint64_t from, uint64_t size)
+{
+    uint8_t buffer[64 * 1024];
+    while (size > 0)
+    {
+        size_t chunk = size < sizeof(buffer) ? static_cast<size_t>(size) : sizeof(buffer);
+        ssize_t read = pread(source, buffer, chunk, static_cast<off_t>(from));
+        if (read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (read <= 0 || !writeAll(target, buffer, static_cast<size_t>(read)))
+        {
+            return false;
+        }
+        from += static_cast<uint64_t>(read);
+        size -= static_cast<uint64_t>(read);
+    }
+    return true;
+}
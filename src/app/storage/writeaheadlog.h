@@ -0,0 +1,114 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// 재고와 판매를 바꾸는 작업 하나의 기록
+enum class WalRecordType : uint8_t {
+    Order = 1,           // 일반 판매 (재고 차감 포함)
+    PrepaidSaved = 2,    // 다른 DVM의 선결제 저장 (재고 차감, 인증코드 등록 포함)
+    PrepaidRedeemed = 3, // 선결제 아이템 수령
+    Restock = 4,         // 재고 보충
+    CertExpired = 5,     // 수령하지 않은 인증코드 만료 (잡아 둔 재고 반환)
+    Segment = 6,         // 파일 맨 앞에만 오는, 앞부분을 버린 파일의 시작 위치 (읽을 때 건너뛴다)
+};
+
+// 기록을 쓰고 읽을 때 쓰는 값. 문자열은 호출자의 버퍼를 가리킨다
+// 종류마다 쓰는 필드가 다르므로 아래의 생성 함수로 만든다
+struct WalRecord {
+    WalRecordType type = WalRecordType::Order;
+    uint64_t saleId = 0;
+    int64_t createdAtMs = 0;
+    int32_t count = 0;
+    int32_t amount = 0;
+    string_view itemCode;
+    string_view certCode;
+    int32_t sourceDvm = 0; // 판매를 받은 DVM
+
+    static WalRecord order(uint64_t saleId, int64_t createdAtMs, string_view itemCode, int32_t count, int32_t amount,
+                           int32_t sourceDvm);
+    static WalRecord prepaidSaved(uint64_t saleId, int64_t createdAtMs, string_view itemCode, int32_t count,
+                                  int32_t amount, string_view certCode, int32_t sourceDvm);
+    static WalRecord prepaidRedeemed(string_view certCode);
+    static WalRecord restock(string_view itemCode, int32_t count);
+    static WalRecord certExpired(string_view certCode);
+};
+
+// 추가만 하는 선행 기록 로그(write-ahead log)
+// 기록 형식: [길이 u32][CRC32 u32][종류 u8][내용] (정수는 little-endian)
+// 판매 기록의 내용은 [판매 ID u64][시각 i64][금액 i32][출처 DVM u16][수량 i32][아이템 코드] 순이다.
+// append는 메모리 버퍼에 기록을 붙이고 번호(LSN)를 돌려준다.
+// commit은 그 번호까지 디스크에 기록될 때까지 기다리는데, 먼저 온 스레드 하나가
+// 그때까지 쌓인 모든 스레드의 기록을 한 번의 write와 fdatasync로 내보낸다(group commit).
+// 위치(offset)는 로그가 처음 만들어진 때부터 센 논리 위치다. discardBefore로 앞부분을 버린 파일은
+// 맨 앞의 Segment 기록에 자기 첫 바이트의 논리 위치를 적어 두므로, 스냅샷에 적은 위치는 계속 유효하다.
+class WriteAheadLog {
+public:
+    // sync가 false이면 fdatasync를 생략한다 (운영체제 캐시까지만 기록)
+    explicit WriteAheadLog(string path, bool sync = true);
+    // 남은 기록을 내보내고 파일을 닫는다
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    // 파일을 열고 끝에 덜 쓰인 기록이 있으면 잘라낸다
+    bool open();
+    // readAll로 이미 찾은 온전한 기록의 끝(validEnd) 뒤를 잘라내고 연다 (파일을 다시 읽지 않는다)
+    bool open(uint64_t validEnd);
+
+    uint64_t append(const WalRecord &record);
+    // lsn까지의 기록이 디스크에 기록되면 true (쓰기에 실패하면 false)
+    bool commit(uint64_t lsn);
+
+    // 지금까지 디스크에 내보낸 횟수
+    uint64_t getSyncCount() const;
+    // 지금까지 append한 기록이 끝나는 위치 (스냅샷 이후 다시 읽을 곳)
+    uint64_t getAppendedBytes() const;
+
+    // offset 앞의 기록을 버리고 그 뒤의 기록만 새 파일로 옮긴다 (스냅샷이 디스크에 기록된 뒤에 부른다).
+    // 옮기는 동안에도 append와 commit은 계속되고, 마지막에 그 사이 파일에 붙은 기록만 옮길 때
+    // commit이 한 번 내보낼 만큼 기다린다. 버릴 것이 없거나 이미 옮기는 중이거나 실패하면 false
+    bool discardBefore(uint64_t offset);
+
+    // 파일의 from 위치부터 기록을 차례로 읽는다. 덜 쓰이거나 깨진 기록을 만나면 거기서 멈추고,
+    // 온전한 기록이 끝나는 위치를 반환한다 (파일을 열 수 없으면 from).
+    // from이 이미 버린 위치이면 파일에 남은 첫 기록부터 읽는다
+    static size_t readAll(const string &path, const function<void(const WalRecord &)> &visit, size_t from = 0);
+
+private:
+    string path;
+    bool sync;
+    int fd = -1;
+    // 파일 첫 바이트의 논리 위치
+    uint64_t fileStart = 0;
+
+    mutable mutex logMutex;
+    condition_variable flushedCondition;
+    // 다음에 내보낼 기록과 지금 내보내는 중인 기록 (용량은 계속 다시 쓴다)
+    vector<uint8_t> pending;
+    vector<uint8_t> writing;
+    uint64_t appendedLsn = 0;
+    uint64_t durableLsn = 0;
+    uint64_t syncCount = 0;
+    uint64_t appendedBytes = 0;
+    // 파일에 기록을 마친 곳의 논리 위치
+    uint64_t writtenBytes = 0;
+    bool flushing = false;
+    bool discarding = false;
+    bool failed = false;
+
+    static bool writeAll(int target, const uint8_t *data, size_t size);
+    // source 파일의 [from, from + size)를 target 끝에 붙인다
+    static bool copyRange(int source, int target, uint64_t from, uint64_t size);
+};
+
+#endif // WRITEAHEADLOG_H
@@ -0,0 +1,75 @@
+// 판매 통계 벤치마크
+// 같은 판매 장부에서 기록을 하나씩 방문하며 map에 더하는 방식과
+// 열 배열을 묶음 단위로 훑는 SalesAnalytics를 스레드 수별로 비교한다.
+#include "../app/application/salesanalytics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const int kWriters = 8;
+    const int kSalesPerWriter = 250000;
+
+    template <typename Run>
+    void measure(const char *name, size_t rows, Run &&run) {
+        auto begin = chrono::steady_clock::now();
+        SalesStats stats = run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        printf("%-24s %8.1f ms %10.1f M rows/s  (revenue %lld)\n", name, seconds * 1000, rows / seconds / 1e6,
+               (long long)stats.revenue);
+    }
+}
+
+int main() {
+    SalesLedger ledger(kWriters);
+    Item coke("01", "콜라", 1000);
+    Item tea("04", "홍차", 1500);
+    vector<thread> writers;
+    for (int t = 0; t < kWriters; ++t) {
+        writers.emplace_back([&, t]() {
+            for (int i = 0; i < kSalesPerWriter; ++i) {
+                const Item &item = i % 3 ? coke : tea;
+                ledger.restore((uint64_t)t << 32 | i, 1700000000000 + i * 500LL, item, 1 + i % 3,
+                               item.calculatePrice(1 + i % 3), i % 5 == 0 ? SalesLedger::FlagPrepaid : 0, t);
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    size_t rows = ledger.size();
+    SalesQuery query;
+    query.from_ms = 1700000000000 + 3600 * 1000LL;
+
+    measure("forEach + map", rows, [&]() {
+        SalesStats stats;
+        ledger.forEach([&](const SalesLedger::Record &record) {
+            if (record.createdAtMs < query.from_ms || (record.flags & SalesLedger::FlagExpired)) {
+                return;
+            }
+            ++stats.sales;
+            stats.units += record.count;
+            stats.revenue += record.totalAmount;
+            ItemSalesTotals &item = stats.items[record.item->getItemCode()];
+            ++item.sales;
+            item.units += record.count;
+            item.revenue += record.totalAmount;
+            stats.units_by_hour[record.createdAtMs / SalesAnalytics::kHourMs * SalesAnalytics::kHourMs] += record.count;
+        });
+        return stats;
+    });
+    unsigned hardware = thread::hardware_concurrency();
+    for (int threads : {1, 2, 4, 8}) {
+        if (threads > 1 && (unsigned)threads > hardware) {
+            break;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "SalesAnalytics x%d", threads);
+        measure(name, rows, [&]() { return SalesAnalytics::query(ledger, query, threads); });
+    }
+    return 0;
+}
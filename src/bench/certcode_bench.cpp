@@ -0,0 +1,110 @@
+// 인증코드 생성 마이크로벤치마크
+// 호출마다 시계로 시드한 mt19937을 만들던 기존 방식과 CertCodeGenerator의
+// 초당 생성 수를 스레드 수별로 비교하고, 코드당 힙 할당 횟수를 센다.
+#include "../app/domain/certcodegenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    atomic<size_t> allocationCount{0};
+}
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void *ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+    const int kIterations = 200000;
+    // 새 생성기에 허용하는 코드당 할당 수 (스레드 생성 등 측정 잡음만 허용한다)
+    const double kMaxAllocationsPerCode = 0.001;
+
+    // 변경 전 CertificationCode 생성자의 방식
+    int generateLegacy() {
+        const string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        mt19937 rng(static_cast<unsigned int>(chrono::steady_clock::now().time_since_epoch().count()));
+        uniform_int_distribution<int> dist(0, characters.size() - 1);
+        string value;
+        for (int i = 0; i < 5; ++i) {
+            value += characters[dist(rng)];
+        }
+        return value[0];
+    }
+
+    // 할당 없이 같은 방식으로 반복하여 스레드 생성 등에 드는 할당을 잰다
+    int generateNothing() {
+        return 0;
+    }
+
+    int generateFast() {
+        char code[CertCodeGenerator::kLength];
+        CertCodeGenerator::generate(code);
+        return code[0];
+    }
+
+    // threads개의 스레드가 각각 kIterations개를 만들 때의 초당 생성 수와 코드당 할당 수
+    // (baseline은 빈 fn으로 잰 코드당 할당 수로, 결과에서 뺀다)
+    template <typename Fn>
+    double measure(const char *name, int threads, Fn fn, double baseline = 0) {
+        size_t allocationsBefore = allocationCount.load();
+        auto begin = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([fn] {
+                volatile int sink = 0;
+                for (int i = 0; i < kIterations; ++i) {
+                    sink = sink + fn();
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        auto elapsed = chrono::steady_clock::now() - begin;
+        double allocations =
+            (double)(allocationCount.load() - allocationsBefore) / ((double)kIterations * threads) - baseline;
+
+        double codesPerSecond = (double)kIterations * threads / chrono::duration<double>(elapsed).count();
+        printf("%-10s %2d threads %14.0f codes/s %9.6f allocs/code\n", name, threads, codesPerSecond, allocations);
+        return allocations;
+    }
+}
+
+int main() {
+    int maxThreads = (int)thread::hardware_concurrency();
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    double maxFastAllocations = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        double baseline = measure("baseline", threads, generateNothing);
+        measure("legacy", threads, generateLegacy, baseline);
+        maxFastAllocations = max(maxFastAllocations, measure("generator", threads, generateFast, baseline));
+    }
+
+    // 새 생성기는 코드당 할당이 없어야 한다
+    return maxFastAllocations <= kMaxAllocationsPerCode ? 0 : 1;
+}
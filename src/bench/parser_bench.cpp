@@ -0,0 +1,110 @@
+// 피어 메시지 파싱 마이크로벤치마크
+// 기존 istringstream/getline 파싱과 MessageParser, BinaryCodec의
+// 메시지당 처리 시간과 힙 할당 횟수를 비교한다.
+#include "../app/network/messageparser.h"
+#include "../app/network/binarycodec.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+    atomic<size_t> allocationCount{0};
+}
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void *ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+    const string kRequest = "msg_type:req_prepay;src_id:T3;dst_id:T1;item_code:07;item_num:2;cert_code:aB3xZ;";
+    const int kIterations = 200000;
+
+    // 변경 전 핸들러의 파싱 방식
+    int parseLegacy(const string &msg) {
+        map<string, string> parsed;
+        istringstream iss(msg);
+        string token;
+        while (getline(iss, token, ';')) {
+            size_t pos = token.find(':');
+            if (pos == string::npos)
+                continue;
+            parsed[token.substr(0, pos)] = token.substr(pos + 1);
+        }
+        return stoi(parsed["item_num"]) + (int)parsed["cert_code"].size();
+    }
+
+    int parseWithMessageParser(const string &msg) {
+        MessageParser parser(msg);
+        string_view key, value, certCode;
+        int itemNum = 0;
+        while (parser.next(key, value)) {
+            if (key == "item_num")
+                itemNum = MessageParser::toIntOr(value, 0);
+            else if (key == "cert_code")
+                certCode = value;
+        }
+        return itemNum + (int)certCode.size();
+    }
+
+    int roundTripBinary(const BinaryMessage &msg) {
+        uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+        size_t size = BinaryCodec::encode(msg, buffer, sizeof(buffer));
+        BinaryMessage decoded;
+        BinaryCodec::decode(buffer, size, decoded);
+        return decoded.itemNum + decoded.certLength;
+    }
+
+    template <typename Fn>
+    double measure(const char *name, Fn fn) {
+        volatile int sink = 0;
+        size_t allocationsBefore = allocationCount.load();
+        auto begin = chrono::steady_clock::now();
+        for (int i = 0; i < kIterations; ++i) {
+            sink = sink + fn();
+        }
+        auto elapsed = chrono::steady_clock::now() - begin;
+        size_t allocations = allocationCount.load() - allocationsBefore;
+
+        double nsPerMessage = chrono::duration<double, nano>(elapsed).count() / kIterations;
+        double allocationsPerMessage = (double)allocations / kIterations;
+        printf("%-16s %10.1f ns/msg %8.2f allocs/msg\n", name, nsPerMessage, allocationsPerMessage);
+        return allocationsPerMessage;
+    }
+}
+
+int main() {
+    BinaryMessage binary;
+    binary.type = BinaryMessage::Type::ReqPrepay;
+    binary.srcId = 3;
+    binary.dstId = 1;
+    binary.itemCode = 7;
+    binary.itemNum = 2;
+    binary.setCertCode("aB3xZ");
+
+    measure("legacy", [] { return parseLegacy(kRequest); });
+    double parserAllocations = measure("MessageParser", [] { return parseWithMessageParser(kRequest); });
+    double binaryAllocations = measure("BinaryCodec", [&binary] { return roundTripBinary(binary); });
+
+    // 새 파서와 바이너리 codec은 메시지당 할당이 없어야 한다
+    return parserAllocations == 0 && binaryAllocations == 0 ? 0 : 1;
+}
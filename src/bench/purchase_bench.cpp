@@ -0,0 +1,84 @@
+// 구매 경로 할당 횟수 벤치마크
+// DVM::requestOrder와 다른 DVM의 선결제 저장(saveSaleFromOther) 후 수령(processPrepaidItem)을
+// 반복하며 호출당 처리 시간과 힙 할당 횟수를 잰다.
+// 준비 구간 뒤의 호출당 할당이 기준을 넘으면 0이 아닌 값으로 끝나므로 ctest에서 회귀를 잡는다.
+#include "../app/application/dvm.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    atomic<size_t> allocationCount{0};
+}
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void *ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+    const int kWarmup = 2000;
+    const int kIterations = 20000;
+    // 판매 기록 묶음(1024건)이 찰 때의 할당만 허용한다
+    const double kMaxAllocationsPerCall = 0.01;
+
+    template <typename Fn>
+    double measure(const char *name, Fn fn) {
+        for (int i = 0; i < kWarmup; ++i) {
+            fn(i);
+        }
+        size_t allocationsBefore = allocationCount.load();
+        auto begin = chrono::steady_clock::now();
+        for (int i = 0; i < kIterations; ++i) {
+            fn(kWarmup + i);
+        }
+        auto elapsed = chrono::steady_clock::now() - begin;
+        size_t allocations = allocationCount.load() - allocationsBefore;
+
+        double nsPerCall = chrono::duration<double, nano>(elapsed).count() / kIterations;
+        double allocationsPerCall = (double)allocations / kIterations;
+        printf("%-22s %10.1f ns/call %8.3f allocs/call\n", name, nsPerCall, allocationsPerCall);
+        return allocationsPerCall;
+    }
+}
+
+int main() {
+    Item coke("01", "콜라 (제로 슈거 500ml 페트)", 1000);
+    Item tea("04", "홍차", 1500);
+    DVM dvm(1, Location(0, 0), {{coke, 1000000}, {tea, 1000000}}, {coke, tea}, {}, {});
+
+    SaleRequest request{"01", 1, coke};
+    double orderAllocations = measure("requestOrder", [&](int) { dvm.requestOrder(request); });
+
+    // 인증코드 문자열은 측정 밖에서 미리 만든다
+    vector<string> codes;
+    codes.reserve(kWarmup + kIterations);
+    for (int i = 0; i < kWarmup + kIterations; ++i) {
+        codes.push_back(CertificationRegistry::unpack((uint32_t)i));
+    }
+    const string teaCode = "04";
+    double prepaidAllocations = measure("saveSaleFromOther+recv", [&](int i) {
+        dvm.saveSaleFromOther(teaCode, 1, codes[i]);
+        dvm.processPrepaidItem(codes[i]);
+    });
+
+    return orderAllocations <= kMaxAllocationsPerCall && prepaidAllocations <= kMaxAllocationsPerCall ? 0 : 1;
+}
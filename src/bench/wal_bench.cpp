@@ -0,0 +1,60 @@
+// 선행 기록 로그 처리량 벤치마크
+// 로그 없이, 로그를 운영체제 캐시까지만 기록할 때, fdatasync까지 기다릴 때의
+// 초당 구매(requestOrder) 수를 스레드 수별로 비교한다. 동시 구매가 많을수록
+// group commit으로 여러 구매가 한 번의 fdatasync를 나눠 쓴다.
+#include "../app/application/dvm.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const int kPurchasesPerThread = 2000;
+
+    // walPath가 비어 있으면 로그 없이 측정한다
+    void measure(const char *name, const string &walPath, bool sync, int threads) {
+        Config::get().walPath = walPath;
+        Config::get().walSync = sync;
+        if (!walPath.empty()) {
+            remove(walPath.c_str());
+        }
+
+        Item coke("01", "콜라", 1000);
+        DVM dvm(1, Location(0, 0), {{coke, threads * kPurchasesPerThread}}, {coke}, {}, {});
+        SaleRequest request{"01", 1, coke};
+
+        auto begin = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&dvm, &request]() {
+                for (int i = 0; i < kPurchasesPerThread; ++i) {
+                    dvm.requestOrder(request);
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        auto elapsed = chrono::steady_clock::now() - begin;
+
+        double purchasesPerSecond = (double)threads * kPurchasesPerThread / chrono::duration<double>(elapsed).count();
+        printf("%-12s %2d threads %12.0f purchases/s\n", name, threads, purchasesPerSecond);
+    }
+}
+
+int main() {
+    string walPath = "/tmp/wal_bench_" + to_string(getpid()) + ".wal";
+    for (int threads : {1, 4, 16}) {
+        measure("memory", "", false, threads);
+        measure("wal-nosync", walPath, false, threads);
+        measure("wal-sync", walPath, true, threads);
+    }
+    remove(walPath.c_str());
+    Config::get().walPath.clear();
+    return 0;
+}
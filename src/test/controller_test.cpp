@@ -8,6 +8,8 @@
 #include <string>
 #include <map>
 #include <sstream>
+#include <thread>
+#include <atomic>
 
 using namespace std;
 using ::testing::Return;
@@ -49,6 +51,14 @@ public:
         return handlePrepaymentRequest(msg);
     }
     
+    string testDispatchRequest(const string &request) {
+        return dispatchRequest(request);
+    }
+
+    string testDispatchBinaryRequest(const string &payload) {
+        return dispatchBinaryRequest(payload);
+    }
+    
     using Controller::dvmId;
     using Controller::location;
 };
@@ -272,6 +282,18 @@ TEST_F(ControllerTest, HandlePrepaymentRequest_ShouldHandleNoStock) {
     EXPECT_NE(response.find("availability:F"), string::npos);
 }
 
+TEST_F(ControllerTest, HandlePrepaymentRequest_DuplicateCodeShouldReportReason) {
+    string request = "msg_type:req_prepay;item_code:001;item_num:1;cert_code:ABC12;src_id:2;";
+    string first = controller->testHandlePrepaymentRequest(request);
+    EXPECT_NE(first.find("availability:T"), string::npos);
+    EXPECT_EQ(first.find("reason:"), string::npos);
+
+    // 아직 수령되지 않은 같은 코드는 거절하고 요청한 DVM이 새 코드를 만들도록 알린다
+    string second = controller->testHandlePrepaymentRequest(request);
+    EXPECT_NE(second.find("availability:F"), string::npos);
+    EXPECT_NE(second.find("reason:duplicate_code;"), string::npos);
+}
+
 TEST_F(ControllerTest, HandlePrepaymentRequest_ShouldHandleInvalidFormat) {
     string request = "wrong_format";
     string response = controller->testHandlePrepaymentRequest(request);
@@ -286,6 +308,137 @@ TEST_F(ControllerTest, HandlePrepaymentRequest_ShouldHandleMissingFields) {
     EXPECT_NE(response.find("availability:F"), string::npos);
 }
 
+// DispatchRequest 테스트 케이스들
+
+TEST_F(ControllerTest, DispatchRequest_ShouldRouteStockRequest) {
+    string request = "msg_type:req_stock;item_code:001;item_num:2;src_id:2;";
+    string response = controller->testDispatchRequest(request);
+    EXPECT_NE(response.find("msg_type:resp_stock"), string::npos);
+}
+
+TEST_F(ControllerTest, DispatchRequest_ShouldRoutePrepaymentRequest) {
+    string request = "msg_type:req_prepay;item_code:003;item_num:1;cert_code:ABC12;src_id:2;";
+    string response = controller->testDispatchRequest(request);
+    EXPECT_NE(response.find("msg_type:resp_prepay"), string::npos);
+}
+
+TEST_F(ControllerTest, DispatchRequest_ShouldRejectUnknownRequest) {
+    string response = controller->testDispatchRequest("msg_type:req_unknown;");
+    EXPECT_EQ(response, "msg_type:error;detail:unknown_request;");
+}
+
+// 파이프라이닝 요청의 req_id를 응답에 그대로 돌려준다
+TEST_F(ControllerTest, DispatchRequest_ShouldEchoRequestId) {
+    string response = controller->testDispatchRequest("msg_type:req_stock;src_id:T2;req_id:42;item_code:001;item_num:1;");
+    EXPECT_NE(response.find("req_id:42;"), string::npos);
+    EXPECT_EQ(controller->testDispatchRequest("msg_type:req_stock;item_code:001;item_num:1;").find("req_id"), string::npos);
+}
+
+// 묶음 조회는 단일 조회로 잘못 전달되지 않고 아이템별로 응답한다
+TEST_F(ControllerTest, DispatchRequest_ShouldAnswerStockBatch) {
+    string response = controller->testDispatchRequest(
+        "msg_type:req_stock_batch;src_id:T2;dst_id:T1;items:001=2,003=1,999=1;");
+    EXPECT_NE(response.find("msg_type:resp_stock_batch;"), string::npos);
+    EXPECT_NE(response.find("dst_id:T2;"), string::npos);
+    EXPECT_NE(response.find("items:001=2,003=0,999=0;"), string::npos);
+    EXPECT_NE(response.find("coor_x:10;"), string::npos);
+}
+
+// 알 수 없는 DVM의 구독 요청은 거절한다
+TEST_F(ControllerTest, DispatchRequest_ShouldRejectSubscriptionFromUnknownDvm) {
+    string response = controller->testDispatchRequest(
+        "msg_type:req_subscribe;src_id:T2;dst_id:T1;items:001=3;lease_ms:1000;");
+    EXPECT_NE(response.find("detail:subscription_rejected"), string::npos);
+}
+
+// 재고 변화 알림은 보낸 DVM의 재고 구간으로 캐시에 기록된다
+TEST_F(ControllerTest, DispatchRequest_ShouldApplyStockChanged) {
+    string response = controller->testDispatchRequest(
+        "msg_type:stock_changed;src_id:T2;dst_id:T1;item_code:001;item_num:0;threshold:3;");
+    EXPECT_NE(response.find("msg_type:resp_stock_changed;"), string::npos);
+    EXPECT_NE(response.find("dst_id:T2;"), string::npos);
+    EXPECT_EQ(mockDvm->getStockCache().lookup(2, "001", 1), PeerStockCache::Lookup::Unavailable);
+
+    response = controller->testDispatchRequest("msg_type:stock_changed;src_id:T2;item_code:001;item_num:x;");
+    EXPECT_NE(response.find("detail:invalid_stock_changed"), string::npos);
+}
+
+// 가십 요청은 보낸 DVM의 재고를 반영하고 상대가 모르는 항목을 돌려준다
+TEST_F(ControllerTest, DispatchRequest_ShouldExchangeGossip) {
+    string response = controller->testDispatchRequest(
+        "msg_type:req_gossip;src_id:T2;dst_id:T1;digest:2=3;entries:2@3@001=4;");
+    EXPECT_NE(response.find("msg_type:resp_gossip;"), string::npos);
+    EXPECT_NE(response.find("entries:1@"), string::npos);
+    EXPECT_EQ(response.find("|2@"), string::npos);
+    EXPECT_EQ(mockDvm->getFleetInventory().lookup(2, "001", 4, 10000), PeerStockCache::Lookup::Available);
+}
+
+// 피어의 재고 조회와 선결제 요청은 로컬 재고만으로 답하고 다른 DVM에 다시 묻지 않는다
+TEST(ControllerPeerTest, PeerRequests_ShouldNotFanOutToOtherDvms) {
+    atomic<int> forwarded{0};
+    PeerServer peer(0, [&forwarded](const string &) {
+        forwarded++;
+        return string("msg_type:resp_stock;item_code:01;item_num:5;coor_x:0;coor_y:0;");
+    });
+    ASSERT_TRUE(peer.start());
+    thread peerThread([&peer]() { peer.run(); });
+
+    Item coke("01", "콜라", 1000);
+    list<OtherDVM> others{OtherDVM(3, Location(1, 1), "127.0.0.1", peer.getPort())};
+    DVM dvm(1, Location(10, 20), {{coke, 1}}, {coke}, {}, others);
+    TestableController controller(&dvm);
+
+    string stock = controller.testDispatchRequest("msg_type:req_stock;src_id:T2;dst_id:T1;item_code:01;item_num:3;");
+    EXPECT_NE(stock.find("item_num:0;"), string::npos);
+    string prepay = controller.testDispatchRequest(
+        "msg_type:req_prepay;src_id:T2;dst_id:T1;item_code:01;item_num:3;cert_code:ABCDE;");
+    EXPECT_NE(prepay.find("availability:F"), string::npos);
+    prepay = controller.testDispatchRequest(
+        "msg_type:req_prepay;src_id:T2;dst_id:T1;item_code:01;item_num:1;cert_code:ABCDE;");
+    EXPECT_NE(prepay.find("availability:T"), string::npos);
+    EXPECT_EQ(dvm.getStocks().at(coke), 0);
+    EXPECT_EQ(forwarded.load(), 0);
+
+    peer.stop();
+    peerThread.join();
+}
+
+// 숫자가 아닌 수량은 예외 없이 0으로 처리한다
+TEST_F(ControllerTest, HandleCheckStockRequest_NonNumericQuantity_ShouldNotThrow) {
+    string response;
+    EXPECT_NO_THROW(response = controller->testHandleCheckStockRequest("msg_type:req_stock;item_code:001;item_num:abc;src_id:T2;"));
+    EXPECT_NE(response.find("dst_id:T2"), string::npos);
+}
+
+// 바이너리 codec 요청은 같은 처리 로직을 거쳐 바이너리로 응답한다
+TEST_F(ControllerTest, DispatchBinaryRequest_ShouldAnswerStockQuery) {
+    BinaryMessage request;
+    request.type = BinaryMessage::Type::ReqStock;
+    request.srcId = 2;
+    request.itemCode = 1;
+    request.itemNum = 1;
+    uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+    size_t size = BinaryCodec::encode(request, buffer, sizeof(buffer));
+
+    string payload = controller->testDispatchBinaryRequest(string((const char *)buffer, size));
+    BinaryMessage response;
+    ASSERT_TRUE(BinaryCodec::decode((const uint8_t *)payload.data(), payload.size(), response));
+    EXPECT_EQ(response.type, BinaryMessage::Type::RespStock);
+    EXPECT_EQ(response.srcId, 1);
+    EXPECT_EQ(response.dstId, 2);
+    EXPECT_EQ(response.itemCode, 1);
+    EXPECT_EQ(response.itemNum, 0);
+    EXPECT_EQ(response.coorX, 10);
+    EXPECT_EQ(response.coorY, 20);
+}
+
+TEST_F(ControllerTest, DispatchBinaryRequest_MalformedPayload_ShouldReturnError) {
+    string payload = controller->testDispatchBinaryRequest("\x08");
+    BinaryMessage response;
+    ASSERT_TRUE(BinaryCodec::decode((const uint8_t *)payload.data(), payload.size(), response));
+    EXPECT_EQ(response.type, BinaryMessage::Type::Error);
+}
+
 // 경계값 테스트 케이스들
 
 TEST_F(ControllerTest, ParseStockResponse_ShouldHandleLongValues) {
@@ -324,3 +477,21 @@ int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
+
+TEST_F(ControllerTest, DispatchRequest_ShouldAnswerStatsWithoutRawSales) {
+    mockDvm->saveSaleFromOther("001", 2, "STAT1", 4);
+    mockDvm->saveSaleFromOther("002", 1, "STAT2", 4);
+
+    string response = controller->testDispatchRequest(
+        "msg_type:req_stats;src_id:T4;dst_id:T1;item_code:001;source:T4;");
+    EXPECT_EQ(MessageParser::find(response, "msg_type"), "resp_stats");
+    EXPECT_EQ(MessageParser::find(response, "dst_id"), "T4");
+    EXPECT_EQ(MessageParser::find(response, "sales"), "1");
+    EXPECT_EQ(MessageParser::find(response, "revenue"), "2000");
+    map<string, ItemSalesTotals> items = StatsField::parseItems(MessageParser::find(response, "items"));
+    ASSERT_EQ(items.size(), 1u);
+    EXPECT_EQ(items["001"].units, 2);
+    map<int, SourceSalesTotals> sources = StatsField::parseSources(MessageParser::find(response, "sources"));
+    EXPECT_EQ(sources[4].prepaid, 1);
+    EXPECT_EQ(StatsField::parseHours(MessageParser::find(response, "hours")).size(), 1u);
+}
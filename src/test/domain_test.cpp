@@ -4,8 +4,11 @@
 #include <climits>
 #include <vector>
 #include <string>
+#include <set>
+#include <thread>
 #include "../app/external/card.h"
 #include "../app/domain/certificationcode.h"
+#include "../app/domain/certcodegenerator.h"
 #include "../app/domain/item.h"
 #include "../app/domain/location.h"
 #include "../app/domain/prepayment.h"
@@ -172,6 +175,40 @@ TEST(CertificationCodeTest, MultipleRandomCodeGeneration) {
     }
 }
 
+// 여러 스레드에서 만든 코드도 알파벳 안의 5자리이고 서로 거의 겹치지 않아야 함
+TEST(CertificationCodeTest, GeneratorAcrossThreads) {
+    const int THREADS = 4;
+    const int PER_THREAD = 5000;
+    std::vector<std::vector<std::string>> results(THREADS);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; t++) {
+        workers.emplace_back([&results, t]() {
+            for (int i = 0; i < PER_THREAD; i++) {
+                char code[CertCodeGenerator::kLength];
+                CertCodeGenerator::generate(code);
+                results[t].emplace_back(code, CertCodeGenerator::kLength);
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    std::set<std::string> unique;
+    for (const auto &codes : results) {
+        for (const auto &code : codes) {
+            ASSERT_EQ(code.length(), CertCodeGenerator::kLength);
+            for (char c : code) {
+                EXPECT_TRUE(isalnum(static_cast<unsigned char>(c)));
+            }
+            unique.insert(code);
+        }
+    }
+    // 62^5 공간에서 2만 개를 뽑을 때 기대 충돌 수는 0.2개 미만이다
+    // 스레드끼리 같은 시드를 썼다면 수천 개가 겹친다
+    EXPECT_GE(unique.size(), static_cast<size_t>(THREADS * PER_THREAD - 3));
+}
+
 TEST(CertificationCodeTest, CodeVerification) {
     CertificationCode code("abc12");
     
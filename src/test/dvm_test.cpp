@@ -1,14 +1,22 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include "../app/application/dvm.h"
+#include "../app/application/salesanalytics.h"
 #include "../app/domain/item.h"
 #include "../app/domain/location.h"
 #include "../app/dto.h"
 #include "../app/exception/dvmexception.h"
 #include <list>
 #include <map>
+#include <set>
+#include <algorithm>
 #include <string>
 #include <stdexcept> // std::runtime_error
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include "../app/network/peerserver.h"
 
 using namespace std;
 using ::testing::_;
@@ -545,6 +553,978 @@ TEST_F(DVMTest, Scenario_MultipleCertCodes) {
     EXPECT_FALSE(dvm1->processPrepaidItem("WRONG_CERT"));
 }
 
+// 여러 아이템을 로컬 재고만으로 한 번에 확인한다
+TEST_F(DVMTest, CheckLocalStocks_ShouldAnswerEachItemFromLocalStock) {
+    vector<CheckStockRequest> answer = dvm1->checkLocalStocks({
+        {"001", 3}, {"003", 1}, {"002", 6}, {"999", 1}, {"005", 20}});
+
+    ASSERT_EQ(answer.size(), 5u);
+    EXPECT_EQ(answer[0].item_code, "001");
+    EXPECT_EQ(answer[0].item_num, 3);
+    EXPECT_EQ(answer[1].item_num, 0);  // 재고 없음
+    EXPECT_EQ(answer[2].item_num, 0);  // 재고 부족
+    EXPECT_EQ(answer[3].item_num, 0);  // 없는 아이템
+    EXPECT_EQ(answer[4].item_num, 20); // 재고 전부
+}
+
+// ===== 병렬 재고 조회 테스트 =====
+
+// 지정한 재고 수량으로 응답하는 가짜 피어 DVM 서버들을 띄우는 fixture
+class DVMFanOutTest : public ::testing::Test {
+protected:
+    struct FakePeer {
+        unique_ptr<PeerServer> server;
+        thread serverThread;
+        atomic<int> stockQueries{0};
+        // 받은 stock_changed 알림
+        mutex noticeMutex;
+        condition_variable noticeCondition;
+        vector<SocketMessage> notices;
+    };
+    vector<unique_ptr<FakePeer>> peers;
+    int savedDeadlineMs = 0;
+    int savedCacheTtlMs = 0;
+    int savedLeaseMs = 0;
+    int savedThreshold = 0;
+    int savedGossipFanout = 0;
+
+    void SetUp() override {
+        savedDeadlineMs = Config::get().peerQueryDeadlineMs;
+        savedCacheTtlMs = Config::get().peerStockCacheTtlMs;
+        savedLeaseMs = Config::get().peerSubscriptionLeaseMs;
+        savedThreshold = Config::get().peerSubscriptionThreshold;
+        savedGossipFanout = Config::get().gossipFanout;
+    }
+
+    void TearDown() override {
+        Config::get().peerQueryDeadlineMs = savedDeadlineMs;
+        Config::get().peerStockCacheTtlMs = savedCacheTtlMs;
+        Config::get().peerSubscriptionLeaseMs = savedLeaseMs;
+        Config::get().peerSubscriptionThreshold = savedThreshold;
+        Config::get().gossipFanout = savedGossipFanout;
+        for (auto &peer : peers) {
+            peer->server->stop();
+            peer->serverThread.join();
+        }
+    }
+
+    // 재고 itemNum으로 응답하는 피어 서버를 띄우고 포트를 반환
+    int startPeer(int itemNum, int delayMs = 0) {
+        auto peer = make_unique<FakePeer>();
+        FakePeer *self = peer.get();
+        peer->server = make_unique<PeerServer>(0, [itemNum, delayMs, self](const string &raw) {
+            if (delayMs > 0) {
+                this_thread::sleep_for(chrono::milliseconds(delayMs));
+            }
+            SocketMessage req = SocketMessage::deserialize(raw);
+            if (req.msg_type == "req_prepay") {
+                return "msg_type:resp_prepay;item_code:" + req.msg_content["item_code"] +
+                       ";item_num:" + req.msg_content["item_num"] + ";availability:T;";
+            }
+            if (req.msg_type == "req_subscribe") {
+                vector<CheckStockRequest> items = StockBatchField::parse(req.msg_content["items"]);
+                for (auto &item : items) {
+                    item.item_num = itemNum;
+                }
+                return "msg_type:resp_subscribe;items:" + StockBatchField::format(items) + ";";
+            }
+            if (req.msg_type == "stock_changed") {
+                {
+                    lock_guard<mutex> lock(self->noticeMutex);
+                    self->notices.push_back(req);
+                }
+                self->noticeCondition.notify_all();
+                return string("msg_type:resp_stock_changed;");
+            }
+            if (req.msg_type == "req_stock") {
+                self->stockQueries++;
+            }
+            SocketMessage resp;
+            resp.msg_type = "resp_stock";
+            resp.src_id = "T9";
+            resp.dst_id = req.src_id;
+            resp.msg_content["item_code"] = req.msg_content["item_code"];
+            resp.msg_content["item_num"] = to_string(itemNum);
+            resp.msg_content["coor_x"] = "0";
+            resp.msg_content["coor_y"] = "0";
+            return resp.serialize();
+        });
+        EXPECT_TRUE(peer->server->start());
+        int port = peer->server->getPort();
+        peer->serverThread = thread([server = peer->server.get()]() { server->run(); });
+        peers.push_back(move(peer));
+        return port;
+    }
+
+    // 피어가 알림을 count개 받을 때까지 기다린 뒤 받은 알림을 반환
+    vector<SocketMessage> waitForNotices(FakePeer &peer, size_t count) {
+        unique_lock<mutex> lock(peer.noticeMutex);
+        peer.noticeCondition.wait_for(lock, chrono::seconds(3), [&] { return peer.notices.size() >= count; });
+        return peer.notices;
+    }
+};
+
+TEST_F(DVMFanOutTest, QueryStocks_ShouldPickNearestPeerWithStock) {
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(50, 50), "127.0.0.1", startPeer(5)));
+    others.push_back(OtherDVM(3, Location(5, 5), "127.0.0.1", startPeer(5)));
+    others.push_back(OtherDVM(4, Location(1, 1), "127.0.0.1", startPeer(0)));
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    string result = dvm.queryStocks("04", 1);
+    EXPECT_NE(result.find("flag:other"), string::npos);
+    EXPECT_NE(result.find("target: 3"), string::npos);
+}
+
+TEST_F(DVMFanOutTest, QueryStocks_SlowNearestPeerShouldNotExceedDeadline) {
+    Config::get().peerQueryDeadlineMs = 300;
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(1, 1), "127.0.0.1", startPeer(5, 1500)));
+    others.push_back(OtherDVM(3, Location(40, 40), "127.0.0.1", startPeer(5)));
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    auto begin = chrono::steady_clock::now();
+    string result = dvm.queryStocks("04", 1);
+    auto elapsed = chrono::steady_clock::now() - begin;
+
+    // 마감 시간 안에 응답한 DVM 중 가장 가까운 DVM이 선택된다
+    EXPECT_NE(result.find("target: 3"), string::npos);
+    EXPECT_LT(elapsed, chrono::milliseconds(1000));
+}
+
+TEST_F(DVMFanOutTest, QueryStocks_SlowPeersShouldBeQueriedInParallel) {
+    Config::get().peerQueryDeadlineMs = 2000;
+    list<OtherDVM> others;
+    for (int i = 0; i < 5; ++i) {
+        others.push_back(OtherDVM(2 + i, Location(10 + i, 10), "127.0.0.1", startPeer(0, 300)));
+    }
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    auto begin = chrono::steady_clock::now();
+    string result = dvm.queryStocks("04", 1);
+    auto elapsed = chrono::steady_clock::now() - begin;
+
+    // 순차 조회였다면 1.5초 이상 걸린다
+    EXPECT_NE(result.find("flag:not_available"), string::npos);
+    EXPECT_LT(elapsed, chrono::milliseconds(1200));
+}
+
+TEST_F(DVMFanOutTest, QueryStocks_FramedPeersShouldBeQueriedInParallel) {
+    bool savedFraming = Config::get().peerFraming;
+    Config::get().peerFraming = true;
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(30, 30), "127.0.0.1", startPeer(5)));
+    others.push_back(OtherDVM(3, Location(3, 3), "127.0.0.1", startPeer(5)));
+    Config::get().peerFraming = savedFraming;
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    EXPECT_NE(dvm.queryStocks("04", 1).find("target: 3"), string::npos);
+    // 응답을 모두 받은 연결은 풀로 돌아가 다음 조회에서 재사용된다
+    EXPECT_NE(dvm.queryStocks("04", 1).find("target: 3"), string::npos);
+    EXPECT_EQ(peers[1]->server->getConnectionCount(), 1u);
+}
+
+// ===== 피어 재고 캐시 테스트 =====
+
+TEST(PeerStockCacheTest, Lookup_ShouldUseKnownAvailableAndUnavailableBounds) {
+    PeerStockCache cache(10000);
+    EXPECT_EQ(cache.lookup(2, "01", 3), PeerStockCache::Lookup::Miss);
+
+    cache.record(2, "01", 3, true);   // 3개 이상 있음
+    cache.record(2, "01", 8, false);  // 8개 미만
+    EXPECT_EQ(cache.lookup(2, "01", 1), PeerStockCache::Lookup::Available);
+    EXPECT_EQ(cache.lookup(2, "01", 3), PeerStockCache::Lookup::Available);
+    EXPECT_EQ(cache.lookup(2, "01", 5), PeerStockCache::Lookup::Miss);
+    EXPECT_EQ(cache.lookup(2, "01", 9), PeerStockCache::Lookup::Unavailable);
+    EXPECT_EQ(cache.lookup(3, "01", 1), PeerStockCache::Lookup::Miss);
+    EXPECT_EQ(cache.getHitCount(), 3u);
+    EXPECT_EQ(cache.getMissCount(), 3u);
+}
+
+TEST(PeerStockCacheTest, Record_NewerAnswerShouldReplaceContradictingBound) {
+    PeerStockCache cache(10000);
+    cache.record(2, "01", 2, false);
+    cache.record(2, "01", 4, true); // 그 사이 채워짐
+    EXPECT_EQ(cache.lookup(2, "01", 2), PeerStockCache::Lookup::Available);
+}
+
+TEST(PeerStockCacheTest, Entries_ShouldExpireAndBeInvalidated) {
+    PeerStockCache cache(50);
+    cache.record(2, "01", 1, true);
+    cache.record(2, "02", 1, true);
+    cache.invalidate(2, "02");
+    EXPECT_EQ(cache.lookup(2, "02", 1), PeerStockCache::Lookup::Miss);
+    EXPECT_EQ(cache.lookup(2, "01", 1), PeerStockCache::Lookup::Available);
+
+    this_thread::sleep_for(chrono::milliseconds(80));
+    EXPECT_EQ(cache.lookup(2, "01", 1), PeerStockCache::Lookup::Miss);
+
+    PeerStockCache disabled(0);
+    disabled.record(2, "01", 1, true);
+    EXPECT_EQ(disabled.lookup(2, "01", 1), PeerStockCache::Lookup::Miss);
+}
+
+TEST_F(DVMFanOutTest, QueryStocks_RepeatedQueryShouldBeAnsweredFromCache) {
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(5, 5), "127.0.0.1", startPeer(0)));
+    others.push_back(OtherDVM(3, Location(9, 9), "127.0.0.1", startPeer(4)));
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_NE(dvm.queryStocks("04", 2).find("target: 3"), string::npos);
+    }
+    EXPECT_EQ(peers[0]->stockQueries.load(), 1);
+    EXPECT_EQ(peers[1]->stockQueries.load(), 1);
+    EXPECT_EQ(dvm.getStockCache().getHitCount(), 8u);
+    EXPECT_EQ(dvm.getStockCache().getMissCount(), 2u);
+}
+
+TEST_F(DVMFanOutTest, RequestOrder_SuccessfulPrepayShouldInvalidateCache) {
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(5, 5), "127.0.0.1", startPeer(4)));
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    dvm.queryStocks("04", 1);
+    dvm.requestOrder(2, SaleRequest{"04", 1, Item("04", "홍차", 1000)});
+    dvm.queryStocks("04", 1);
+    EXPECT_EQ(peers[0]->stockQueries.load(), 2);
+}
+
+TEST_F(DVMFanOutTest, RequestOrder_DuplicateCodeShouldRetryWithNewCode) {
+    // 첫 요청만 인증코드 중복으로 거절하는 피어
+    vector<string> codes;
+    mutex codesMutex;
+    PeerServer peer(0, [&](const string &raw) {
+        SocketMessage req = SocketMessage::deserialize(raw);
+        lock_guard<mutex> lock(codesMutex);
+        codes.push_back(req.msg_content["cert_code"]);
+        string answer = codes.size() == 1 ? "availability:F;reason:duplicate_code;" : "availability:T;";
+        return "msg_type:resp_prepay;item_code:" + req.msg_content["item_code"] +
+               ";item_num:" + req.msg_content["item_num"] + ";" + answer;
+    });
+    ASSERT_TRUE(peer.start());
+    thread peerThread([&peer]() { peer.run(); });
+
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(5, 5), "127.0.0.1", peer.getPort()));
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+    auto [location, certCode] = dvm.requestOrder(2, SaleRequest{"04", 1, Item("04", "홍차", 1000)});
+
+    peer.stop();
+    peerThread.join();
+    ASSERT_EQ(codes.size(), 2u);
+    EXPECT_NE(codes[0], codes[1]);
+    EXPECT_EQ(certCode, codes[1]);
+}
+
+TEST_F(DVMFanOutTest, QueryStocks_ZeroTtlShouldAlwaysQueryPeers) {
+    Config::get().peerStockCacheTtlMs = 0;
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(5, 5), "127.0.0.1", startPeer(4)));
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    dvm.queryStocks("04", 1);
+    dvm.queryStocks("04", 1);
+    EXPECT_EQ(peers[0]->stockQueries.load(), 2);
+}
+
+// ===== 재고 변화 구독 테스트 =====
+
+TEST(SubscriptionRegistryTest, CollectChanges_ShouldNotifyOnlyWhenBandChanges) {
+    SubscriptionRegistry registry;
+    registry.subscribe(2, "01", 3, 10000);
+    registry.subscribe(3, "01", 1, 10000);
+    EXPECT_EQ(registry.size(), 2u);
+
+    EXPECT_TRUE(registry.collectChanges("01", 10, 5).empty());   // 둘 다 threshold 이상 유지
+    auto crossed = registry.collectChanges("01", 3, 2);           // 2번만 threshold 아래로
+    ASSERT_EQ(crossed.size(), 1u);
+    EXPECT_EQ(crossed[0].subscriberId, 2);
+    EXPECT_EQ(crossed[0].itemNum, 2);
+    EXPECT_EQ(crossed[0].threshold, 3);
+    EXPECT_EQ(registry.collectChanges("01", 1, 0).size(), 2u);    // 품절은 모두에게
+    EXPECT_TRUE(registry.collectChanges("02", 1, 0).empty());
+
+    registry.unsubscribe(2);
+    EXPECT_EQ(registry.collectChanges("01", 0, 4).size(), 1u);
+    EXPECT_TRUE(registry.hasSubscribers("01"));
+    registry.unsubscribe(3);
+    EXPECT_FALSE(registry.hasSubscribers("01"));
+}
+
+TEST(SubscriptionRegistryTest, ExpiredSubscriptions_ShouldBeDropped) {
+    SubscriptionRegistry registry;
+    registry.subscribe(2, "01", 1, 30);
+    this_thread::sleep_for(chrono::milliseconds(60));
+    EXPECT_TRUE(registry.collectChanges("01", 1, 0).empty());
+    EXPECT_EQ(registry.size(), 0u);
+    EXPECT_FALSE(registry.hasSubscribers("01"));
+}
+
+TEST(PeerStockCacheTest, RecordBand_ShouldAnswerWithinBandAndOutliveTtl) {
+    PeerStockCache cache(30);
+    cache.recordBand(2, "01", 2, 5, 10000); // 1개 이상 5개 미만
+    EXPECT_EQ(cache.lookup(2, "01", 1), PeerStockCache::Lookup::Available);
+    EXPECT_EQ(cache.lookup(2, "01", 3), PeerStockCache::Lookup::Miss);
+    EXPECT_EQ(cache.lookup(2, "01", 5), PeerStockCache::Lookup::Unavailable);
+
+    // 조회 결과는 TTL 동안만 구간을 좁히고, 만료되면 구간으로 답한다
+    cache.record(2, "01", 3, true);
+    cache.record(2, "01", 4, false);
+    EXPECT_EQ(cache.lookup(2, "01", 3), PeerStockCache::Lookup::Available);
+    EXPECT_EQ(cache.lookup(2, "01", 4), PeerStockCache::Lookup::Unavailable);
+    this_thread::sleep_for(chrono::milliseconds(60));
+    EXPECT_EQ(cache.lookup(2, "01", 3), PeerStockCache::Lookup::Miss);
+    EXPECT_EQ(cache.lookup(2, "01", 4), PeerStockCache::Lookup::Miss);
+    EXPECT_EQ(cache.lookup(2, "01", 1), PeerStockCache::Lookup::Available);
+    EXPECT_EQ(cache.lookup(2, "01", 5), PeerStockCache::Lookup::Unavailable);
+
+    cache.recordBand(2, "01", 0, 5, 10000);
+    EXPECT_EQ(cache.lookup(2, "01", 1), PeerStockCache::Lookup::Unavailable);
+    cache.recordBand(2, "01", 9, 5, 10000);
+    EXPECT_EQ(cache.lookup(2, "01", 5), PeerStockCache::Lookup::Available);
+    EXPECT_EQ(cache.lookup(2, "01", 6), PeerStockCache::Lookup::Miss);
+}
+
+TEST_F(DVMFanOutTest, Subscription_SaleAndRestockShouldPushOnlyBandChanges) {
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(5, 5), "127.0.0.1", startPeer(0)));
+    Item tea("04", "홍차", 1000);
+    DVM dvm(1, Location(0, 0), {{tea, 4}}, {tea}, {}, others);
+
+    EXPECT_TRUE(dvm.acceptSubscription(7, {{"04", 3}}, 10000).empty()); // 모르는 DVM
+    auto current = dvm.acceptSubscription(2, {{"04", 3}}, 10000);
+    ASSERT_EQ(current.size(), 1u);
+    EXPECT_EQ(current[0].item_num, 4);
+
+    dvm.requestOrder(SaleRequest{"04", 1, tea}); // 4 -> 3: 구간 유지
+    dvm.requestOrder(SaleRequest{"04", 1, tea}); // 3 -> 2: threshold 아래로
+    dvm.requestOrder(SaleRequest{"04", 2, tea}); // 2 -> 0: 품절
+    dvm.restock("04", 6);                        // 0 -> 6
+
+    vector<SocketMessage> notices = waitForNotices(*peers[0], 3);
+    ASSERT_EQ(notices.size(), 3u);
+    EXPECT_EQ(notices[0].src_id, "T1");
+    EXPECT_EQ(notices[0].msg_content["item_code"], "04");
+    EXPECT_EQ(notices[0].msg_content["item_num"], "2");
+    EXPECT_EQ(notices[0].msg_content["threshold"], "3");
+    EXPECT_EQ(notices[1].msg_content["item_num"], "0");
+    EXPECT_EQ(notices[2].msg_content["item_num"], "6");
+}
+
+TEST_F(DVMFanOutTest, Subscription_QueryStocksShouldRunFromPushedState) {
+    Config::get().peerSubscriptionThreshold = 3;
+    Config::get().peerStockCacheTtlMs = 0;
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(5, 5), "127.0.0.1", startPeer(4)));
+    DVM dvm(1, Location(0, 0), {}, {}, {}, others);
+
+    EXPECT_EQ(dvm.subscribeToPeers(), 1);
+    EXPECT_NE(dvm.queryStocks("04", 3).find("target: 2"), string::npos);
+    EXPECT_NE(dvm.queryStocks("10", 1).find("target: 2"), string::npos);
+
+    dvm.applyStockChange(2, "04", 0, 3);
+    EXPECT_NE(dvm.queryStocks("04", 1).find("flag:not_available"), string::npos);
+    EXPECT_EQ(peers[0]->stockQueries.load(), 0);
+}
+
+// ===== 가십 재고 표 테스트 =====
+
+TEST(GossipFieldTest, DigestAndEntries_ShouldRoundTripAndSkipMalformed) {
+    map<int, uint64_t> digest{{1, 17}, {2, 1700000000123ULL}};
+    EXPECT_EQ(GossipField::parseDigest(GossipField::formatDigest(digest)), digest);
+    EXPECT_EQ(GossipField::parseDigest("1=5,x=3,4=,5=9").size(), 2u);
+
+    vector<InventoryEntry> entries{{2, 9, {{"01", 3}, {"02", 0}}}, {3, 4, {}}};
+    string field = GossipField::formatEntries(entries);
+    EXPECT_EQ(field, "2@9@01=3,02=0|3@4@");
+    vector<InventoryEntry> parsed = GossipField::parseEntries(field + "|bad|7@x@01=1");
+    ASSERT_EQ(parsed.size(), 2u);
+    EXPECT_EQ(parsed[0].dvm_id, 2);
+    EXPECT_EQ(parsed[0].version, 9u);
+    ASSERT_EQ(parsed[0].stocks.size(), 2u);
+    EXPECT_EQ(parsed[0].stocks[0].item_num, 3);
+    EXPECT_TRUE(parsed[1].stocks.empty());
+}
+
+TEST(FleetInventoryTest, Merge_ShouldKeepNewestVersionAndIgnoreSelf) {
+    FleetInventory fleet(1);
+    fleet.setLocalStock("01", 4);
+    EXPECT_EQ(fleet.merge({{2, 5, {{"01", 3}}}, {1, UINT64_MAX, {}}}), 1u);
+    EXPECT_EQ(fleet.merge({{2, 4, {{"01", 9}}}}), 0u); // 오래된 항목
+    EXPECT_EQ(fleet.lookup(2, "01", 3, 10000), PeerStockCache::Lookup::Available);
+    EXPECT_EQ(fleet.lookup(2, "01", 4, 10000), PeerStockCache::Lookup::Unavailable);
+    EXPECT_EQ(fleet.lookup(2, "02", 1, 10000), PeerStockCache::Lookup::Unavailable);
+    EXPECT_EQ(fleet.lookup(3, "01", 1, 10000), PeerStockCache::Lookup::Miss);
+    EXPECT_EQ(fleet.lookup(1, "01", 1, 10000), PeerStockCache::Lookup::Miss); // 자기 자신
+    EXPECT_EQ(fleet.localEntry().stocks[0].item_num, 4);
+
+    this_thread::sleep_for(chrono::milliseconds(30));
+    EXPECT_EQ(fleet.lookup(2, "01", 1, 10), PeerStockCache::Lookup::Miss); // 오래된 정보
+}
+
+TEST(FleetInventoryTest, NewerThan_ShouldReturnOnlyUnknownEntriesWithSelfFirst) {
+    FleetInventory fleet(1);
+    fleet.setLocalStock("01", 4);
+    fleet.merge({{2, 5, {}}, {3, 7, {}}, {4, 2, {}}});
+    uint64_t selfVersion = fleet.digest()[1];
+
+    auto newer = fleet.newerThan({{3, 7}, {4, 1}}, 2, 10);
+    ASSERT_EQ(newer.size(), 2u);
+    EXPECT_EQ(newer[0].dvm_id, 1);
+    EXPECT_EQ(newer[1].dvm_id, 4); // 2는 요청자, 3은 이미 알고 있음
+
+    EXPECT_EQ(fleet.newerThan({}, 9, 1).size(), 1u);
+    EXPECT_TRUE(fleet.newerThan({{1, selfVersion}, {2, 5}, {3, 7}, {4, 2}}, 9, 10).empty());
+}
+
+TEST(FleetInventoryTest, RefreshLocal_ShouldRebuildOwnEntryOnlyAfterChanges) {
+    FleetInventory fleet(1);
+    int collected = 0;
+    auto collect = [&collected](map<string, int>& stocks) {
+        ++collected;
+        stocks["01"] = 7;
+    };
+    fleet.refreshLocal(collect);
+    EXPECT_EQ(collected, 0);
+
+    fleet.markLocalChanged();
+    fleet.markLocalChanged();
+    fleet.refreshLocal(collect);
+    uint64_t version = fleet.digest()[1];
+    fleet.refreshLocal(collect);
+    EXPECT_EQ(collected, 1);
+    EXPECT_EQ(fleet.digest()[1], version);
+    ASSERT_EQ(fleet.localEntry().stocks.size(), 1u);
+    EXPECT_EQ(fleet.localEntry().stocks[0].item_num, 7);
+}
+
+TEST(FleetInventoryTest, NewerThan_ShouldConvergeWhenFrequentUpdatesExceedTheLimit) {
+    // 40개 DVM의 재고를 아는 DVM에게서 한 DVM이 계속 가십을 받는다.
+    // 그동안 앞쪽 30개 DVM의 재고는 매 주기 바뀌어 항상 개수 제한(24)보다 많은 항목이 새롭다.
+    const int peers = 40;
+    const size_t maxEntries = 24;
+    FleetInventory hub(100);
+    FleetInventory requester(200);
+    uint64_t version = 1;
+    vector<InventoryEntry> initial;
+    for (int id = 1; id <= peers; ++id) {
+        initial.push_back({id, version, {{"01", id}}});
+    }
+    hub.merge(initial);
+
+    int rounds = 0;
+    while (requester.size() < (size_t)peers + 1 && rounds < 10) {
+        ++version;
+        vector<InventoryEntry> updates;
+        for (int id = 1; id <= 30; ++id) {
+            updates.push_back({id, version, {{"01", id}}});
+        }
+        hub.merge(updates);
+        requester.merge(hub.newerThan(requester.digest(), 200, maxEntries));
+        ++rounds;
+    }
+    // 자기 자신 외에 모든 DVM을 알게 된다
+    EXPECT_EQ(requester.size(), (size_t)peers + 1);
+    EXPECT_LE(rounds, 3);
+    EXPECT_EQ(requester.lookup(peers, "01", peers, 10000), PeerStockCache::Lookup::Available);
+}
+
+TEST_F(DVMFanOutTest, GossipRound_ShouldSpreadInventoryAndAnswerQueriesLocally) {
+    Config::get().gossipFanout = 2;
+    Item tea("04", "홍차", 1000);
+    DVM remote(2, Location(5, 5), {{tea, 6}}, {tea}, {}, {});
+    // 3번 DVM의 재고는 2번을 거쳐 전달된다
+    remote.acceptGossip(3, {}, {{3, 11, {{"04", 9}}}});
+
+    atomic<int> otherRequests{0};
+    PeerServer server(0, [&remote, &otherRequests](const string &raw) {
+        SocketMessage req = SocketMessage::deserialize(raw);
+        if (req.msg_type != "req_gossip") {
+            otherRequests++;
+            return string("msg_type:error;");
+        }
+        vector<InventoryEntry> newer = remote.acceptGossip(
+            2, GossipField::parseDigest(req.msg_content["digest"]), GossipField::parseEntries(req.msg_content["entries"]));
+        return "msg_type:resp_gossip;entries:" + GossipField::formatEntries(newer) + ";" +
+               string(SocketMessage::kEndField);
+    });
+    ASSERT_TRUE(server.start());
+    thread serverThread([&server]() { server.run(); });
+
+    list<OtherDVM> others;
+    others.push_back(OtherDVM(2, Location(5, 5), "127.0.0.1", server.getPort()));
+    others.push_back(OtherDVM(3, Location(9, 9), "127.0.0.1", startPeer(0)));
+    Item coke("01", "콜라", 1000);
+    DVM dvm(1, Location(0, 0), {{coke, 2}}, {coke}, {}, others);
+
+    // 3번은 가십에 응답하지 않는 기존 피어
+    EXPECT_EQ(dvm.gossipRound(), 1);
+    EXPECT_EQ(dvm.getFleetInventory().size(), 3u);
+    EXPECT_EQ(remote.getFleetInventory().lookup(1, "01", 2, 10000), PeerStockCache::Lookup::Available);
+
+    EXPECT_NE(dvm.queryStocks("04", 6).find("target: 2"), string::npos);
+    EXPECT_NE(dvm.queryStocks("04", 8).find("target: 3"), string::npos);
+    EXPECT_NE(dvm.queryStocks("04", 10).find("flag:not_available"), string::npos);
+    EXPECT_EQ(otherRequests.load(), 0);
+    EXPECT_EQ(peers[0]->stockQueries.load(), 0);
+
+    server.stop();
+    serverThread.join();
+}
+
+// ===== 동시 사용 테스트 =====
+
+TEST(DVMLocalStockTest, EvaluateLocalStock_ShouldReturnTypedCountsWithoutPeers) {
+    Item coke("01", "콜라", 1000);
+    list<OtherDVM> others{OtherDVM(2, Location(1, 1), "127.0.0.1", 1)}; // 연결할 수 없는 피어
+    DVM dvm(1, Location(0, 0), {{coke, 4}}, {coke}, {}, others);
+
+    LocalStockEvaluation enough = dvm.evaluateLocalStock("01", 4);
+    EXPECT_EQ(enough.on_hand, 4);
+    EXPECT_EQ(enough.requested, 4);
+    EXPECT_TRUE(enough.sufficient);
+    EXPECT_FALSE(dvm.evaluateLocalStock("01", 5).sufficient);
+    LocalStockEvaluation unknown = dvm.evaluateLocalStock("07", 1);
+    EXPECT_EQ(unknown.on_hand, 0);
+    EXPECT_FALSE(unknown.sufficient);
+}
+
+TEST(StockTableTest, Find_ShouldIndexTwoDigitCodesAndKeepOtherCodesApart) {
+    Item coke("01", "콜라", 1000);
+    Item longCode("001", "Coke", 1000);
+    Item water("09", "물", 500);
+    StockTable table({{coke, 3}, {longCode, 7}, {water, 0}});
+
+    int cokeSlot = table.find("01");
+    int longSlot = table.find("001");
+    EXPECT_EQ(cokeSlot, 1);
+    EXPECT_GE(longSlot, StockTable::kDenseSlots);
+    EXPECT_EQ(table.load(cokeSlot), 3);
+    EXPECT_EQ(table.load(longSlot), 7);
+    EXPECT_EQ(table.item(longSlot)->getName(), "Coke");
+    EXPECT_EQ(table.find("02"), -1);
+    EXPECT_EQ(table.find("1"), -1);
+    EXPECT_EQ(table.find("0001"), -1);
+    EXPECT_EQ(table.item(-1), nullptr);
+
+    vector<string> codes;
+    table.forEach([&codes](const Item &item, int) { codes.push_back(item.getItemCode()); });
+    EXPECT_EQ(codes, (vector<string>{"001", "01", "09"}));
+}
+
+TEST(StockTableTest, TryTake_ShouldRefuseWhenInsufficientAndPublishOnlyChanges) {
+    Item coke("01", "콜라", 1000);
+    StockTable table({{coke, 3}});
+    int slot = table.find("01");
+    vector<pair<int, int>> changes;
+    auto record = [&](int before, int after) { changes.emplace_back(before, after); };
+
+    EXPECT_TRUE(table.tryTake(slot, 2));
+    EXPECT_FALSE(table.tryTake(slot, 2));
+    table.publish(slot, record);
+    table.publish(slot, record); // 바뀐 것이 없으면 알리지 않는다
+    table.add(slot, 4);
+    table.publish(slot, record);
+    EXPECT_EQ(table.load(slot), 5);
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0], make_pair(3, 1));
+    EXPECT_EQ(changes[1], make_pair(1, 5));
+}
+
+TEST(StockTableTest, ConcurrentTakes_ShouldNeverGoBelowZero) {
+    Item coke("01", "콜라", 1000);
+    StockTable table({{coke, 1000}});
+    int slot = table.find("01");
+    atomic<int> taken{0};
+    vector<thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 200; ++i) {
+                if (table.tryTake(slot, 1)) {
+                    taken++;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(taken.load(), 1000);
+    EXPECT_EQ(table.load(slot), 0);
+}
+
+TEST(SalesLedgerTest, ConcurrentAppends_ShouldAllBeKept) {
+    SalesLedger ledger(4);
+    Item coke("01", "콜라", 1000);
+    vector<thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&ledger, &coke]() {
+            for (int i = 0; i < 50; ++i) {
+                ledger.append(Sale::createStandaloneSale(SaleRequest{"01", 1, coke}));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(ledger.size(), 400u);
+    EXPECT_FALSE(ledger.receivePrepaidItem("ABCDE"));
+}
+
+TEST(SalesLedgerTest, ReceivePrepaidItem_ShouldUseCodeIndexAndForgetUsedCodes) {
+    SalesLedger ledger;
+    Item coke("01", "콜라", 1000);
+    for (int i = 0; i < 10000; ++i) {
+        ledger.append(Sale::createStandaloneSale(SaleRequest{"01", 1, coke}));
+    }
+    ledger.append(Sale::createSaleUsingCertCode(SaleRequest{"01", 1, coke}, "AAAAA"));
+    ledger.append(Sale::createSaleUsingCertCode(SaleRequest{"01", 1, coke}, "BBBBB"));
+    ledger.append(Sale::createSaleUsingCertCode(SaleRequest{"01", 2, coke}, "BBBBB")); // 중복 코드
+    EXPECT_EQ(ledger.size(), 10003u);
+    EXPECT_EQ(ledger.getPendingPrepaidCount(), 3u);
+
+    EXPECT_TRUE(ledger.receivePrepaidItem("AAAAA"));
+    EXPECT_FALSE(ledger.receivePrepaidItem("AAAAA"));
+    EXPECT_TRUE(ledger.receivePrepaidItem("BBBBB"));
+    EXPECT_TRUE(ledger.receivePrepaidItem("BBBBB"));
+    EXPECT_FALSE(ledger.receivePrepaidItem("BBBBB"));
+    EXPECT_FALSE(ledger.receivePrepaidItem(""));
+    EXPECT_EQ(ledger.getPendingPrepaidCount(), 0u);
+    EXPECT_EQ(ledger.size(), 10003u); // 판매 기록은 남는다
+}
+
+TEST(SalesLedgerTest, ForEach_ShouldReadRecordsAcrossChunksWithSharedItems) {
+    SalesLedger ledger(1);
+    Item coke("01", "콜라", 1000);
+    Item tea("04", "홍차", 1500);
+    size_t total = SalesLedger::kChunkRecords * 2 + 10;
+    for (size_t i = 0; i < total; ++i) {
+        ledger.append(Sale::createStandaloneSale(SaleRequest{"01", 1, i % 2 ? tea : coke}));
+    }
+    ledger.append(Sale::createSaleUsingCertCode(SaleRequest{"04", 3, tea}, "CCCCC"));
+    ASSERT_TRUE(ledger.receivePrepaidItem("CCCCC"));
+
+    size_t visited = 0;
+    long long revenue = 0;
+    uint64_t lastId = 0;
+    set<const Item *> items;
+    SalesLedger::Record last{};
+    ledger.forEach([&](const SalesLedger::Record &record) {
+        EXPECT_GT(record.saleId, lastId); // 한 스레드에서 기록한 순서 그대로
+        lastId = record.saleId;
+        revenue += record.totalAmount;
+        items.insert(record.item);
+        last = record;
+        ++visited;
+    });
+    EXPECT_EQ(visited, total + 1);
+    EXPECT_EQ(revenue, (long long)(total / 2) * 1000 + (long long)(total / 2) * 1500 + 4500);
+    // 아이템은 기록마다 복사하지 않고 조각에 한 번만 둔다
+    EXPECT_EQ(items.size(), 2u);
+    EXPECT_EQ(last.item->getItemCode(), "04");
+    EXPECT_EQ(last.count, 3);
+    EXPECT_EQ(last.flags, SalesLedger::FlagPrepaid | SalesLedger::FlagReceived);
+}
+
+TEST(SalesLedgerTest, PrepaidFromOther_ShouldMarkReceivedOrExpired) {
+    SalesLedger ledger;
+    Item tea("04", "홍차", 1500);
+    SalesLedger::Record sale = ledger.recordPrepaid(tea, 2, "AAAAA", 3);
+    ledger.recordPrepaid(tea, 1, "BBBBB", 3);
+    EXPECT_EQ(sale.flags, SalesLedger::FlagPrepaid);
+    EXPECT_EQ(sale.sourceDvm, 3);
+    EXPECT_EQ(ledger.getPendingPrepaidCount(), 2u);
+
+    EXPECT_TRUE(ledger.receivePrepaidItem("AAAAA"));
+    EXPECT_TRUE(ledger.expirePrepaidItem("BBBBB"));
+    EXPECT_FALSE(ledger.expirePrepaidItem("AAAAA"));
+    EXPECT_EQ(ledger.getPendingPrepaidCount(), 0u);
+
+    vector<uint8_t> flags;
+    ledger.forEach([&flags](const SalesLedger::Record &record) { flags.push_back(record.flags); });
+    sort(flags.begin(), flags.end());
+    EXPECT_EQ(flags, (vector<uint8_t>{SalesLedger::FlagPrepaid | SalesLedger::FlagReceived,
+                                      SalesLedger::FlagPrepaid | SalesLedger::FlagExpired}));
+}
+
+// ===== 판매 통계 테스트 =====
+
+TEST(SalesAnalyticsTest, Query_ShouldAggregateByItemHourAndSource) {
+    SalesLedger ledger(1);
+    Item coke("01", "콜라", 1000);
+    Item tea("04", "홍차", 1500);
+    const int64_t hour = 1700000000000 / SalesAnalytics::kHourMs * SalesAnalytics::kHourMs;
+    // 묶음 경계를 넘도록 일반 판매를 충분히 기록한다
+    const int directSales = (int)SalesLedger::kChunkRecords + 100;
+    for (int i = 0; i < directSales; ++i) {
+        ledger.restore(i + 1, hour + (i % 2) * SalesAnalytics::kHourMs, i % 2 ? tea : coke, 1,
+                       i % 2 ? 1500 : 1000, 0, 1);
+    }
+    ledger.restore(9001, hour + 10, tea, 2, 3000, SalesLedger::FlagPrepaid, 2, "AAAAA");
+    ledger.restore(9002, hour + 20, tea, 1, 1500, SalesLedger::FlagPrepaid, 2, "BBBBB");
+    ledger.restore(9003, hour + 30, coke, 1, 1000, SalesLedger::FlagPrepaid, 3, "CCCCC");
+    ledger.receivePrepaidItem("AAAAA");
+    ledger.expirePrepaidItem("BBBBB");
+
+    SalesStats stats = SalesAnalytics::query(ledger, SalesQuery{});
+    // 만료된 선결제는 재고가 돌아갔으므로 판매로 세지 않는다
+    EXPECT_EQ(stats.sales, directSales + 2);
+    EXPECT_EQ(stats.units, directSales + 3);
+    EXPECT_EQ(stats.prepaid, 2);
+    EXPECT_DOUBLE_EQ(stats.prepaidRatio(), 2.0 / (directSales + 2));
+    EXPECT_EQ(stats.items["01"].revenue, (directSales / 2) * 1000 + 1000);
+    EXPECT_EQ(stats.items["04"].units, directSales / 2 + 2);
+    EXPECT_EQ(stats.units_by_hour[hour], directSales / 2 + 3);
+    EXPECT_EQ(stats.units_by_hour[hour + SalesAnalytics::kHourMs], directSales / 2);
+    ASSERT_EQ(stats.sources.size(), 2u);
+    EXPECT_EQ(stats.sources[2].prepaid, 2);
+    EXPECT_EQ(stats.sources[2].redeemed, 1);
+    EXPECT_EQ(stats.sources[2].expired, 1);
+    EXPECT_EQ(stats.sources[3].prepaid, 1);
+    EXPECT_EQ(stats.sources[3].redeemed, 0);
+
+    SalesQuery filtered;
+    filtered.from_ms = hour;
+    filtered.to_ms = hour + SalesAnalytics::kHourMs;
+    filtered.item_code = "04";
+    filtered.source_dvm = 2;
+    SalesStats narrow = SalesAnalytics::query(ledger, filtered);
+    EXPECT_EQ(narrow.sales, 1);
+    EXPECT_EQ(narrow.revenue, 3000);
+    EXPECT_EQ(narrow.items.count("01"), 0u);
+    EXPECT_EQ(narrow.sources[2].prepaid, 2);
+
+    filtered.item_code = "99";
+    EXPECT_EQ(SalesAnalytics::query(ledger, filtered).sales, 0);
+}
+
+TEST(SalesLedgerTest, ForEachChunk_ShouldNotBlockRecordingOnTheSameShard) {
+    SalesLedger ledger(1);
+    Item coke("01", "콜라", 1000);
+    for (size_t i = 0; i < SalesLedger::kChunkRecords + 5; ++i) {
+        ledger.record(coke, 1);
+    }
+    ledger.recordPrepaid(coke, 1, "AAAAA", 2);
+
+    // 훑는 중에 같은 조각에 기록해도 멈추지 않고, 시작할 때의 기록만 방문한다
+    size_t visited = 0;
+    int prepaid = 0;
+    ledger.forEachChunk(0, [&](const SalesLedger::Columns &columns, const vector<Item> &items) {
+        ledger.record(coke, 1);
+        ledger.receivePrepaidItem("AAAAA");
+        visited += columns.size;
+        for (size_t i = 0; i < columns.size; ++i) {
+            prepaid += columns.flags[i] & SalesLedger::FlagPrepaid;
+        }
+        EXPECT_EQ(items.size(), 1u);
+    });
+    EXPECT_EQ(visited, SalesLedger::kChunkRecords + 6);
+    EXPECT_EQ(prepaid, 1);
+    EXPECT_EQ(ledger.size(), SalesLedger::kChunkRecords + 8);
+}
+
+TEST(SalesAnalyticsTest, Query_ParallelShouldMatchSingleThread) {
+    SalesLedger ledger(8);
+    Item coke("01", "콜라", 1000);
+    Item tea("04", "홍차", 1500);
+    vector<thread> writers;
+    for (int t = 0; t < 8; ++t) {
+        writers.emplace_back([&ledger, &coke, &tea, t]() {
+            for (int i = 0; i < 40000; ++i) {
+                const Item &item = (i + t) % 3 ? coke : tea;
+                ledger.restore((uint64_t)t << 32 | i, 1700000000000 + i * 1000LL, item, 1 + i % 4,
+                               item.calculatePrice(1 + i % 4), i % 7 == 0 ? SalesLedger::FlagPrepaid : 0, t);
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+
+    SalesStats single = SalesAnalytics::query(ledger, SalesQuery{}, 1);
+    SalesStats parallel = SalesAnalytics::query(ledger, SalesQuery{}, 4);
+    EXPECT_EQ(single.sales, 320000);
+    EXPECT_EQ(parallel.sales, single.sales);
+    EXPECT_EQ(parallel.units, single.units);
+    EXPECT_EQ(parallel.revenue, single.revenue);
+    EXPECT_EQ(parallel.prepaid, single.prepaid);
+    EXPECT_EQ(parallel.units_by_hour, single.units_by_hour);
+    EXPECT_EQ(parallel.items["04"].revenue, single.items["04"].revenue);
+    EXPECT_EQ(parallel.sources.size(), single.sources.size());
+}
+
+TEST(SalesAnalyticsTest, QuerySales_ShouldCountRedemptionsPerPayingDvm) {
+    Item tea("04", "홍차", 1500);
+    DVM dvm(1, Location(0, 0), {{tea, 10}}, {tea}, {}, {});
+    dvm.requestOrder(SaleRequest{"04", 1, tea});
+    dvm.saveSaleFromOther("04", 2, "PAID1", 2);
+    dvm.saveSaleFromOther("04", 1, "PAID2", 2);
+    ASSERT_TRUE(dvm.processPrepaidItem("PAID1"));
+
+    SalesStats stats = dvm.querySales(SalesQuery{});
+    EXPECT_EQ(stats.sales, 3);
+    EXPECT_EQ(stats.revenue, 6000);
+    EXPECT_EQ(stats.prepaid, 2);
+    EXPECT_EQ(stats.sources[2].prepaid, 2);
+    EXPECT_EQ(stats.sources[2].redeemed, 1);
+    EXPECT_EQ(stats.sources.count(1), 0u); // 이 DVM의 일반 판매는 선결제가 아니다
+}
+
+// ===== 인증코드 등록부 테스트 =====
+
+TEST(CertificationRegistryTest, Pack_ShouldRoundTripBase62Codes) {
+    uint32_t packed;
+    ASSERT_TRUE(CertificationRegistry::pack("aZ09x", packed));
+    EXPECT_EQ(CertificationRegistry::unpack(packed), "aZ09x");
+    ASSERT_TRUE(CertificationRegistry::pack("ZZZZZ", packed));
+    EXPECT_EQ(packed, 916132831u); // 62^5 - 1
+    EXPECT_FALSE(CertificationRegistry::pack("abcd", packed));
+    EXPECT_FALSE(CertificationRegistry::pack("ab_de", packed));
+}
+
+TEST(CertificationRegistryTest, Redeem_ShouldAcceptEachCodeOnce) {
+    CertificationRegistry registry(0, 1000);
+    EXPECT_TRUE(registry.add("abcde", 1, 2));
+    EXPECT_TRUE(registry.add("LONG_CODE", 3, 1));
+    EXPECT_FALSE(registry.add("abcde", 1, 1));
+    EXPECT_EQ(registry.size(), 2u);
+
+    EXPECT_TRUE(registry.redeem("abcde"));
+    EXPECT_FALSE(registry.redeem("abcde"));
+    EXPECT_TRUE(registry.redeem("LONG_CODE"));
+    EXPECT_EQ(registry.size(), 0u);
+    EXPECT_TRUE(registry.collectExpired(chrono::steady_clock::now() + chrono::hours(1)).empty());
+}
+
+TEST(CertificationRegistryTest, CollectExpired_ShouldReturnReservationsOnceInBulk) {
+    CertificationRegistry registry(100, 10);
+    auto start = chrono::steady_clock::now();
+    registry.add("AAAAA", 1, 2, start);
+    registry.add("BBBBB", 1, 3, start);
+    registry.add("weird code", 4, 1, start);
+    registry.add("CCCCC", 2, 1, start + chrono::milliseconds(60));
+    registry.redeem("BBBBB");
+
+    EXPECT_TRUE(registry.collectExpired(start + chrono::milliseconds(50)).empty());
+    auto expired = registry.collectExpired(start + chrono::milliseconds(130));
+    ASSERT_EQ(expired.size(), 2u);
+    int total = 0;
+    for (const auto &reservation : expired) {
+        total += reservation.count;
+    }
+    EXPECT_EQ(total, 3);
+    EXPECT_TRUE(registry.contains("CCCCC"));
+
+    // 오래 호출되지 않아도 남은 코드를 모두 만료시킨다
+    expired = registry.collectExpired(start + chrono::seconds(10));
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0].itemSlot, 2);
+    EXPECT_EQ(registry.size(), 0u);
+}
+
+TEST(DVMCertCodeTest, ExpiredCode_ShouldReturnStockAndStopWorking) {
+    int savedExpiry = Config::get().certCodeExpiryMs;
+    int savedTick = Config::get().certExpiryTickMs;
+    Config::get().certCodeExpiryMs = 40;
+    Config::get().certExpiryTickMs = 10;
+    Item coke("01", "콜라", 1000);
+    DVM dvm(1, Location(0, 0), {{coke, 5}}, {coke}, {}, {});
+    Config::get().certCodeExpiryMs = savedExpiry;
+    Config::get().certExpiryTickMs = savedTick;
+
+    dvm.saveSaleFromOther("01", 2, "KEEP1");
+    dvm.saveSaleFromOther("01", 3, "LATE1");
+    EXPECT_THROW(dvm.saveSaleFromOther("01", 1, "KEEP1"), DuplicateCertCodeException);
+    EXPECT_THROW(dvm.saveSaleFromOther("01", 1, "NOSTOCK"), runtime_error);
+    EXPECT_FALSE(dvm.getCertCodes().contains("NOSTOCK"));
+    EXPECT_EQ(dvm.getStocks().at(coke), 0);
+    EXPECT_TRUE(dvm.processPrepaidItem("KEEP1"));
+
+    this_thread::sleep_for(chrono::milliseconds(80));
+    EXPECT_FALSE(dvm.processPrepaidItem("LATE1"));
+    EXPECT_EQ(dvm.getStocks().at(coke), 3);
+    EXPECT_EQ(dvm.getCertCodes().size(), 0u);
+}
+
+TEST(DVMCertCodeTest, ConcurrentExpiryAndRedemption_ShouldConserveStock) {
+    int savedExpiry = Config::get().certCodeExpiryMs;
+    int savedTick = Config::get().certExpiryTickMs;
+    Config::get().certCodeExpiryMs = 30;
+    Config::get().certExpiryTickMs = 5;
+    Item coke("01", "콜라", 1000);
+    const int codes = 2000;
+    DVM dvm(1, Location(0, 0), {{coke, codes}}, {coke}, {}, {});
+    Config::get().certCodeExpiryMs = savedExpiry;
+    Config::get().certExpiryTickMs = savedTick;
+
+    vector<string> certCodes;
+    for (int i = 0; i < codes; ++i) {
+        certCodes.push_back(CertificationRegistry::unpack((uint32_t)i));
+        dvm.saveSaleFromOther("01", 1, certCodes.back());
+    }
+    ASSERT_EQ(dvm.getStocks().at(coke), 0);
+
+    // 만료 처리가 재고를 돌리기 시작하면 아직 돌리지 않은 코드들을 뒤에서부터 수령한다
+    atomic<int> redeemed{0};
+    atomic<bool> done{false};
+    thread expirer([&dvm, &done]() {
+        while (!done.load()) {
+            dvm.expireCertCodes();
+        }
+    });
+    thread redeemer([&]() {
+        while (dvm.getStocks().at(coke) == 0) {
+            this_thread::yield();
+        }
+        for (auto code = certCodes.rbegin(); code != certCodes.rend(); ++code) {
+            if (dvm.processPrepaidItem(*code)) {
+                redeemed++;
+            }
+        }
+        done = true;
+    });
+    redeemer.join();
+    expirer.join();
+    dvm.expireCertCodes();
+
+    // 코드마다 수령(아이템을 내줌)과 만료(재고 반환) 중 정확히 하나만 일어난다
+    EXPECT_EQ(dvm.getStocks().at(coke) + redeemed.load(), codes);
+    for (const auto &code : certCodes) {
+        EXPECT_FALSE(dvm.processPrepaidItem(code));
+    }
+}
+
+TEST(DVMConcurrencyTest, ConcurrentOrders_ShouldNeverOversell) {
+    Item coke("01", "콜라", 1000);
+    Item cider("02", "사이다", 1000);
+    DVM dvm(1, Location(0, 0), {{coke, 50}, {cider, 1000}}, {coke, cider}, {}, {});
+
+    atomic<int> sold{0};
+    vector<thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&dvm, &sold, &coke, &cider]() {
+            for (int i = 0; i < 20; ++i) {
+                try {
+                    dvm.requestOrder(SaleRequest{"01", 1, coke});
+                    sold++;
+                } catch (const runtime_error &) {
+                }
+                dvm.requestOrder(SaleRequest{"02", 1, cider});
+                dvm.queryStocks("02", 1);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(sold.load(), 50);
+    EXPECT_EQ(dvm.getStocks().at(coke), 0);
+    EXPECT_EQ(dvm.getStocks().at(cider), 840);
+    EXPECT_EQ(dvm.getSaleCount(), 210u);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
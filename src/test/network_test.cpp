@@ -0,0 +1,661 @@
+#include "gtest/gtest.h"
+#include "../app/network/peerserver.h"
+#include "../app/network/workerpool.h"
+#include "../app/network/peerconnectionpool.h"
+#include "../app/network/frame.h"
+#include "../app/network/binarycodec.h"
+#include "../app/network/messageparser.h"
+#include "../app/network/periodictask.h"
+#include "../app/dto.h"
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <future>
+
+using namespace std;
+
+// 테스트용 클라이언트 소켓 연결
+static int connectToServer(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    struct timeval timeout {3, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return sock;
+}
+
+// 요청을 보내고 쓰기 방향을 닫아 더 이상 요청이 없음을 알린다
+static void sendLastRequest(int sock, const string &request) {
+    send(sock, request.c_str(), request.size(), 0);
+    shutdown(sock, SHUT_WR);
+}
+
+static string receiveAll(int sock) {
+    string result;
+    char buffer[1024];
+    int bytesRead;
+    while ((bytesRead = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+        result.append(buffer, bytesRead);
+    }
+    return result;
+}
+
+// PeerServer를 별도 스레드에서 실행하는 테스트 픽스처
+class PeerServerTest : public ::testing::Test {
+protected:
+    unique_ptr<PeerServer> server;
+    thread serverThread;
+
+    void startServer(PeerServer::RequestHandler handler, int idleTimeoutMs = 3000, WorkerPool *pool = nullptr) {
+        server = make_unique<PeerServer>(0, handler, idleTimeoutMs, pool);
+        ASSERT_TRUE(server->start());
+        serverThread = thread(&PeerServer::run, server.get());
+    }
+
+    void TearDown() override {
+        if (server) {
+            server->stop();
+            serverThread.join();
+        }
+    }
+};
+
+// 요청 하나에 응답 하나를 돌려주고 연결을 닫는다
+TEST_F(PeerServerTest, RequestResponse_ShouldReturnHandlerResult) {
+    startServer([](const string &request) { return "echo:" + request; });
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    string request = "msg_type:req_stock;item_code:01;";
+    sendLastRequest(sock, request);
+
+    EXPECT_EQ(receiveAll(sock), "echo:" + request);
+    close(sock);
+}
+
+// 응답하지 않는 느린 피어가 다른 피어의 처리를 막지 않아야 한다
+TEST_F(PeerServerTest, SlowPeer_ShouldNotBlockOtherPeers) {
+    startServer([](const string &request) { return string("ok"); });
+
+    int slowSock = connectToServer(server->getPort());
+    ASSERT_GE(slowSock, 0);
+
+    auto start = chrono::steady_clock::now();
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    sendLastRequest(sock, "ping");
+    EXPECT_EQ(receiveAll(sock), "ok");
+    auto elapsed = chrono::steady_clock::now() - start;
+
+    EXPECT_LT(chrono::duration_cast<chrono::milliseconds>(elapsed).count(), 1000);
+    close(sock);
+    close(slowSock);
+}
+
+// 여러 피어 연결을 동시에 유지하면서 모두 응답해야 한다
+TEST_F(PeerServerTest, ManyConcurrentPeers_ShouldAllBeServed) {
+    startServer([](const string &request) { return "resp:" + request; });
+
+    const int peerCount = 200;
+    vector<int> socks;
+    for (int i = 0; i < peerCount; ++i) {
+        int sock = connectToServer(server->getPort());
+        ASSERT_GE(sock, 0);
+        socks.push_back(sock);
+    }
+    for (int i = 0; i < peerCount; ++i) {
+        string request = to_string(i);
+        sendLastRequest(socks[i], request);
+    }
+    for (int i = 0; i < peerCount; ++i) {
+        EXPECT_EQ(receiveAll(socks[i]), "resp:" + to_string(i));
+        close(socks[i]);
+    }
+}
+
+// 응답 후에도 연결을 유지하여 같은 연결로 다음 요청을 보낼 수 있다
+TEST_F(PeerServerTest, KeepAlive_ShouldServeMultipleRequestsOnOneConnection) {
+    startServer([](const string &request) { return "resp:" + request; });
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    char buffer[64];
+    for (int i = 0; i < 3; ++i) {
+        string request = to_string(i);
+        send(sock, request.c_str(), request.size(), 0);
+        int bytesRead = recv(sock, buffer, sizeof(buffer), 0);
+        ASSERT_GT(bytesRead, 0);
+        EXPECT_EQ(string(buffer, bytesRead), "resp:" + request);
+    }
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+    close(sock);
+}
+
+// 유휴 시간을 초과한 연결은 서버가 닫는다
+TEST_F(PeerServerTest, IdleConnection_ShouldBeClosedAfterTimeout) {
+    startServer([](const string &request) { return string("ok"); }, 100);
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+
+    char buffer[16];
+    int bytesRead = recv(sock, buffer, sizeof(buffer), 0);
+    EXPECT_EQ(bytesRead, 0);
+    close(sock);
+}
+
+// stop() 호출 시 이벤트 루프가 종료된다
+TEST_F(PeerServerTest, Stop_ShouldEndEventLoop) {
+    startServer([](const string &request) { return string("ok"); });
+    server->stop();
+    serverThread.join();
+    server.reset();
+    SUCCEED();
+}
+
+// 워커 풀을 사용하면 느린 핸들러도 병렬로 처리된다
+TEST_F(PeerServerTest, WorkerPool_ShouldHandleRequestsInParallel) {
+    WorkerPool pool(4, 16);
+    startServer([](const string &request) {
+        this_thread::sleep_for(chrono::milliseconds(300));
+        return "done:" + request;
+    }, 3000, &pool);
+
+    auto start = chrono::steady_clock::now();
+    vector<int> socks;
+    for (int i = 0; i < 4; ++i) {
+        int sock = connectToServer(server->getPort());
+        ASSERT_GE(sock, 0);
+        string request = to_string(i);
+        sendLastRequest(sock, request);
+        socks.push_back(sock);
+    }
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(receiveAll(socks[i]), "done:" + to_string(i));
+        close(socks[i]);
+    }
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+
+    // 순차 처리라면 1200ms 이상 소요
+    EXPECT_LT(elapsed, 1000);
+}
+
+// 워커 큐가 가득 차면 server_busy 에러로 즉시 응답한다
+TEST_F(PeerServerTest, WorkerPool_FullQueue_ShouldRejectWithBusyError) {
+    WorkerPool pool(1, 1);
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    startServer([released](const string &request) {
+        released.wait();
+        return string("ok");
+    }, 3000, &pool);
+
+    // 첫 요청은 워커를 점유하고, 두 번째 요청은 큐를 채운다
+    int first = connectToServer(server->getPort());
+    sendLastRequest(first, "1");
+    while (pool.getQueueDepth() != 0) this_thread::sleep_for(chrono::milliseconds(5));
+    this_thread::sleep_for(chrono::milliseconds(50));
+    int second = connectToServer(server->getPort());
+    sendLastRequest(second, "2");
+    while (pool.getQueueDepth() != 1) this_thread::sleep_for(chrono::milliseconds(5));
+
+    int third = connectToServer(server->getPort());
+    sendLastRequest(third, "3");
+    EXPECT_EQ(receiveAll(third), "msg_type:error;detail:server_busy;");
+
+    release.set_value();
+    EXPECT_EQ(receiveAll(first), "ok");
+    EXPECT_EQ(receiveAll(second), "ok");
+    close(first);
+    close(second);
+    close(third);
+}
+
+// WorkerPool: 제출한 작업이 모두 실행된다
+TEST(WorkerPoolTest, Submit_ShouldRunAllTasks) {
+    atomic<int> counter{0};
+    {
+        WorkerPool pool(3, 100);
+        for (int i = 0; i < 50; ++i) {
+            EXPECT_TRUE(pool.trySubmit([&counter] { counter++; }));
+        }
+    } // 소멸자에서 남은 작업 처리 후 종료
+    EXPECT_EQ(counter, 50);
+}
+
+// WorkerPool: 큐 용량을 초과한 작업은 거절된다
+TEST(WorkerPoolTest, Submit_ShouldRejectWhenQueueFull) {
+    WorkerPool pool(1, 2);
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    promise<void> started;
+
+    EXPECT_TRUE(pool.trySubmit([&started, released] { started.set_value(); released.wait(); }));
+    started.get_future().wait();
+
+    EXPECT_TRUE(pool.trySubmit([] {}));
+    EXPECT_TRUE(pool.trySubmit([] {}));
+    EXPECT_EQ(pool.getQueueDepth(), 2u);
+    EXPECT_FALSE(pool.trySubmit([] {}));
+    EXPECT_EQ(pool.getPeakQueueDepth(), 2u);
+
+    release.set_value();
+    pool.shutdown();
+    EXPECT_EQ(pool.getQueueDepth(), 0u);
+}
+
+// WorkerPool: 종료 후에는 작업을 받지 않는다
+TEST(WorkerPoolTest, Submit_AfterShutdown_ShouldFail) {
+    WorkerPool pool(2, 4);
+    EXPECT_EQ(pool.getThreadCount(), 2u);
+    EXPECT_EQ(pool.getQueueCapacity(), 4u);
+    pool.shutdown();
+    EXPECT_FALSE(pool.trySubmit([] {}));
+}
+
+// PeerConnectionPool: 반납한 연결을 다음 요청에서 재사용한다
+TEST_F(PeerServerTest, ConnectionPool_ShouldReuseReleasedConnection) {
+    startServer([](const string &request) { return "resp:" + request; });
+    PeerConnectionPool pool("127.0.0.1", server->getPort(), 2, 10000);
+
+    char buffer[64];
+    for (int i = 0; i < 3; ++i) {
+        bool reused = false;
+        int sock = pool.acquire(reused);
+        ASSERT_GE(sock, 0);
+        EXPECT_EQ(reused, i > 0);
+        send(sock, "x", 1, 0);
+        ASSERT_GT(recv(sock, buffer, sizeof(buffer), 0), 0);
+        pool.release(sock);
+    }
+    EXPECT_EQ(pool.getIdleCount(), 1u);
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+}
+
+// PeerConnectionPool: 최대 유휴 연결 수를 넘는 연결은 닫는다
+TEST_F(PeerServerTest, ConnectionPool_ShouldLimitIdleConnections) {
+    startServer([](const string &request) { return string("ok"); });
+    PeerConnectionPool pool("127.0.0.1", server->getPort(), 2, 10000);
+
+    vector<int> socks;
+    for (int i = 0; i < 3; ++i) {
+        bool reused = false;
+        socks.push_back(pool.acquire(reused));
+        ASSERT_GE(socks.back(), 0);
+    }
+    for (int sock : socks) {
+        pool.release(sock);
+    }
+    EXPECT_EQ(pool.getIdleCount(), 2u);
+}
+
+// PeerConnectionPool: 유휴 제한 시간이 지난 연결은 재사용하지 않는다
+TEST_F(PeerServerTest, ConnectionPool_ShouldNotReuseExpiredConnection) {
+    startServer([](const string &request) { return string("ok"); });
+    PeerConnectionPool pool("127.0.0.1", server->getPort(), 2, 50);
+
+    bool reused = false;
+    int sock = pool.acquire(reused);
+    ASSERT_GE(sock, 0);
+    pool.release(sock);
+    this_thread::sleep_for(chrono::milliseconds(100));
+
+    sock = pool.acquire(reused);
+    ASSERT_GE(sock, 0);
+    EXPECT_FALSE(reused);
+    pool.discard(sock);
+}
+
+// PeerConnectionPool: 서버가 닫은 유휴 연결은 버리고 새로 연결한다
+TEST_F(PeerServerTest, ConnectionPool_ShouldReconnectWhenServerClosedConnection) {
+    startServer([](const string &request) { return string("ok"); }, 100);
+    PeerConnectionPool pool("127.0.0.1", server->getPort(), 2, 10000);
+
+    bool reused = false;
+    int sock = pool.acquire(reused);
+    ASSERT_GE(sock, 0);
+    pool.release(sock);
+    this_thread::sleep_for(chrono::milliseconds(800));
+
+    sock = pool.acquire(reused);
+    ASSERT_GE(sock, 0);
+    EXPECT_FALSE(reused);
+    send(sock, "x", 1, 0);
+    char buffer[16];
+    EXPECT_GT(recv(sock, buffer, sizeof(buffer), 0), 0);
+    pool.discard(sock);
+}
+
+// PeerConnectionPool: 서버에 연결할 수 없으면 실패
+TEST(PeerConnectionPoolTest, Acquire_ShouldFailWhenServerUnavailable) {
+    PeerConnectionPool pool("127.0.0.1", 1, 2, 10000);
+    bool reused = true;
+    EXPECT_EQ(pool.acquire(reused), -1);
+    EXPECT_FALSE(reused);
+    EXPECT_EQ(pool.getIdleCount(), 0u);
+}
+
+// ===== 프레임 프로토콜 테스트 =====
+
+TEST(FrameDecoderTest, ShouldReassembleFrameSplitAcrossReads) {
+    string wire = Frame::encode("msg_type:req_stock;item_code:01;");
+    FrameDecoder decoder;
+    string payload;
+    uint8_t codec = 0xFF;
+
+    for (size_t i = 0; i + 1 < wire.size(); ++i) {
+        decoder.feed(&wire[i], 1);
+        EXPECT_EQ(decoder.next(payload, codec), FrameDecoder::Result::NeedMore);
+    }
+    decoder.feed(&wire.back(), 1);
+    ASSERT_EQ(decoder.next(payload, codec), FrameDecoder::Result::Ready);
+    EXPECT_EQ(payload, "msg_type:req_stock;item_code:01;");
+    EXPECT_EQ(codec, Frame::Text);
+    EXPECT_EQ(decoder.getBufferedSize(), 0u);
+}
+
+TEST(FrameDecoderTest, ShouldSplitMultipleFramesInOneRead) {
+    string wire = Frame::encode("first") + Frame::encode("") + Frame::encode(string(10000, 'x'));
+    FrameDecoder decoder;
+    decoder.feed(wire.data(), wire.size());
+
+    string payload;
+    uint8_t codec;
+    ASSERT_EQ(decoder.next(payload, codec), FrameDecoder::Result::Ready);
+    EXPECT_EQ(payload, "first");
+    ASSERT_EQ(decoder.next(payload, codec), FrameDecoder::Result::Ready);
+    EXPECT_EQ(payload, "");
+    ASSERT_EQ(decoder.next(payload, codec), FrameDecoder::Result::Ready);
+    EXPECT_EQ(payload.size(), 10000u);
+    EXPECT_EQ(decoder.next(payload, codec), FrameDecoder::Result::NeedMore);
+}
+
+TEST(FrameDecoderTest, ShouldRejectOversizedFrame) {
+    string wire = Frame::encode(string(100, 'x'));
+    FrameDecoder decoder(64);
+    decoder.feed(wire.data(), Frame::kHeaderSize);
+
+    string payload;
+    uint8_t codec;
+    EXPECT_EQ(decoder.next(payload, codec), FrameDecoder::Result::Error);
+}
+
+TEST(FrameDecoderTest, ShouldRejectBadMagic) {
+    FrameDecoder decoder;
+    string wire = "msg_type:req_stock;";
+    decoder.feed(wire.data(), wire.size());
+
+    string payload;
+    uint8_t codec;
+    EXPECT_EQ(decoder.next(payload, codec), FrameDecoder::Result::Error);
+}
+
+// 프레임으로 보낸 요청에는 프레임으로 응답해야 한다
+TEST_F(PeerServerTest, Framed_ShouldAnswerWithFrame) {
+    startServer([](const string &request) { return "echo:" + request; });
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    sendLastRequest(sock, Frame::encode("msg_type:req_stock;"));
+
+    EXPECT_EQ(receiveAll(sock), Frame::encode("echo:msg_type:req_stock;"));
+    close(sock);
+}
+
+// 한 번에 도착한 여러 프레임과 수신 버퍼보다 큰 메시지를 모두 처리해야 한다
+TEST_F(PeerServerTest, Framed_ShouldHandleBatchedAndLargeFrames) {
+    WorkerPool pool(2, 16);
+    startServer([](const string &request) { return to_string(request.size()); }, 3000, &pool);
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    string wire = Frame::encode("a") + Frame::encode(string(50000, 'b')) + Frame::encode("cc");
+    sendLastRequest(sock, wire);
+
+    string expected = Frame::encode("1") + Frame::encode("50000") + Frame::encode("2");
+    EXPECT_EQ(receiveAll(sock), expected);
+    close(sock);
+}
+
+// 헤더가 최대 크기를 넘는 프레임을 보내면 연결을 닫는다
+TEST_F(PeerServerTest, Framed_OversizedFrame_ShouldCloseConnection) {
+    server = make_unique<PeerServer>(0, [](const string &request) { return string("ok"); });
+    server->setMaxFrameSize(16);
+    ASSERT_TRUE(server->start());
+    serverThread = thread(&PeerServer::run, server.get());
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    string wire = Frame::encode(string(100, 'x'));
+    send(sock, wire.data(), wire.size(), 0);
+
+    EXPECT_EQ(receiveAll(sock), "");
+    close(sock);
+}
+
+// ===== 바이너리 codec 테스트 =====
+
+TEST(BinaryCodecTest, StockResponse_ShouldRoundTrip) {
+    BinaryMessage msg;
+    msg.type = BinaryMessage::Type::RespStock;
+    msg.srcId = 3;
+    msg.dstId = 12;
+    msg.reqId = 77;
+    msg.itemCode = 7;
+    msg.itemNum = 300;
+    msg.coorX = -15;
+    msg.coorY = 99999;
+
+    uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+    size_t size = BinaryCodec::encode(msg, buffer, sizeof(buffer));
+    ASSERT_GT(size, 0u);
+
+    BinaryMessage decoded;
+    ASSERT_TRUE(BinaryCodec::decode(buffer, size, decoded));
+    EXPECT_EQ(decoded.type, BinaryMessage::Type::RespStock);
+    EXPECT_EQ(decoded.srcId, 3);
+    EXPECT_EQ(decoded.dstId, 12);
+    EXPECT_EQ(decoded.reqId, 77u);
+    EXPECT_EQ(decoded.itemCode, 7);
+    EXPECT_EQ(decoded.itemNum, 300);
+    EXPECT_EQ(decoded.coorX, -15);
+    EXPECT_EQ(decoded.coorY, 99999);
+
+    // 같은 내용의 텍스트 메시지보다 훨씬 작아야 한다
+    string text = "msg_type:resp_stock;src_id:T3;dst_id:T12;item_code:07;item_num:300;coor_x:-15;coor_y:99999;";
+    EXPECT_LT(size * 4, text.size());
+}
+
+TEST(BinaryCodecTest, PrepayRequest_ShouldCarryCertCode) {
+    BinaryMessage msg;
+    msg.type = BinaryMessage::Type::ReqPrepay;
+    msg.itemCode = 20;
+    msg.itemNum = 2;
+    ASSERT_TRUE(msg.setCertCode("aB3xZ"));
+    EXPECT_FALSE(msg.setCertCode(string(BinaryMessage::kMaxCertCodeLength + 1, 'x')));
+
+    uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+    size_t size = BinaryCodec::encode(msg, buffer, sizeof(buffer));
+    BinaryMessage decoded;
+    ASSERT_TRUE(BinaryCodec::decode(buffer, size, decoded));
+    EXPECT_EQ(decoded.getCertCode(), "aB3xZ");
+    EXPECT_EQ(decoded.itemCode, 20);
+}
+
+TEST(BinaryCodecTest, Decode_ShouldRejectTruncatedInput) {
+    BinaryMessage msg;
+    msg.type = BinaryMessage::Type::RespStock;
+    msg.itemNum = 100000;
+    uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+    size_t size = BinaryCodec::encode(msg, buffer, sizeof(buffer));
+
+    BinaryMessage decoded;
+    EXPECT_FALSE(BinaryCodec::decode(buffer, size - 1, decoded));
+    EXPECT_FALSE(BinaryCodec::decode(buffer, 0, decoded));
+}
+
+TEST(BinaryCodecTest, Decode_ShouldSkipUnknownFields) {
+    // type=ReqStock, 알 수 없는 varint 필드(20), 알 수 없는 bytes 필드(21), item_num=5
+    const uint8_t data[] = {0x08, 0x01, 0xA0, 0x05, 0xAA, 0x02, 'h', 'i', 0x28, 0x0A};
+    BinaryMessage decoded;
+    ASSERT_TRUE(BinaryCodec::decode(data, sizeof(data), decoded));
+    EXPECT_EQ(decoded.type, BinaryMessage::Type::ReqStock);
+    EXPECT_EQ(decoded.itemNum, 5);
+}
+
+TEST(BinaryCodecTest, Encode_ShouldFailWhenBufferTooSmall) {
+    BinaryMessage msg;
+    msg.type = BinaryMessage::Type::RespStock;
+    msg.itemNum = 100000;
+    uint8_t buffer[3];
+    EXPECT_EQ(BinaryCodec::encode(msg, buffer, sizeof(buffer)), 0u);
+}
+
+TEST(BinaryCodecTest, ItemCodeAndPeerId_ShouldOnlyAcceptCanonicalForms) {
+    uint8_t code = 0;
+    EXPECT_TRUE(BinaryCodec::encodeItemCode("05", code));
+    EXPECT_EQ(code, 5);
+    EXPECT_FALSE(BinaryCodec::encodeItemCode("005", code));
+    EXPECT_FALSE(BinaryCodec::encodeItemCode("A1", code));
+
+    char formatted[2];
+    BinaryCodec::formatItemCode(17, formatted);
+    EXPECT_EQ(string(formatted, 2), "17");
+
+    int32_t id = 0;
+    EXPECT_TRUE(BinaryCodec::encodePeerId("T12", id));
+    EXPECT_EQ(id, 12);
+    EXPECT_FALSE(BinaryCodec::encodePeerId("12", id));
+    EXPECT_FALSE(BinaryCodec::encodePeerId("T", id));
+}
+
+TEST(BinaryCodecTest, StockBatch_ShouldRoundTrip) {
+    BinaryMessage msg;
+    msg.type = BinaryMessage::Type::ReqStockBatch;
+    for (uint8_t code = 1; code <= BinaryMessage::kMaxBatchItems; ++code) {
+        ASSERT_TRUE(msg.addBatchItem(code, code * 100));
+    }
+    EXPECT_FALSE(msg.addBatchItem(99, 1));
+
+    uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+    size_t size = BinaryCodec::encode(msg, buffer, sizeof(buffer));
+    ASSERT_GT(size, 0u);
+
+    BinaryMessage decoded;
+    ASSERT_TRUE(BinaryCodec::decode(buffer, size, decoded));
+    ASSERT_EQ(decoded.batchCount, BinaryMessage::kMaxBatchItems);
+    EXPECT_EQ(decoded.batch[0].itemCode, 1);
+    EXPECT_EQ(decoded.batch[19].itemCode, 20);
+    EXPECT_EQ(decoded.batch[19].itemNum, 2000);
+}
+
+// 등록되지 않은 codec의 프레임에는 텍스트 오류로 응답한다
+TEST_F(PeerServerTest, Framed_UnsupportedCodec_ShouldAnswerTextError) {
+    startServer([](const string &request) { return string("ok"); });
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    sendLastRequest(sock, Frame::encode("x", Frame::Binary));
+
+    EXPECT_EQ(receiveAll(sock), Frame::encode("msg_type:error;detail:unsupported_codec;"));
+    close(sock);
+}
+
+// ===== 메시지 파서 테스트 =====
+
+TEST(MessageParserTest, Next_ShouldFollowLegacyTokenRules) {
+    MessageParser parser("msg_type:req_stock;;garbage;time:12:30;empty:;");
+    string_view key, value;
+
+    ASSERT_TRUE(parser.next(key, value));
+    EXPECT_EQ(key, "msg_type");
+    EXPECT_EQ(value, "req_stock");
+    ASSERT_TRUE(parser.next(key, value));
+    EXPECT_EQ(key, "time");
+    EXPECT_EQ(value, "12:30");
+    ASSERT_TRUE(parser.next(key, value));
+    EXPECT_EQ(key, "empty");
+    EXPECT_EQ(value, "");
+    EXPECT_FALSE(parser.next(key, value));
+}
+
+TEST(MessageParserTest, Find_ShouldReturnLastValue) {
+    EXPECT_EQ(MessageParser::find("a:1;b:2;a:3", "a"), "3");
+    EXPECT_EQ(MessageParser::find("a:1;b:2", "c"), "");
+}
+
+TEST(MessageParserTest, ToInt_ShouldMatchStoiRules) {
+    int value = 0;
+    EXPECT_TRUE(MessageParser::toInt(" 42", value));
+    EXPECT_EQ(value, 42);
+    EXPECT_TRUE(MessageParser::toInt("+7abc", value));
+    EXPECT_EQ(value, 7);
+    EXPECT_TRUE(MessageParser::toInt("-3", value));
+    EXPECT_EQ(value, -3);
+    EXPECT_FALSE(MessageParser::toInt("abc", value));
+    EXPECT_FALSE(MessageParser::toInt("", value));
+    EXPECT_FALSE(MessageParser::toInt("99999999999", value));
+    EXPECT_EQ(MessageParser::toIntOr("x", -1), -1);
+}
+
+// 프레임 모드에서는 한 연결의 요청을 동시에 처리하고 먼저 끝난 응답부터 보낸다
+TEST_F(PeerServerTest, Framed_PipelinedRequestsMayCompleteOutOfOrder) {
+    WorkerPool pool(4, 16);
+    startServer([](const string &request) {
+        if (request == "slow") {
+            this_thread::sleep_for(chrono::milliseconds(300));
+        }
+        return "done:" + request;
+    }, 3000, &pool);
+
+    int sock = connectToServer(server->getPort());
+    ASSERT_GE(sock, 0);
+    sendLastRequest(sock, Frame::encode("slow") + Frame::encode("a") + Frame::encode("b"));
+
+    string received = receiveAll(sock);
+    FrameDecoder decoder;
+    decoder.feed(received.data(), received.size());
+    vector<string> responses;
+    string payload;
+    uint8_t codec;
+    while (decoder.next(payload, codec) == FrameDecoder::Result::Ready) {
+        responses.push_back(payload);
+    }
+    ASSERT_EQ(responses.size(), 3u);
+    EXPECT_EQ(responses.back(), "done:slow");
+    close(sock);
+}
+
+// ===== PeriodicTask 테스트 =====
+
+TEST(PeriodicTaskTest, ShouldRunImmediatelyAndRepeatUntilStopped) {
+    atomic<int> runs{0};
+    PeriodicTask task(20, [&runs]() { runs++; });
+    task.start();
+    this_thread::sleep_for(chrono::milliseconds(90));
+    task.stop();
+    int stopped = runs.load();
+    EXPECT_GE(stopped, 2);
+    this_thread::sleep_for(chrono::milliseconds(50));
+    EXPECT_EQ(runs.load(), stopped);
+}
+
+TEST(PeriodicTaskTest, NonPositiveInterval_ShouldNotStart) {
+    atomic<int> runs{0};
+    PeriodicTask task(0, [&runs]() { runs++; });
+    task.start();
+    task.stop();
+    EXPECT_EQ(runs.load(), 0);
+}
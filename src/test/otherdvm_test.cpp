@@ -3,8 +3,16 @@
 #include "../app/application/otherdvm.h"
 #include "../app/domain/location.h"
 #include "../app/dto.h"
+#include "../app/network/peerserver.h"
 #include <string>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
 
 using namespace std;
 using ::testing::Return;
@@ -475,6 +483,20 @@ TEST_F(OtherDVMTest, SocketMessageSerialization) {
 }
 
 // TC-COM-002: SocketMessage 직렬화/역직렬화 테스트 - 선결제
+TEST_F(OtherDVMTest, SocketMessageSerialization_RequestId) {
+    SocketMessage msg;
+    msg.msg_type = "req_stock";
+    msg.src_id = "T1";
+    msg.dst_id = "T2";
+    msg.req_id = "7";
+    SocketMessage parsed = SocketMessage::deserialize(msg.serialize());
+    EXPECT_EQ(parsed.req_id, "7");
+    EXPECT_EQ(parsed.msg_content.count("req_id"), 0u);
+
+    msg.req_id.clear();
+    EXPECT_EQ(msg.serialize().find("req_id"), string::npos);
+}
+
 TEST_F(OtherDVMTest, SocketMessageSerialization_Prepayment) {
     // 선결제 응답 메시지 생성
     std::string serializedResponse = MockSocketMessage::createPrepaymentResponse("001", 5, true);
@@ -579,6 +601,330 @@ TEST_F(OtherDVMTest, GuideToNearestVendingMachine) {
     EXPECT_EQ(distance1, distance2);  // dvm1과 dvm2는 동일한 거리
 }
 
+// 실제 피어 서버와 통신하는 OtherDVM 테스트 픽스처
+class OtherDVMNetworkTest : public ::testing::Test {
+protected:
+    unique_ptr<PeerServer> server;
+    thread serverThread;
+
+    void startServer(PeerServer::RequestHandler handler, int idleTimeoutMs = 3000) {
+        server = make_unique<PeerServer>(0, handler, idleTimeoutMs);
+        ASSERT_TRUE(server->start());
+        serverThread = thread(&PeerServer::run, server.get());
+    }
+
+    void TearDown() override {
+        if (server) {
+            server->stop();
+            serverThread.join();
+        }
+    }
+};
+
+// TC-COM-002: 연속된 재고 조회가 하나의 연결을 재사용한다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocks_ShouldReusePooledConnection) {
+    startServer([](const string &request) {
+        return MockSocketMessage::createStockResponse("01", 3, 7, 8);
+    });
+    OtherDVM peer(2, Location(7, 8), "127.0.0.1", server->getPort());
+
+    for (int i = 0; i < 3; ++i) {
+        CheckStockResponse response = peer.findAvailableStocks(CheckStockRequest{"01", 3}, 1);
+        EXPECT_EQ(response.item_code, "01");
+        EXPECT_EQ(response.item_num, 3);
+        EXPECT_EQ(response.coor_x, 7);
+        EXPECT_EQ(response.coor_y, 8);
+    }
+    EXPECT_EQ(peer.getIdleConnectionCount(), 1u);
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+}
+
+// TC-PRE-001: 복사된 OtherDVM은 같은 연결 풀을 공유한다
+TEST_F(OtherDVMNetworkTest, AskForPrepayment_CopiesShouldSharePool) {
+    startServer([](const string &request) {
+        return MockSocketMessage::createPrepaymentResponse("01", 1, true);
+    });
+    OtherDVM peer(2, Location(7, 8), "127.0.0.1", server->getPort());
+    OtherDVM copy = peer;
+
+    EXPECT_TRUE(peer.askForPrepayment(askPrepaymentRequest{"01", 1, "abc12"}, 1).availability);
+    EXPECT_TRUE(copy.askForPrepayment(askPrepaymentRequest{"01", 1, "abc13"}, 1).availability);
+    EXPECT_EQ(copy.getIdleConnectionCount(), 1u);
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+}
+
+// TC-COM-002: 서버가 닫은 연결을 감지하고 다시 연결한다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocks_ShouldReconnectAfterServerClose) {
+    startServer([](const string &request) {
+        return MockSocketMessage::createStockResponse("01", 2, 0, 0);
+    }, 100);
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", server->getPort());
+
+    EXPECT_EQ(peer.findAvailableStocks(CheckStockRequest{"01", 2}, 1).item_num, 2);
+    this_thread::sleep_for(chrono::milliseconds(800));
+    EXPECT_EQ(peer.findAvailableStocks(CheckStockRequest{"01", 2}, 1).item_num, 2);
+}
+
+// TC-COM-002: 프레임 모드에서는 수신 버퍼보다 큰 응답도 끝까지 받는다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocks_FramedShouldReceiveLargeResponse) {
+    bool savedFraming = Config::get().peerFraming;
+    Config::get().peerFraming = true;
+    startServer([](const string &request) {
+        return MockSocketMessage::createStockResponse("01", 4, 1, 2) + "padding:" + string(20000, 'p') + ";";
+    });
+    OtherDVM peer(2, Location(1, 2), "127.0.0.1", server->getPort());
+    Config::get().peerFraming = savedFraming;
+
+    for (int i = 0; i < 2; ++i) {
+        CheckStockResponse response = peer.findAvailableStocks(CheckStockRequest{"01", 4}, 1);
+        EXPECT_EQ(response.item_num, 4);
+        EXPECT_EQ(response.coor_y, 2);
+    }
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+}
+
+// TC-COM-002: 바이너리 codec을 사용하면 바이너리 프레임으로 조회하고,
+// 바이너리로 표현할 수 없는 아이템 코드는 텍스트 프레임으로 보낸다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocks_BinaryCodecShouldFallBackToText) {
+    bool savedBinary = Config::get().peerBinaryCodec;
+    Config::get().peerBinaryCodec = true;
+    server = make_unique<PeerServer>(0, [](const string &request) {
+        return MockSocketMessage::createStockResponse("001", 1, 5, 6);
+    });
+    server->setCodecHandler(Frame::Binary, [](const string &payload) {
+        BinaryMessage request;
+        BinaryMessage response;
+        BinaryCodec::decode((const uint8_t *)payload.data(), payload.size(), request);
+        response.type = BinaryMessage::Type::RespStock;
+        response.itemCode = request.itemCode;
+        response.itemNum = request.itemNum + 1;
+        response.coorX = 5;
+        response.coorY = 6;
+        uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+        return string((const char *)buffer, BinaryCodec::encode(response, buffer, sizeof(buffer)));
+    });
+    ASSERT_TRUE(server->start());
+    serverThread = thread(&PeerServer::run, server.get());
+    OtherDVM peer(2, Location(5, 6), "127.0.0.1", server->getPort());
+    Config::get().peerBinaryCodec = savedBinary;
+
+    CheckStockResponse binary = peer.findAvailableStocks(CheckStockRequest{"03", 2}, 1);
+    EXPECT_EQ(binary.item_code, "03");
+    EXPECT_EQ(binary.item_num, 3);
+    EXPECT_EQ(binary.coor_x, 5);
+
+    CheckStockResponse text = peer.findAvailableStocks(CheckStockRequest{"001", 2}, 1);
+    EXPECT_EQ(text.item_code, "001");
+    EXPECT_EQ(text.item_num, 1);
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+}
+
+// TC-COM-002: 파이프라이닝 조회는 하나의 연결로 보내고, 순서가 바뀐 응답을 req_id로 맞춘다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocksPipelined_ShouldMatchOutOfOrderResponses) {
+    bool savedFraming = Config::get().peerFraming;
+    Config::get().peerFraming = true;
+    WorkerPool pool(4, 64);
+    server = make_unique<PeerServer>(0, [](const string &request) {
+        SocketMessage req = SocketMessage::deserialize(request);
+        int itemNum = stoi(req.msg_content["item_num"]);
+        // 앞선 요청일수록 늦게 끝나도록 지연
+        this_thread::sleep_for(chrono::milliseconds(20 * (5 - itemNum)));
+        return MockSocketMessage::createStockResponse(req.msg_content["item_code"], itemNum * 10, 0, 0) +
+               "req_id:" + req.req_id + ";";
+    }, 3000, &pool);
+    ASSERT_TRUE(server->start());
+    serverThread = thread(&PeerServer::run, server.get());
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", server->getPort());
+    Config::get().peerFraming = savedFraming;
+
+    vector<CheckStockRequest> requests;
+    for (int i = 1; i <= 4; ++i) {
+        requests.push_back(CheckStockRequest{"0" + to_string(i), i});
+    }
+    vector<CheckStockResponse> responses = peer.findAvailableStocksPipelined(requests, 1);
+
+    ASSERT_EQ(responses.size(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(responses[i].item_code, "0" + to_string(i + 1));
+        EXPECT_EQ(responses[i].item_num, (i + 1) * 10);
+    }
+    EXPECT_EQ(server->getConnectionCount(), 1u);
+    server->stop();
+    serverThread.join();
+    server.reset();
+}
+
+// TC-COM-002: 텍스트 모드에서는 한 건씩 조회한다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocksPipelined_LegacyModeShouldQuerySequentially) {
+    startServer([](const string &request) {
+        return MockSocketMessage::createStockResponse("01", 2, 0, 0);
+    });
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", server->getPort());
+
+    vector<CheckStockResponse> responses = peer.findAvailableStocksPipelined({{"01", 1}, {"01", 2}}, 1);
+    ASSERT_EQ(responses.size(), 2u);
+    EXPECT_EQ(responses[0].item_num, 2);
+    EXPECT_EQ(responses[1].item_num, 2);
+}
+
+// TC-COM-002: 묶음 조회는 한 번의 요청으로 여러 아이템의 재고를 받는다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocksBatch_ShouldQueryAllItemsInOneRequest) {
+    atomic<int> requestCount{0};
+    startServer([&requestCount](const string &request) {
+        requestCount++;
+        SocketMessage req = SocketMessage::deserialize(request);
+        vector<CheckStockRequest> items = StockBatchField::parse(req.msg_content["items"]);
+        for (auto &item : items) {
+            item.item_num = item.item_code == "02" ? 0 : item.item_num;
+        }
+        return "msg_type:resp_stock_batch;src_id:T2;dst_id:" + req.src_id +
+               ";items:" + StockBatchField::format(items) + ";coor_x:3;coor_y:4;";
+    });
+    OtherDVM peer(2, Location(3, 4), "127.0.0.1", server->getPort());
+
+    CheckStockBatchResponse response = peer.findAvailableStocksBatch({{"01", 2}, {"02", 1}, {"003", 5}}, 1);
+    ASSERT_EQ(response.items.size(), 3u);
+    EXPECT_EQ(response.items[0].item_num, 2);
+    EXPECT_EQ(response.items[1].item_num, 0);
+    EXPECT_EQ(response.items[2].item_code, "003");
+    EXPECT_EQ(response.items[2].item_num, 5);
+    EXPECT_EQ(response.dst_id, 1);
+    EXPECT_EQ(response.coor_y, 4);
+    EXPECT_EQ(requestCount.load(), 1);
+}
+
+// TC-COM-002: 바이너리 codec에서도 묶음 조회를 한 프레임으로 주고받는다
+TEST_F(OtherDVMNetworkTest, FindAvailableStocksBatch_BinaryCodecShouldRoundTrip) {
+    bool savedBinary = Config::get().peerBinaryCodec;
+    Config::get().peerBinaryCodec = true;
+    server = make_unique<PeerServer>(0, [](const string &request) { return string("unexpected_text"); });
+    server->setCodecHandler(Frame::Binary, [](const string &payload) {
+        BinaryMessage request;
+        BinaryMessage response;
+        BinaryCodec::decode((const uint8_t *)payload.data(), payload.size(), request);
+        response.type = BinaryMessage::Type::RespStockBatch;
+        for (uint8_t i = 0; i < request.batchCount; ++i) {
+            response.addBatchItem(request.batch[i].itemCode, request.batch[i].itemNum + 1);
+        }
+        uint8_t buffer[BinaryCodec::kMaxEncodedSize];
+        return string((const char *)buffer, BinaryCodec::encode(response, buffer, sizeof(buffer)));
+    });
+    ASSERT_TRUE(server->start());
+    serverThread = thread(&PeerServer::run, server.get());
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", server->getPort());
+    Config::get().peerBinaryCodec = savedBinary;
+
+    CheckStockBatchResponse response = peer.findAvailableStocksBatch({{"01", 1}, {"15", 2}}, 1);
+    ASSERT_EQ(response.items.size(), 2u);
+    EXPECT_EQ(response.items[1].item_code, "15");
+    EXPECT_EQ(response.items[1].item_num, 3);
+}
+
+// 프레임 없이도 한 번의 recv보다 긴 통계 응답을 끝 필드까지 받는다
+TEST_F(OtherDVMNetworkTest, RequestStats_LegacyShouldReceiveResponseLongerThanOneRead) {
+    map<int64_t, int64_t> hours;
+    for (int i = 0; i < 600; ++i) {
+        hours[1700000000000 + i * 3600000LL] = i + 1;
+    }
+    string response = "msg_type:resp_stats;src_id:T2;dst_id:T1;sales:600;units:180300;revenue:9000;prepaid:3;"
+                      "hours:" + StatsField::formatHours(hours) + ";items:01=600/180300/9000;sources:4=3/2/1;" +
+                      string(SocketMessage::kEndField);
+    ASSERT_GT(response.size(), 4096u * 2);
+    startServer([response](const string &request) { return response; });
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", server->getPort());
+
+    SalesStats stats;
+    ASSERT_TRUE(peer.requestStats(SalesQuery{}, 1, stats));
+    EXPECT_EQ(stats.units_by_hour, hours);
+    EXPECT_EQ(stats.sales, 600);
+    EXPECT_EQ(stats.items["01"].units, 180300);
+    EXPECT_EQ(stats.sources[4].redeemed, 2);
+    EXPECT_EQ(peer.getIdleConnectionCount(), 1u);
+}
+
+// 합계 필드가 빠진 통계 응답은 실패로 처리한다
+TEST_F(OtherDVMNetworkTest, RequestStats_ShouldRejectIncompleteResponse) {
+    startServer([](const string &request) {
+        return "msg_type:resp_stats;src_id:T2;dst_id:T1;hours:;" + string(SocketMessage::kEndField);
+    });
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", server->getPort());
+
+    SalesStats stats;
+    EXPECT_FALSE(peer.requestStats(SalesQuery{}, 1, stats));
+}
+
+// 첫 요청에만 응답하고, 그 뒤에는 요청을 읽자마자 응답 없이 연결을 닫는 피어
+// (요청을 처리한 직후 멈춘 피어를 흉내 낸다)
+class ClosingPeer {
+public:
+    explicit ClosingPeer(string firstResponse) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        socklen_t length = sizeof(addr);
+        bind(listenFd, (sockaddr *)&addr, sizeof(addr));
+        listen(listenFd, 8);
+        getsockname(listenFd, (sockaddr *)&addr, &length);
+        port = ntohs(addr.sin_port);
+        worker = thread([this, firstResponse]() {
+            int conn;
+            while ((conn = accept(listenFd, nullptr, nullptr)) >= 0) {
+                char buffer[1024];
+                while (recv(conn, buffer, sizeof(buffer), 0) > 0) {
+                    if (++requests > 1) {
+                        break;
+                    }
+                    send(conn, firstResponse.data(), firstResponse.size(), MSG_NOSIGNAL);
+                }
+                close(conn);
+            }
+        });
+    }
+
+    ~ClosingPeer() {
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        worker.join();
+    }
+
+    int port = 0;
+    atomic<int> requests{0};
+
+private:
+    int listenFd;
+    thread worker;
+};
+
+// TC-PRE-001: 재사용한 연결에서 요청을 보낸 뒤 끊기면 선결제 요청은 다시 보내지 않는다
+TEST(OtherDVMRetryTest, AskForPrepayment_ShouldNotResendAfterRequestReachedPeer) {
+    ClosingPeer closing(MockSocketMessage::createPrepaymentResponse("01", 1, true));
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", closing.port);
+
+    EXPECT_TRUE(peer.askForPrepayment(askPrepaymentRequest{"01", 1, "abc12"}, 1).availability);
+    EXPECT_FALSE(peer.askForPrepayment(askPrepaymentRequest{"01", 1, "abc13"}, 1).availability);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    EXPECT_EQ(closing.requests.load(), 2);
+}
+
+// TC-COM-002: 재고 조회는 같은 상황에서 새 연결로 한 번 다시 보낸다
+TEST(OtherDVMRetryTest, FindAvailableStocks_ShouldResendOnceWhenReusedConnectionCloses) {
+    ClosingPeer closing(MockSocketMessage::createStockResponse("01", 2, 0, 0));
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", closing.port);
+
+    EXPECT_EQ(peer.findAvailableStocks(CheckStockRequest{"01", 2}, 1).item_num, 2);
+    EXPECT_EQ(peer.findAvailableStocks(CheckStockRequest{"01", 2}, 1).item_num, 0);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    EXPECT_EQ(closing.requests.load(), 3);
+}
+
+// TC-COM-002: 피어에 연결할 수 없으면 빈 응답을 반환한다
+TEST(OtherDVMUnreachableTest, FindAvailableStocks_ShouldReturnEmptyWhenUnreachable) {
+    OtherDVM peer(2, Location(0, 0), "127.0.0.1", 1);
+    CheckStockResponse response = peer.findAvailableStocks(CheckStockRequest{"01", 1}, 1);
+    EXPECT_EQ(response.item_num, 0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
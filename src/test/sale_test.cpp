@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "../app/application/sale.h"
+#include "../app/application/saleidgenerator.h"
 #include "../app/domain/item.h"
 #include "../app/domain/prepayment.h" // Prepayment 내부 로직 간접 테스트 위함
 #include "../app/dto.h"
@@ -7,6 +8,10 @@
 #include <utility> // std::pair
 #include <algorithm> // std::all_of
 #include <cctype> // ::isalnum
+#include <set>
+#include <thread>
+#include <atomic>
+#include <vector>
 
 using namespace std;
 
@@ -499,6 +504,107 @@ TEST_F(SaleTest, Scenario_VariousSaleCreations_ShouldVerifyCorrectly) {
     EXPECT_TRUE(sale2.receivePrepaidItem(code2)); // 다른 선결제 판매도 인증 가능
 }
 
+// 선결제 판매만 인증코드를 가진다
+TEST_F(SaleTest, GetCertCode_ShouldReturnCodeOnlyForPrepaidSales) {
+    Sale standalone_sale = Sale::createStandaloneSale(default_request);
+    Sale prepaid_sale = Sale::createSaleUsingCertCode(single_item_request, "CODE7");
+    EXPECT_EQ(standalone_sale.getCertCode(), "");
+    EXPECT_EQ(prepaid_sale.getCertCode(), "CODE7");
+    auto [dvm_sale, code] = Sale::createSaleForDvm(default_request, 2);
+    EXPECT_EQ(code.size(), 5u);
+}
+
+// 같은 초에 여러 스레드에서 만든 판매도 ID가 겹치지 않아야 한다
+TEST_F(SaleTest, SaleId_ShouldBeUniqueAcrossThreadsWithinSameSecond) {
+    SaleIdGenerator::setNodeId(7);
+    const int threads = 4;
+    const int perThread = 3000;
+    vector<vector<uint64_t>> ids(threads);
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&ids, t, this]() {
+            for (int i = 0; i < perThread; ++i) {
+                ids[t].push_back(Sale::createStandaloneSale(default_request).getSaleId());
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    set<uint64_t> unique;
+    for (const auto &perThreadIds : ids) {
+        // 한 스레드가 만든 ID는 증가한다
+        EXPECT_TRUE(is_sorted(perThreadIds.begin(), perThreadIds.end()));
+        unique.insert(perThreadIds.begin(), perThreadIds.end());
+    }
+    EXPECT_EQ(unique.size(), static_cast<size_t>(threads * perThread));
+    EXPECT_EQ(SaleIdGenerator::nodeOf(*unique.begin()), 7);
+}
+
+// 슬롯 수(32)보다 많은 스레드가 동시에 발급해도 공유 슬롯으로 넘겨 ID가 겹치지 않는다
+TEST_F(SaleTest, SaleId_ShouldBeUniqueWithMoreThreadsThanSlots) {
+    const int threads = 40;
+    const int perThread = 500;
+    vector<vector<uint64_t>> ids(threads);
+    atomic<int> ready{0};
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&ids, &ready, t]() {
+            ids[t].push_back(SaleIdGenerator::next());
+            // 모든 스레드가 슬롯을 잡은 뒤에 발급을 이어간다
+            ready++;
+            while (ready.load() < threads) {
+                this_thread::yield();
+            }
+            for (int i = 1; i < perThread; ++i) {
+                ids[t].push_back(SaleIdGenerator::next());
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    set<uint64_t> unique;
+    set<uint32_t> slots;
+    for (const auto &perThreadIds : ids) {
+        EXPECT_TRUE(is_sorted(perThreadIds.begin(), perThreadIds.end()));
+        unique.insert(perThreadIds.begin(), perThreadIds.end());
+        slots.insert(SaleIdGenerator::slotOf(perThreadIds.front()));
+    }
+    EXPECT_EQ(unique.size(), static_cast<size_t>(threads * perThread));
+    EXPECT_TRUE(slots.count(SaleIdGenerator::kSharedSlot));
+}
+
+// 끝난 스레드의 슬롯을 다음 스레드가 이어서 써도 같은 ms 안의 ID가 겹치지 않는다
+TEST_F(SaleTest, SaleId_ShouldNotRepeatWhenSlotsAreRecycled) {
+    set<uint64_t> unique;
+    const int threads = 100;
+    for (int t = 0; t < threads; ++t) {
+        thread([&unique]() {
+            for (int i = 0; i < 3; ++i) {
+                unique.insert(SaleIdGenerator::next());
+            }
+        }).join();
+    }
+    EXPECT_EQ(unique.size(), static_cast<size_t>(threads * 3));
+}
+
+TEST_F(SaleTest, CreatedAt_ShouldBeRawTimestampFormattedOnDemand) {
+    int64_t before = SaleIdGenerator::nowMs();
+    Sale sale = Sale::createStandaloneSale(default_request);
+    int64_t after = SaleIdGenerator::nowMs();
+    EXPECT_GE(sale.getCreatedAtMs(), before);
+    EXPECT_LE(sale.getCreatedAtMs(), after);
+    EXPECT_GE(SaleIdGenerator::timestampOf(sale.getSaleId()), before);
+
+    Sale copy = sale;
+    EXPECT_EQ(copy.getSaleId(), sale.getSaleId());
+    EXPECT_EQ(SaleIdGenerator::formatId(42), "SALE_42");
+    EXPECT_EQ(SaleIdGenerator::formatTimestamp(sale.getCreatedAtMs()).size(), 19u);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
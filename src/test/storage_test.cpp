@@ -0,0 +1,461 @@
+#include "gtest/gtest.h"
+#include "../app/storage/writeaheadlog.h"
+#include "../app/storage/snapshot.h"
+#include "../app/storage/salessegment.h"
+#include "../app/application/saleidgenerator.h"
+#include "../app/application/salesanalytics.h"
+#include "../app/application/dvm.h"
+#include "../app/domain/item.h"
+#include "../app/domain/location.h"
+#include "../app/dto.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+
+using namespace std;
+
+// 테스트마다 다른 임시 로그 파일을 쓰고 끝나면 지우는 fixture
+class StorageTest : public ::testing::Test {
+protected:
+    string walPath;
+    string snapshotPath;
+    string historyDir;
+
+    void SetUp() override {
+        string base = "/tmp/dvm_" + string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + "_" +
+                      to_string(getpid());
+        walPath = base + ".wal";
+        snapshotPath = base + ".snap";
+        historyDir = base + "_history";
+        remove(walPath.c_str());
+        remove(snapshotPath.c_str());
+        filesystem::remove_all(historyDir);
+    }
+
+    void TearDown() override {
+        Config::get().walPath.clear();
+        Config::get().snapshotPath.clear();
+        Config::get().walSync = true;
+        remove(walPath.c_str());
+        remove(snapshotPath.c_str());
+        filesystem::remove_all(historyDir);
+    }
+
+    // 읽은 기록을 (종류, 아이템 코드, 인증코드, 수량) 문자열로 모은다
+    vector<string> readRecords(size_t *validSize = nullptr) {
+        vector<string> records;
+        size_t size = WriteAheadLog::readAll(walPath, [&records](const WalRecord &record) {
+            records.push_back(to_string((int)record.type) + ":" + string(record.itemCode) + ":" +
+                              string(record.certCode) + ":" + to_string(record.count));
+        });
+        if (validSize) {
+            *validSize = size;
+        }
+        return records;
+    }
+};
+
+TEST_F(StorageTest, AppendAndCommit_ShouldRoundTripEveryRecordType) {
+    {
+        WriteAheadLog wal(walPath, false);
+        ASSERT_TRUE(wal.open());
+        wal.append(WalRecord::order(42, 1700000000000, "01", 2, 3000, 0));
+        wal.append(WalRecord::prepaidSaved(43, 1700000000001, "04", 1, 1500, "aB3xZ", 0));
+        wal.append(WalRecord::prepaidRedeemed("aB3xZ"));
+        wal.append(WalRecord::restock("01", 10));
+        uint64_t last = wal.append(WalRecord::certExpired("QQQQQ"));
+        EXPECT_TRUE(wal.commit(last));
+    }
+
+    uint64_t saleId = 0;
+    int amount = 0;
+    WriteAheadLog::readAll(walPath, [&](const WalRecord &record) {
+        if (record.type == WalRecordType::Order) {
+            saleId = record.saleId;
+            amount = record.amount;
+        }
+    });
+    EXPECT_EQ(saleId, 42u);
+    EXPECT_EQ(amount, 3000);
+    EXPECT_EQ(readRecords(), (vector<string>{"1:01::2", "2:04:aB3xZ:1", "3::aB3xZ:0", "4:01::10", "5::QQQQQ:0"}));
+}
+
+TEST_F(StorageTest, Open_ShouldDropTornTailAndKeepAppending) {
+    {
+        WriteAheadLog wal(walPath, false);
+        ASSERT_TRUE(wal.open());
+        wal.commit(wal.append(WalRecord::restock("01", 1)));
+    }
+    size_t validSize = 0;
+    readRecords(&validSize);
+    {
+        // 기록 도중 전원이 꺼진 것처럼 헤더 일부만 남긴다
+        ofstream torn(walPath, ios::binary | ios::app);
+        torn.write("\x20\x00\x00", 3);
+    }
+    EXPECT_EQ(readRecords().size(), 1u);
+
+    {
+        WriteAheadLog wal(walPath, false);
+        ASSERT_TRUE(wal.open());
+        wal.commit(wal.append(WalRecord::restock("02", 2)));
+    }
+    EXPECT_EQ(readRecords(), (vector<string>{"4:01::1", "4:02::2"}));
+}
+
+TEST_F(StorageTest, DiscardBefore_ShouldKeepOffsetsOfRemainingRecords) {
+    uint64_t kept;
+    {
+        WriteAheadLog wal(walPath, false);
+        ASSERT_TRUE(wal.open());
+        wal.append(WalRecord::restock("01", 1));
+        wal.append(WalRecord::restock("02", 2));
+        kept = wal.getAppendedBytes();
+        // 아직 내보내지 않은 기록이 있어도 먼저 내보낸 뒤 옮긴다
+        wal.append(WalRecord::restock("03", 3));
+        ASSERT_TRUE(wal.discardBefore(kept));
+        EXPECT_FALSE(wal.discardBefore(kept));
+        wal.commit(wal.append(WalRecord::restock("04", 4)));
+    }
+    size_t validSize = 0;
+    EXPECT_EQ(readRecords(&validSize), (vector<string>{"4:03::3", "4:04::4"}));
+
+    // 버리기 전에 얻은 위치로 읽어도 같은 기록을 가리키고, 다시 열면 논리 위치를 이어 간다
+    vector<string> tail;
+    EXPECT_EQ(WriteAheadLog::readAll(walPath, [&tail](const WalRecord &record) {
+        tail.push_back(string(record.itemCode));
+    }, kept), validSize);
+    EXPECT_EQ(tail, (vector<string>{"03", "04"}));
+    WriteAheadLog reopened(walPath, false);
+    ASSERT_TRUE(reopened.open(validSize));
+    EXPECT_EQ(reopened.getAppendedBytes(), validSize);
+    EXPECT_LT(filesystem::file_size(walPath), validSize);
+}
+
+TEST_F(StorageTest, DiscardBefore_ShouldKeepRecordsAppendedWhileCopying) {
+    const int before = 20000;
+    const int during = 2000;
+    uint64_t kept;
+    {
+        WriteAheadLog wal(walPath, false);
+        ASSERT_TRUE(wal.open());
+        for (int i = 0; i < before; ++i) {
+            wal.append(WalRecord::restock("01", i));
+            if (i == before / 2 - 1) {
+                kept = wal.getAppendedBytes();
+            }
+        }
+        // 옮기는 동안에도 다른 스레드의 append와 commit이 계속된다
+        thread writer([&wal]() {
+            for (int i = 0; i < during; ++i) {
+                EXPECT_TRUE(wal.commit(wal.append(WalRecord::restock("02", i))));
+            }
+        });
+        EXPECT_TRUE(wal.discardBefore(kept));
+        writer.join();
+    }
+    vector<string> records = readRecords();
+    ASSERT_EQ(records.size(), (size_t)(before / 2 + during));
+    EXPECT_EQ(records.front(), "4:01::" + to_string(before / 2));
+    EXPECT_EQ(records[before / 2 - 1], "4:01::" + to_string(before - 1));
+    EXPECT_EQ(records.back(), "4:02::" + to_string(during - 1));
+}
+
+TEST_F(StorageTest, Commit_ConcurrentWritersShouldShareSyncs) {
+    const int threads = 8;
+    const int perThread = 100;
+    WriteAheadLog wal(walPath, true);
+    ASSERT_TRUE(wal.open());
+    vector<thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&wal]() {
+            for (int i = 0; i < perThread; ++i) {
+                EXPECT_TRUE(wal.commit(wal.append(WalRecord::restock("01", 1))));
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+
+    EXPECT_EQ(readRecords().size(), (size_t)(threads * perThread));
+    // 기다리는 동안 쌓인 다른 스레드의 기록을 함께 내보낸다
+    EXPECT_LT(wal.getSyncCount(), (uint64_t)(threads * perThread));
+}
+
+TEST_F(StorageTest, DVM_ShouldLogEveryStockAndSaleChange) {
+    Config::get().walPath = walPath;
+    Config::get().walSync = false;
+    Item coke("01", "콜라", 1000);
+    {
+        DVM dvm(1, Location(0, 0), {{coke, 5}}, {coke}, {}, {});
+        dvm.requestOrder(SaleRequest{"01", 2, coke});
+        dvm.saveSaleFromOther("01", 1, "KEEP1");
+        EXPECT_TRUE(dvm.processPrepaidItem("KEEP1"));
+        EXPECT_FALSE(dvm.processPrepaidItem("KEEP1"));
+        dvm.restock("01", 3);
+        EXPECT_THROW(dvm.requestOrder(SaleRequest{"01", 100, coke}), runtime_error);
+    }
+    Config::get().walSync = true;
+
+    // 실패한 주문과 없는 코드의 수령은 기록하지 않는다
+    EXPECT_EQ(readRecords(), (vector<string>{"1:01::2", "2:01:KEEP1:1", "3::KEEP1:0", "4:01::3"}));
+}
+
+TEST_F(StorageTest, Snapshot_ShouldRoundTripAndRejectCorruption) {
+    SnapshotData data;
+    data.walOffset = 123;
+    SnapshotFormat::StockEntry stock{};
+    SnapshotFormat::setText(stock.code, "01");
+    stock.count = 7;
+    data.stocks.push_back(stock);
+    SnapshotFormat::SaleEntry sale{};
+    sale.saleId = 99;
+    sale.amount = 2000;
+    data.sales.push_back(sale);
+    ASSERT_TRUE(MappedSnapshot::write(snapshotPath, data));
+
+    {
+        MappedSnapshot snapshot;
+        ASSERT_TRUE(snapshot.open(snapshotPath));
+        EXPECT_EQ(snapshot.header().walOffset, 123u);
+        ASSERT_EQ(snapshot.header().stockCount, 1u);
+        EXPECT_EQ(SnapshotFormat::getText(snapshot.stocks()[0].code), "01");
+        EXPECT_EQ(snapshot.stocks()[0].count, 7);
+        ASSERT_EQ(snapshot.header().saleCount, 1u);
+        EXPECT_EQ(snapshot.sales()[0].saleId, 99u);
+    }
+
+    {
+        fstream file(snapshotPath, ios::binary | ios::in | ios::out);
+        file.seekp(-1, ios::end);
+        file.put('\x7f');
+    }
+    MappedSnapshot corrupted;
+    EXPECT_FALSE(corrupted.open(snapshotPath));
+    EXPECT_FALSE(MappedSnapshot().open(snapshotPath + ".missing"));
+}
+
+TEST_F(StorageTest, Recovery_ShouldLoadSnapshotAndReplayOnlyLogTail) {
+    Config::get().walPath = walPath;
+    Config::get().snapshotPath = snapshotPath;
+    Config::get().walSync = false;
+    Item coke("01", "콜라", 1000);
+    Item tea("04", "홍차", 1500);
+    const int ordersBeforeSnapshot = 20000;
+    {
+        DVM dvm(1, Location(0, 0), {{coke, 50000}, {tea, 10}}, {coke, tea}, {}, {});
+        for (int i = 0; i < ordersBeforeSnapshot; ++i) {
+            dvm.requestOrder(SaleRequest{"01", 1, coke});
+        }
+        dvm.saveSaleFromOther("04", 2, "SNAP1");
+        dvm.saveSaleFromOther("04", 1, "USED1");
+        ASSERT_TRUE(dvm.writeSnapshot());
+
+        // 스냅샷 이후의 변경은 로그에만 남는다
+        EXPECT_TRUE(dvm.processPrepaidItem("USED1"));
+        dvm.saveSaleFromOther("04", 3, "TAIL1");
+        dvm.restock("01", 5);
+        dvm.requestOrder(SaleRequest{"01", 2, coke});
+    }
+
+    auto begin = chrono::steady_clock::now();
+    DVM recovered(1, Location(0, 0), {{coke, 50000}, {tea, 10}}, {coke, tea}, {}, {});
+    auto elapsed = chrono::steady_clock::now() - begin;
+
+    EXPECT_EQ(recovered.getStocks().at(coke), 50000 - ordersBeforeSnapshot + 5 - 2);
+    EXPECT_EQ(recovered.getStocks().at(tea), 10 - 2 - 1 - 3);
+    EXPECT_EQ(recovered.getSaleCount(), (size_t)ordersBeforeSnapshot + 4);
+    EXPECT_TRUE(recovered.getCertCodes().contains("SNAP1"));
+    EXPECT_TRUE(recovered.getCertCodes().contains("TAIL1"));
+    EXPECT_FALSE(recovered.processPrepaidItem("USED1"));
+    EXPECT_TRUE(recovered.processPrepaidItem("SNAP1"));
+    EXPECT_LT(elapsed, chrono::milliseconds(1000));
+    // 스냅샷에 반영된 로그는 버려지고 스냅샷 이후의 기록(복구 뒤의 수령 포함)만 남는다
+    EXPECT_EQ(readRecords().size(), 5u);
+}
+
+TEST_F(StorageTest, Recovery_WithoutSnapshotShouldReplayWholeLog) {
+    Config::get().walPath = walPath;
+    Config::get().walSync = false;
+    Item coke("01", "콜라", 1000);
+    {
+        DVM dvm(1, Location(0, 0), {{coke, 10}}, {coke}, {}, {});
+        dvm.requestOrder(SaleRequest{"01", 4, coke});
+        dvm.saveSaleFromOther("01", 1, "KEEP1");
+    }
+
+    DVM recovered(1, Location(0, 0), {{coke, 10}}, {coke}, {}, {});
+    EXPECT_EQ(recovered.getStocks().at(coke), 5);
+    EXPECT_EQ(recovered.getSaleCount(), 2u);
+    EXPECT_THROW(recovered.saveSaleFromOther("01", 1, "KEEP1"), DuplicateCertCodeException);
+}
+
+TEST_F(StorageTest, SalesSegment_ShouldRoundTripColumnsAndRejectCorruption) {
+    const int64_t day = SalesSegment::dayStart(1700000000000);
+    EXPECT_EQ(SalesSegment::fileName(day), "sales-20231114.col");
+    EXPECT_EQ(day % SalesSegmentFormat::kDayMs, 0);
+    EXPECT_EQ(SalesSegment::dayStart(day + SalesSegmentFormat::kDayMs - 1), day);
+
+    SalesSegmentData data;
+    data.dayStartMs = day;
+    data.items.resize(2);
+    SnapshotFormat::setText(data.items[0].code, "01");
+    SnapshotFormat::setText(data.items[1].code, "04");
+    // 시각 순이 아닌 행은 쓰기 전에 정렬한다
+    const int64_t times[] = {day + 300, day + 100, day + 200};
+    for (int i = 0; i < 3; ++i) {
+        data.saleIds.push_back(10 + i);
+        data.timestamps.push_back(times[i]);
+        data.itemIndexes.push_back(i == 2 ? 1 : 0);
+        data.counts.push_back(i + 1);
+        data.amounts.push_back((i + 1) * 1000);
+        data.flags.push_back(i == 2 ? SalesLedger::FlagPrepaid : 0);
+        data.sourceDvms.push_back(i == 2 ? 3 : 1);
+    }
+    data.sortByTime();
+    string path = historyDir + ".col";
+    ASSERT_TRUE(SalesSegment::write(path, data));
+
+    SalesSegment segment;
+    ASSERT_TRUE(segment.open(path));
+    ASSERT_EQ(segment.size(), 3u);
+    EXPECT_EQ(segment.header().dayStartMs, day);
+    EXPECT_EQ(segment.header().itemCount, 2u);
+    EXPECT_EQ(SnapshotFormat::getText(segment.items()[1].code), "04");
+    EXPECT_EQ(vector<uint64_t>(segment.saleIds(), segment.saleIds() + 3), (vector<uint64_t>{11, 12, 10}));
+    EXPECT_EQ(vector<int64_t>(segment.timestamps(), segment.timestamps() + 3),
+              (vector<int64_t>{day + 100, day + 200, day + 300}));
+    EXPECT_EQ(vector<int32_t>(segment.counts(), segment.counts() + 3), (vector<int32_t>{2, 3, 1}));
+    EXPECT_EQ(vector<int32_t>(segment.amounts(), segment.amounts() + 3), (vector<int32_t>{2000, 3000, 1000}));
+    EXPECT_EQ(segment.itemIndexes()[1], 1);
+    EXPECT_EQ(segment.flags()[1], SalesLedger::FlagPrepaid);
+    EXPECT_EQ(segment.sourceDvms()[1], 3);
+    // 열은 8바이트 경계에서 시작하므로 그대로 배열로 읽을 수 있다
+    for (uint64_t offset : segment.header().columnOffsets) {
+        EXPECT_EQ(offset % 8, 0u);
+    }
+
+    {
+        fstream file(path, ios::in | ios::out | ios::binary);
+        file.seekp(-1, ios::end);
+        file.put('\x7f');
+    }
+    SalesSegment corrupted;
+    EXPECT_FALSE(corrupted.open(path));
+    EXPECT_FALSE(SalesSegment().open(path + ".missing"));
+    remove(path.c_str());
+}
+
+TEST_F(StorageTest, ExportSalesHistory_ShouldWriteOneSegmentPerDayWithSource) {
+    const int64_t today = SalesSegment::dayStart(SaleIdGenerator::nowMs());
+    const int64_t yesterday = today - SalesSegmentFormat::kDayMs;
+    {
+        // 어제 받은 판매가 로그에 남아 있는 상태에서 시작한다
+        WriteAheadLog wal(walPath, false);
+        ASSERT_TRUE(wal.open());
+        wal.append(WalRecord::order(1, yesterday + 5000, "01", 2, 2000, 1));
+        uint64_t last = wal.append(WalRecord::prepaidSaved(2, yesterday + 1000, "04", 1, 1500, "OLD01", 3));
+        ASSERT_TRUE(wal.commit(last));
+    }
+    Config::get().walPath = walPath;
+    Config::get().walSync = false;
+    Item coke("01", "콜라", 1000);
+    Item tea("04", "홍차", 1500);
+    DVM dvm(1, Location(0, 0), {{coke, 10}, {tea, 10}}, {coke, tea}, {}, {});
+    dvm.requestOrder(SaleRequest{"01", 1, coke});
+    dvm.saveSaleFromOther("04", 2, "NEW01", 7);
+
+    EXPECT_EQ(dvm.exportSalesHistory(historyDir), 2);
+
+    SalesSegment old;
+    ASSERT_TRUE(old.open(historyDir + "/" + SalesSegment::fileName(yesterday)));
+    ASSERT_EQ(old.size(), 2u);
+    EXPECT_EQ(old.saleIds()[0], 2u);
+    EXPECT_EQ(old.flags()[0], SalesLedger::FlagPrepaid);
+    EXPECT_EQ(old.sourceDvms()[0], 3);
+    EXPECT_EQ(SnapshotFormat::getText(old.items()[old.itemIndexes()[0]].code), "04");
+    EXPECT_EQ(old.sourceDvms()[1], 1);
+
+    SalesSegment current;
+    ASSERT_TRUE(current.open(historyDir + "/" + SalesSegment::fileName(today)));
+    ASSERT_EQ(current.size(), 2u);
+    EXPECT_EQ(current.flags()[0], 0);
+    EXPECT_EQ(current.sourceDvms()[0], 1);
+    EXPECT_EQ(current.flags()[1], SalesLedger::FlagPrepaid);
+    EXPECT_EQ(current.sourceDvms()[1], 7);
+    EXPECT_EQ(current.amounts()[1], 3000);
+
+    // 새 판매가 없으면 아무것도 쓰지 않고, 새 판매가 있으면 그날의 파일만 다시 쓴다
+    EXPECT_EQ(dvm.exportSalesHistory(historyDir), 0);
+    dvm.requestOrder(SaleRequest{"01", 3, coke});
+    EXPECT_EQ(dvm.exportSalesHistory(historyDir), 1);
+    SalesSegment updated;
+    ASSERT_TRUE(updated.open(historyDir + "/" + SalesSegment::fileName(today)));
+    EXPECT_EQ(updated.size(), 3u);
+    EXPECT_EQ(updated.counts()[2], 3);
+
+    // 새 판매가 없어도 내보낸 선결제가 수령되면 그 판매의 날을 다시 쓴다
+    EXPECT_TRUE(dvm.processPrepaidItem("NEW01"));
+    EXPECT_EQ(dvm.exportSalesHistory(historyDir), 1);
+    SalesSegment received;
+    ASSERT_TRUE(received.open(historyDir + "/" + SalesSegment::fileName(today)));
+    EXPECT_EQ(received.flags()[1], SalesLedger::FlagPrepaid | SalesLedger::FlagReceived);
+    EXPECT_EQ(dvm.exportSalesHistory(historyDir), 0);
+}
+
+TEST_F(StorageTest, Recovery_ShouldKeepPrepaidSalesLinkedToTheirCodes) {
+    Config::get().walPath = walPath;
+    Config::get().snapshotPath = snapshotPath;
+    Config::get().walSync = false;
+    Item tea("04", "홍차", 1500);
+    {
+        DVM dvm(1, Location(0, 0), {{tea, 10}}, {tea}, {}, {});
+        dvm.saveSaleFromOther("04", 1, "SNAP1", 2);
+        ASSERT_TRUE(dvm.writeSnapshot());
+        dvm.saveSaleFromOther("04", 1, "TAIL1", 3);
+    }
+
+    // 스냅샷에서 읽은 판매와 로그에서 다시 적용한 판매 모두 수령이 판매 기록에 남는다
+    DVM recovered(1, Location(0, 0), {{tea, 10}}, {tea}, {}, {});
+    EXPECT_TRUE(recovered.processPrepaidItem("SNAP1"));
+    EXPECT_TRUE(recovered.processPrepaidItem("TAIL1"));
+    SalesStats stats = recovered.querySales(SalesQuery{});
+    EXPECT_EQ(stats.sources[2].redeemed, 1);
+    EXPECT_EQ(stats.sources[3].redeemed, 1);
+}
+
+TEST_F(StorageTest, QuerySegments_ShouldMatchLedgerStatsAndSkipOtherDays) {
+    Config::get().walPath.clear();
+    Item coke("01", "콜라", 1000);
+    Item tea("04", "홍차", 1500);
+    DVM dvm(1, Location(0, 0), {{coke, 100}, {tea, 100}}, {coke, tea}, {}, {});
+    for (int i = 0; i < 30; ++i) {
+        dvm.requestOrder(SaleRequest{i % 3 ? "01" : "04", 1 + i % 2, i % 3 ? coke : tea});
+    }
+    dvm.saveSaleFromOther("04", 2, "SEG01", 5);
+    ASSERT_EQ(dvm.exportSalesHistory(historyDir), 1);
+
+    vector<string> paths;
+    for (const auto &entry : filesystem::directory_iterator(historyDir)) {
+        paths.push_back(entry.path().string());
+    }
+    paths.push_back(historyDir + "/sales-missing.col");
+    SalesStats fromFiles = SalesAnalytics::querySegments(paths, SalesQuery{}, 2);
+    SalesStats fromLedger = dvm.querySales(SalesQuery{});
+    EXPECT_EQ(fromFiles.sales, 31);
+    EXPECT_EQ(fromFiles.revenue, fromLedger.revenue);
+    EXPECT_EQ(fromFiles.units_by_hour, fromLedger.units_by_hour);
+    EXPECT_EQ(fromFiles.items["04"].units, fromLedger.items["04"].units);
+    EXPECT_EQ(fromFiles.sources[5].prepaid, 1);
+
+    SalesQuery tomorrow;
+    tomorrow.from_ms = SalesSegment::dayStart(SaleIdGenerator::nowMs()) + SalesSegmentFormat::kDayMs;
+    EXPECT_EQ(SalesAnalytics::querySegments(paths, tomorrow).sales, 0);
+}